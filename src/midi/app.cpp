@@ -1,4 +1,4 @@
-#ifndef TEST_BUILD
+#if !defined(TEST_BUILD) && !defined(BENCHMARK_BUILD)
 
 #include <iostream>
 #include <fstream>
@@ -6,30 +6,37 @@
 #include <algorithm>
 #include <iomanip>
 #include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <system_error>
 #include "shell/command-line-parser.h"
 #include "imaging/bitmap.h"
 #include "imaging/bmp-format.h"
 #include "imaging/bmp-format.h"
+#include "logging.h"
 #include "midi/midi.h"
+#include "midi/combinators.h"
+#include "midi/event-reader.h"
+#include "midi/note-cache.h"
+#include "midi/note-index.h"
+#include "midi/note-statistics.h"
+#include "midi/note-table.h"
+#include "midi/tempo-map.h"
+#include "io/mapped-file.h"
+#include "io/parse-error.h"
+#include "util/parallel.h"
+#include "util/work-stealing-pool.h"
 
 using namespace imaging;
 using namespace shell;
 using namespace midi;
 using namespace std;
 
-int getWidth(vector<NOTE>& notes)
-{
-	int res = 0;
-	for (NOTE n : notes)
-	{
-		if (value(n.start + n.duration) > res)
-		{
-			res = value(n.start + n.duration);
-		}
-	}
-	return res;
-}
-
 void draw_rectangle(Bitmap& bitmap,
 	const Position& pos,
 	const uint32_t& width,
@@ -45,26 +52,466 @@ void draw_rectangle(Bitmap& bitmap,
 	}
 }
 
-int getMinNoteNumber(vector<NOTE>& notes) {
-	int res = 128;
-	for (NOTE note : notes)
+struct RENDER_SETTINGS
+{
+	uint32_t frame_width;
+	uint32_t step;
+	uint32_t scale;
+	uint32_t height_of_note;
+	// Frames per second of real time; 0 moves every frame step pixels regardless of tempo
+	uint32_t fps;
+};
+
+void render_frames(const NoteTable& notes, const TempoMap& tempo_map, RENDER_SETTINGS settings, const string& outfile, bool show_progress)
+{
+	uint32_t frame_width = settings.frame_width;
+	uint32_t step = settings.step;
+	uint32_t scale = settings.scale;
+	uint32_t height_of_note = settings.height_of_note;
+
+	uint32_t bitmapwidth = end_time(notes) / scale;
+
+	// Frames wider than the piece are clipped to a single frame of the whole piece
+	if (frame_width == 0 || frame_width > bitmapwidth) {
+		frame_width = bitmapwidth;
+	}
+	if (frame_width == 0) {
+		return;
+	}
+
+	uint16_t highest_note = midi::highest_note(notes);
+	uint16_t lowest_note = midi::lowest_note(notes);
+	uint32_t frame_height = (highest_note - lowest_note + 1)*height_of_note;
+
+	// Frames are drawn one by one from the notes on screen, found through the index
+	NoteIndex index(notes);
+	vector<size_t> visible;
+
+	// Left edge of the last frame
+	uint32_t last_left = bitmapwidth - frame_width;
+	auto render_frame = [&](uint64_t k, uint32_t left)
+	{
+		if (show_progress) {
+			int percent = last_left == 0 ? 100 : (int)ceil(((float)left / last_left) * 100);
+			std::cout << "generated frame " + std::to_string(k) + " (" + std::to_string(percent) + "%)" << endl;
+		}
+		uint32_t right = left + frame_width;
+		Bitmap newBitmap(frame_width, frame_height);
+		visible.clear();
+		index.overlapping(Time(uint64_t(left) * scale), Time(uint64_t(right) * scale), visible);
+		for (size_t i : visible) {
+			uint32_t from = uint32_t(notes.start[i] / scale);
+			uint32_t to = from + uint32_t(notes.duration[i] / scale);
+			from = std::max(from, left);
+			to = std::min(to, right);
+			if (from < to) {
+				draw_rectangle(newBitmap,
+					Position(from - left, (highest_note - notes.note_number[i])*height_of_note),
+					to - from,
+					height_of_note, Color(1, 0, 0));
+			}
+		}
+		string temp = outfile;
+		string out = temp.replace(temp.find("%d"), std::string("%d").size(), to_string(k));
+		save_as_bmp(out, newBitmap);
+	};
+
+	if (settings.fps == 0) {
+		uint64_t k = 0;
+		for (uint64_t left = 0; left <= last_left; left += step) {
+			render_frame(k++, uint32_t(left));
+		}
+	}
+	else {
+		for (uint64_t k = 0;; k++) {
+			uint64_t left = value(tempo_map.time_at(k * 1e6 / settings.fps)) / scale;
+			if (left > last_left) {
+				break;
+			}
+			render_frame(k, uint32_t(left));
+		}
+	}
+}
+
+bool is_midi_file(const std::filesystem::path& path)
+{
+	string extension = path.extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return char(::tolower(c)); });
+	return extension == ".mid" || extension == ".midi";
+}
+
+// A file, or a track within a file, that the batch skipped
+struct BATCH_FAILURE
+{
+	string file;
+	// Number of the skipped track, -1 if the whole file was skipped
+	int track;
+	// Position of a parse error, -1 for other errors
+	int64_t offset;
+	string reason;
+};
+
+struct BATCH_TOTALS
+{
+	std::atomic<uint64_t> files{ 0 };
+	std::atomic<uint64_t> failed{ 0 };
+	std::atomic<uint64_t> skipped_tracks{ 0 };
+	std::atomic<uint64_t> cached{ 0 };
+	std::atomic<uint64_t> bytes{ 0 };
+	std::atomic<uint64_t> events{ 0 };
+	std::atomic<uint64_t> notes{ 0 };
+
+	std::mutex failures_mutex;
+	vector<BATCH_FAILURE> failures;
+
+	void record_failure(const string& file, int track, const std::exception& e)
+	{
+		BATCH_FAILURE failure = { file, track, -1, e.what() };
+		if (const io::ParseError* parse_error = dynamic_cast<const io::ParseError*>(&e)) {
+			failure.offset = int64_t(parse_error->offset());
+			failure.reason = parse_error->reason();
+		}
+
+		std::lock_guard<std::mutex> lock(failures_mutex);
+		failures.push_back(failure);
+	}
+};
+
+// A file of the batch and where its frames go, relative to the output directory
+struct BATCH_FILE
+{
+	string path;
+	string output;
+};
+
+// Files found in a directory keep their path below it, others are named after the file alone.
+// Names already taken, e.g. by song.mid from another directory, get a numbered suffix
+void assign_outputs(vector<BATCH_FILE>& files)
+{
+	// Compared without case, for file systems that ignore it
+	std::set<string> taken;
+	for (BATCH_FILE& file : files)
+	{
+		string output = file.output;
+		for (int n = 2; ; n++)
+		{
+			string key = output;
+			std::transform(key.begin(), key.end(), key.begin(), [](char c) { return char(::tolower(c)); });
+			if (taken.insert(key).second) {
+				break;
+			}
+			output = file.output + "-" + std::to_string(n);
+		}
+		file.output = output;
+	}
+}
+
+// Arguments are directories (searched recursively for .mid files), MIDI files,
+// or text files listing one path per line. Arguments that cannot be read are recorded as failures
+vector<BATCH_FILE> collect_batch_files(const vector<string>& arguments, BATCH_TOTALS& totals)
+{
+	namespace fs = std::filesystem;
+	vector<BATCH_FILE> files;
+
+	for (const string& argument : arguments)
 	{
-		if (value(note.note_number) < res) {
-			res = value(note.note_number);
+		try {
+			if (fs::is_directory(argument)) {
+				for (const fs::directory_entry& entry : fs::recursive_directory_iterator(argument)) {
+					if (entry.is_regular_file() && is_midi_file(entry.path())) {
+						fs::path output = entry.path().lexically_relative(argument).replace_extension();
+						files.push_back(BATCH_FILE{ entry.path().string(), output.string() });
+					}
+				}
+			}
+			else if (is_midi_file(argument)) {
+				files.push_back(BATCH_FILE{ argument, fs::path(argument).stem().string() });
+			}
+			else {
+				ifstream list(argument);
+				if (!list.good()) {
+					throw std::runtime_error("cannot open file list");
+				}
+				string line;
+				while (getline(list, line)) {
+					line.erase(line.find_last_not_of(" \t\r") + 1);
+					if (!line.empty()) {
+						files.push_back(BATCH_FILE{ line, fs::path(line).stem().string() });
+					}
+				}
+			}
+		}
+		catch (const std::exception& e) {
+			++totals.failed;
+			totals.record_failure(argument, -1, e);
 		}
 	}
-	return res;
+
+	assign_outputs(files);
+	return files;
 }
 
-int getMaxNoteNumber(vector<NOTE>& notes) {
-	int res = 0;
-	for (NOTE note : notes)
+// Reads the tracks one by one, bounded by their chunks, so that reading resumes after a malformed one.
+// A track cut off by the end of the file is skipped as well. Returns false if a track was skipped
+// or the file was cut short, i.e. if the notes differ from those of read_notes in ChunkMode::bounded
+bool read_batch_tracks(const string& file, const io::Cursor& cursor, NoteTable& notes, TempoMap& tempo_map, uint64_t& events, BATCH_TOTALS& totals)
+{
+	CHUNK_INDEX index = index_chunks(cursor, true);
+	uint64_t mtrk_bytes = 0;
+	for (const CHUNK_INFO& track : index.tracks) {
+		mtrk_bytes += track.header.size;
+	}
+	bool complete = !index.truncated;
+	if (index.truncated && is_mtrk(index.truncated->header)) {
+		size_t left = cursor.at(index.truncated->offset).remaining() - sizeof(RAW_CHUNK_HEADER);
+		io::ParseError error(index.truncated->offset, "MTrk chunk of " + std::to_string(index.truncated->header.size) + " bytes exceeds the " + std::to_string(left) + " bytes left");
+		++totals.skipped_tracks;
+		totals.record_failure(file, int(index.tracks.size()), error);
+	}
+
+	notes.clear();
+	notes.reserve(estimate_note_count(mtrk_bytes));
+	vector<TEMPO_CHANGE> changes;
+	for (size_t i = 0; i < index.tracks.size(); i++)
 	{
-		if (value(note.note_number) > res) {
-			res = value(note.note_number);
+		size_t track_notes = notes.size();
+		size_t track_changes = changes.size();
+		EventCounter counter;
+		auto receiver = tee(counter, collect_notes(notes.appender()), TempoRecorder(changes));
+		io::Cursor track = cursor.at(index.tracks[i].offset);
+		try {
+			read_mtrk(track, receiver, ChunkMode::bounded);
+			events += counter.count;
 		}
+		catch (const io::ParseError& e) {
+			// Drop what the track yielded before the error
+			notes.resize(track_notes);
+			changes.erase(changes.begin() + track_changes, changes.end());
+			++totals.skipped_tracks;
+			totals.record_failure(file, int(i), e);
+			complete = false;
+		}
+	}
+	tempo_map = TempoMap(index.mthd.division, std::move(changes));
+	return complete;
+}
+
+void process_batch_file(const BATCH_FILE& batch_file, const string& outdir, RENDER_SETTINGS settings, const NoteCache* cache, BATCH_TOTALS& totals)
+{
+	const string& file = batch_file.path;
+	io::MappedFile in(file);
+	io::Cursor cursor = in.cursor();
+
+	// Each worker reuses its memory for the notes from one file to the next
+	thread_local NoteTable notes;
+	TempoMap tempo_map;
+	uint64_t events = 0;
+	// Hashed once for both the lookup and the store on a miss
+	uint64_t hash = cache != nullptr ? content_hash(cursor.position(), cursor.remaining()) : 0;
+	// Complete files read as read_notes does in bounded mode, so their entries are shared with it
+	if (cache != nullptr && cache->load(hash, cursor, notes, tempo_map, ChunkMode::bounded, &events)) {
+		++totals.cached;
+	}
+	else if (read_batch_tracks(file, cursor, notes, tempo_map, events, totals) && cache != nullptr) {
+		// Files with skipped tracks are not cached, so that their failures are reported again
+		cache->store(hash, cursor, notes, tempo_map, ChunkMode::bounded, events);
+	}
+
+	if (!outdir.empty() && !notes.empty()) {
+		std::filesystem::path directory = std::filesystem::path(outdir) / batch_file.output;
+		std::filesystem::create_directories(directory);
+		render_frames(notes, tempo_map, settings, (directory / "frame%d.bmp").string(), false);
+	}
+
+	totals.bytes += in.size();
+	totals.events += events;
+	totals.notes += notes.size();
+
+	// A file with many notes would otherwise keep its memory for the rest of the run
+	if (notes.start.capacity() > MAX_RESERVED_NOTES) {
+		notes = NoteTable();
 	}
-	return res;
+}
+
+void print_failures(vector<BATCH_FAILURE>& failures)
+{
+	sort(failures.begin(), failures.end(), [](const BATCH_FAILURE& a, const BATCH_FAILURE& b) {
+		return make_pair(a.file, a.track) < make_pair(b.file, b.track);
+	});
+
+	for (const BATCH_FAILURE& failure : failures)
+	{
+		std::cout << "  " << failure.file;
+		if (failure.track != -1) {
+			std::cout << ", track " << failure.track;
+		}
+		if (failure.offset != -1) {
+			std::cout << ", offset " << failure.offset;
+		}
+		std::cout << ": " << failure.reason << endl;
+	}
+}
+
+int run_batch(const vector<string>& arguments, unsigned nthreads, const string& outdir, RENDER_SETTINGS settings, const NoteCache* cache)
+{
+	BATCH_TOTALS totals;
+	vector<BATCH_FILE> files = collect_batch_files(arguments, totals);
+
+	// Workers start with their most recently queued file, so queueing from small
+	// to large has every worker begin with a big one; small files fill the gaps at the end
+	vector<pair<uintmax_t, size_t>> by_size;
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		std::error_code error;
+		uintmax_t size = std::filesystem::file_size(files[i].path, error);
+		if (error) {
+			++totals.failed;
+			totals.record_failure(files[i].path, -1, std::system_error(error));
+		}
+		else {
+			by_size.push_back(make_pair(size, i));
+		}
+	}
+	sort(by_size.begin(), by_size.end());
+
+	unsigned nworkers = nthreads == 0 ? default_thread_count() : nthreads;
+	auto start = std::chrono::steady_clock::now();
+	try {
+		WorkStealingPool pool(nworkers);
+		for (const auto& entry : by_size)
+		{
+			const BATCH_FILE& file = files[entry.second];
+			pool.submit([&file, &outdir, settings, cache, &totals]() {
+				// A malformed file costs only itself; the batch carries on with the others
+				try {
+					process_batch_file(file, outdir, settings, cache, totals);
+					++totals.files;
+				}
+				catch (const std::exception& e) {
+					++totals.failed;
+					totals.record_failure(file.path, -1, e);
+				}
+			});
+		}
+		pool.wait();
+	}
+	catch (const std::system_error& e) {
+		// Starting the workers failed, e.g. for a -j beyond what the system allows
+		std::cerr << "cannot start " << nworkers << " threads: " << e.what() << endl;
+		return 1;
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	std::cout << "processed " << totals.files << " files (" << totals.failed << " failed, "
+		<< totals.skipped_tracks << " tracks skipped, " << totals.cached << " from cache) in "
+		<< std::fixed << std::setprecision(3) << seconds << " s" << endl;
+	std::cout << std::setprecision(1)
+		<< "  " << totals.files / seconds << " files/s, "
+		<< totals.events / seconds << " events/s, "
+		<< totals.bytes / seconds / (1024 * 1024) << " MB/s, "
+		<< totals.notes << " notes" << endl;
+	if (!totals.failures.empty()) {
+		std::cout << "skipped:" << endl;
+		print_failures(totals.failures);
+	}
+
+	return totals.failures.empty() ? 0 : 1;
+}
+
+string json_string(const string& text)
+{
+	std::ostringstream out;
+	out << '"';
+	for (char c : text)
+	{
+		if (c == '"' || c == '\\') {
+			out << '\\' << c;
+		}
+		else if (uint8_t(c) < 0x20) {
+			out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec;
+		}
+		else {
+			out << c;
+		}
+	}
+	out << '"';
+	return out.str();
+}
+
+template<size_t N>
+void print_json_array(ostream& out, const std::array<uint64_t, N>& values)
+{
+	out << '[';
+	for (size_t i = 0; i != N; ++i)
+	{
+		out << (i == 0 ? "" : ",") << values[i];
+	}
+	out << ']';
+}
+
+// The statistics of a file as a JSON object on a single line
+void print_info(const string& file, const NOTE_STATISTICS& statistics, const TempoMap& tempo_map)
+{
+	std::ostringstream out;
+	out << "{\"file\":" << json_string(file)
+		<< ",\"notes\":" << statistics.notes
+		<< ",\"ticks\":" << statistics.end_time
+		<< ",\"seconds\":" << tempo_map.microseconds(Time(statistics.end_time)) / 1e6
+		<< ",\"lowest_note\":" << int(statistics.lowest_note)
+		<< ",\"highest_note\":" << int(statistics.highest_note)
+		<< ",\"max_polyphony\":" << statistics.max_polyphony
+		<< ",\"max_polyphony_tick\":" << statistics.max_polyphony_time
+		<< ",\"duration\":{\"shortest\":" << statistics.shortest
+		<< ",\"longest\":" << statistics.longest
+		<< ",\"mean\":" << statistics.mean_duration;
+	for (size_t i = 0; i != statistics.duration_percentiles.size(); ++i)
+	{
+		out << ",\"p" << DURATION_PERCENTILES[i] << "\":" << statistics.duration_percentiles[i];
+	}
+	out << "},\"pitches\":";
+	print_json_array(out, statistics.pitches);
+	out << ",\"velocities\":";
+	print_json_array(out, statistics.velocities);
+	out << ",\"instruments\":";
+	print_json_array(out, statistics.instruments);
+	out << ",\"channels\":";
+	print_json_array(out, statistics.channels);
+	out << '}';
+	std::cout << out.str() << endl;
+}
+
+// Notes of a file, through the cache if there is one
+void read_file_notes(const io::Cursor& cursor, const NoteCache* cache, NoteTable& notes, TempoMap& tempo_map)
+{
+	if (cache != nullptr) {
+		cache->read_notes(cursor, notes, tempo_map);
+	}
+	else {
+		io::Cursor in = cursor;
+		read_notes(in, notes, tempo_map);
+	}
+}
+
+// Prints one line of JSON per file; files that cannot be read are reported on stderr
+int run_info(const vector<string>& files, const NoteCache* cache)
+{
+	int result = 0;
+	for (const string& file : files)
+	{
+		try {
+			io::MappedFile in(file);
+			io::Cursor cursor = in.cursor();
+			TempoMap tempo_map;
+			NoteTable notes;
+			read_file_notes(cursor, cache, notes, tempo_map);
+			print_info(file, note_statistics(notes), tempo_map);
+		}
+		catch (const std::exception& e) {
+			std::cerr << file << ": " << e.what() << endl;
+			result = 1;
+		}
+	}
+	return result;
 }
 
 int main(int argn, char* argv[])
@@ -75,58 +522,80 @@ int main(int argn, char* argv[])
 	uint32_t step = 1;
 	uint32_t scale = 10;
 	uint32_t height_of_note = 16;
+	uint32_t fps = 0;
+	bool batch = false;
+	bool info = false;
+	uint32_t nthreads = 0;
+	string outdir;
+	string cache_directory;
+	uint32_t cache_megabytes = 0;
 
 	CommandLineParser parser;
 	parser.add_argument(std::string("-w"), &frame_width);
 	parser.add_argument(std::string("-d"), &step);
 	parser.add_argument(std::string("-s"), &scale);
 	parser.add_argument(std::string("-h"), &height_of_note);
-	parser.process(std::vector<std::string>(argv + 1, argv + argn));
+	parser.add_argument(std::string("-f"), &fps);
+	parser.add_argument(std::string("-b"), &batch);
+	parser.add_argument(std::string("-j"), &nthreads);
+	parser.add_argument(std::string("-o"), &outdir);
+	parser.add_argument(std::string("--info"), &info);
+	parser.add_argument(std::string("-c"), &cache_directory);
+	parser.add_argument(std::string("-l"), &cache_megabytes);
+	try {
+		parser.process(std::vector<std::string>(argv + 1, argv + argn));
+	}
+	catch (const CommandLineError& e) {
+		std::cerr << e.what() << endl;
+		return 1;
+	}
 	vector<string> positionalArgs = parser.positional_arguments();
+	// Both divide or advance the frames; 0 would never get past the first
+	if (step == 0 || scale == 0) {
+		std::cerr << "-d and -s must be at least 1" << endl;
+		return 1;
+	}
 
-	if (positionalArgs.size() >= 1) {
-		file = positionalArgs[0];
-		if (positionalArgs.size() >= 2) {
-			outfile = positionalArgs[1];
+	// Parsed notes are cached in a directory given with -c, limited to -l megabytes if set
+	std::unique_ptr<NoteCache> cache;
+	if (!cache_directory.empty()) {
+		try {
+			cache = std::make_unique<NoteCache>(cache_directory, uint64_t(cache_megabytes) * 1024 * 1024);
+		}
+		catch (const std::exception& e) {
+			std::cerr << cache_directory << ": " << e.what() << endl;
+			return 1;
 		}
 	}
 
-	ifstream in(file, ifstream::binary);
-	vector<NOTE> notes = read_notes(in);
-
-	uint32_t bitmapwidth = getWidth(notes) / scale;
-	uint32_t bitmapheight = 127 * height_of_note;
-
-	if (frame_width == 0) {
-		frame_width = bitmapwidth;
+	RENDER_SETTINGS settings = { frame_width, step, scale, height_of_note, fps };
+	if (batch) {
+		return run_batch(positionalArgs, nthreads, outdir, settings, cache.get());
+	}
+	if (info) {
+		// Every argument is a file to describe
+		return run_info(positionalArgs.empty() ? vector<string>{ file } : positionalArgs, cache.get());
 	}
 
-	uint16_t highest_note = getMaxNoteNumber(notes);
-	uint16_t lowest_note = getMinNoteNumber(notes);
-
-	Bitmap bitmap(bitmapwidth, bitmapheight);
-
-	for (int i = 0; i < 128; i++) {
-		for (NOTE n : notes) {
-			if (n.note_number == NoteNumber(i)) {
-				draw_rectangle(bitmap,
-					Position(value(n.start) / scale,
-					(127 - value(n.note_number))*height_of_note),
-					value(n.duration) / scale,
-					height_of_note, Color(1, 0, 0));
-			}
+	if (positionalArgs.size() >= 1) {
+		file = positionalArgs[0];
+		if (positionalArgs.size() >= 2) {
+			outfile = positionalArgs[1];
 		}
 	}
 
-	bitmap = *bitmap.slice(0, (127 - highest_note) * height_of_note, bitmapwidth, (highest_note - lowest_note + 1)*height_of_note).get();
+	try {
+		io::MappedFile in(file);
+		io::Cursor cursor = in.cursor();
+		TempoMap tempo_map;
+		NoteTable notes;
+		read_file_notes(cursor, cache.get(), notes, tempo_map);
 
-	for (int i = 0; i <= bitmapwidth - frame_width; i += step)
-	{
-		std::cout << "generated frame " + std::to_string(i / step) + " of " + std::to_string((bitmapwidth - frame_width) / step) + " (" + std::to_string((int)ceil(((float)i / (bitmapwidth - frame_width)) * 100)) + "%)" << endl;
-		Bitmap newBitmap = *bitmap.slice(i, 0, frame_width, (highest_note - lowest_note + 1)*height_of_note).get();
-		string temp = outfile;
-		string out = temp.replace(temp.find("%d"), std::string("%d").size(), to_string(i / step));
-		save_as_bmp(out, newBitmap);
+		render_frames(notes, tempo_map, settings, outfile, true);
+	}
+	catch (const std::exception& e) {
+		std::cerr << file << ": " << e.what() << endl;
+		return 1;
 	}
 }
 
@@ -0,0 +1,189 @@
+#ifdef BENCHMARK_BUILD
+
+#include "benchmarks/benchmark.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+
+namespace
+{
+	std::vector<std::pair<std::string, benchmarks::benchmark_function>>& registry()
+	{
+		static std::vector<std::pair<std::string, benchmarks::benchmark_function>> benchmarks;
+
+		return benchmarks;
+	}
+
+	void write_variable_length_integer(std::vector<uint8_t>& out, uint32_t value)
+	{
+		uint8_t bytes[5];
+		int n = 0;
+
+		do
+		{
+			bytes[n++] = value & 0x7F;
+			value >>= 7;
+		} while (value != 0);
+
+		while (n != 0)
+		{
+			--n;
+			out.push_back(uint8_t(bytes[n] | (n != 0 ? 0x80 : 0x00)));
+		}
+	}
+
+	void write_big_endian(std::vector<uint8_t>& out, uint32_t value, int nbytes)
+	{
+		for (int i = nbytes - 1; i >= 0; --i)
+		{
+			out.push_back(uint8_t(value >> (8 * i)));
+		}
+	}
+
+	std::vector<uint8_t> synthesize_track(unsigned track, unsigned notes)
+	{
+		std::vector<uint8_t> events;
+		uint8_t channel = track % 16;
+		uint32_t seed = 12345 + track;
+		auto random = [&seed]() { seed = seed * 1103515245 + 12345; return (seed >> 16) & 0x7FFF; };
+
+		// Channel status bytes are left out while they repeat, i.e. running status is used
+		// wherever it applies. The text event comes first, so it does not interrupt it
+		uint8_t running = 0;
+		auto write_status = [&events, &running](uint8_t status)
+		{
+			if (status != running)
+			{
+				events.push_back(status);
+				running = status;
+			}
+		};
+
+		const char text[] = "benchmark lyric";
+		events.push_back(0);
+		events.push_back(0xFF);
+		events.push_back(0x05);
+		write_variable_length_integer(events, sizeof(text) - 1);
+		events.insert(events.end(), text, text + sizeof(text) - 1);
+
+		events.push_back(0);
+		write_status(0xC0 | channel);
+		events.push_back(uint8_t(track % 128));
+
+		for (unsigned i = 0; i != notes; ++i)
+		{
+			uint8_t note = uint8_t(24 + random() % 80);
+
+			write_variable_length_integer(events, random() % 200);
+			write_status(0x90 | channel);
+			events.push_back(note);
+			events.push_back(uint8_t(1 + random() % 127));
+
+			if (i % 8 == 0)
+			{
+				write_variable_length_integer(events, random() % 20);
+				write_status(0xB0 | channel);
+				events.push_back(7);
+				events.push_back(uint8_t(random() % 128));
+
+				write_variable_length_integer(events, random() % 20);
+				write_status(0xE0 | channel);
+				events.push_back(uint8_t(random() % 128));
+				events.push_back(uint8_t(random() % 128));
+			}
+
+			// Note off as note on with velocity zero
+			write_variable_length_integer(events, 1 + random() % 20000);
+			write_status(0x90 | channel);
+			events.push_back(note);
+			events.push_back(0);
+		}
+
+		events.insert(events.end(), { 0x00, 0xFF, 0x2F, 0x00 });
+
+		return events;
+	}
+}
+
+benchmarks::Registrar::Registrar(const std::string& name, benchmark_function function)
+{
+	registry().push_back(std::make_pair(name, function));
+}
+
+double benchmarks::seconds_per_run(std::function<void()> function)
+{
+	using clock = std::chrono::steady_clock;
+
+	// Warm up caches and page mappings
+	function();
+
+	unsigned runs = 0;
+	auto start = clock::now();
+	std::chrono::duration<double> elapsed(0);
+
+	while (runs < 3 || elapsed.count() < 1.0)
+	{
+		function();
+		++runs;
+		elapsed = clock::now() - start;
+	}
+
+	return elapsed.count() / runs;
+}
+
+void benchmarks::report(const std::string& label, uint64_t bytes, double seconds)
+{
+	std::cout << "  " << std::left << std::setw(40) << label
+		<< std::right << std::fixed << std::setprecision(1) << std::setw(10) << (bytes / seconds / (1024 * 1024)) << " MB/s"
+		<< std::setw(12) << std::setprecision(3) << (seconds * 1000) << " ms" << std::endl;
+}
+
+std::vector<uint8_t> benchmarks::synthesize_midi(unsigned ntracks, unsigned notes_per_track)
+{
+	std::vector<uint8_t> file = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, 1 };
+	write_big_endian(file, ntracks, 2);
+	write_big_endian(file, 480, 2);
+
+	for (unsigned track = 0; track != ntracks; ++track)
+	{
+		std::vector<uint8_t> events = synthesize_track(track, notes_per_track);
+
+		file.insert(file.end(), { 'M', 'T', 'r', 'k' });
+		write_big_endian(file, uint32_t(events.size()), 4);
+		file.insert(file.end(), events.begin(), events.end());
+	}
+
+	return file;
+}
+
+int main(int argn, char* argv[])
+{
+	std::vector<std::string> files(argv + 1, argv + argn);
+	const char* synthesized = "benchmark-synthesized.mid";
+
+	if (files.empty())
+	{
+		std::vector<uint8_t> data = benchmarks::synthesize_midi(32, 50000);
+		std::ofstream out(synthesized, std::ofstream::binary);
+		out.write(reinterpret_cast<const char*>(data.data()), data.size());
+		files.push_back(synthesized);
+	}
+
+	for (auto& file : files)
+	{
+		std::cout << file << std::endl;
+
+		for (auto& benchmark : registry())
+		{
+			std::cout << " " << benchmark.first << std::endl;
+			benchmark.second(file);
+		}
+	}
+
+	std::remove(synthesized);
+}
+
+#endif
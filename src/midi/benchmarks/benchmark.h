@@ -0,0 +1,44 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace benchmarks
+{
+	typedef std::function<void(const std::string& path)> benchmark_function;
+
+	struct Registrar
+	{
+		Registrar(const std::string& name, benchmark_function function);
+	};
+
+	/// <summary>
+	/// Repeats <paramref name="function" /> until enough time has passed
+	/// for a stable measurement and returns the average number of seconds per call.
+	/// </summary>
+	double seconds_per_run(std::function<void()> function);
+
+	/// <summary>
+	/// Prints the throughput of processing <paramref name="bytes" /> in <paramref name="seconds" />.
+	/// </summary>
+	void report(const std::string& label, uint64_t bytes, double seconds);
+
+	/// <summary>
+	/// Builds a format 1 MIDI file with <paramref name="ntracks" /> dense tracks,
+	/// mixing notes with running status, controllers, pitch bends and text events.
+	/// </summary>
+	std::vector<uint8_t> synthesize_midi(unsigned ntracks, unsigned notes_per_track);
+}
+
+#define BENCHMARK_CONCAT2(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT2(a, b)
+
+#define BENCHMARK(name)                                                                          \
+	static void BENCHMARK_CONCAT(benchmark_, __LINE__)(const std::string& path);                \
+	static benchmarks::Registrar BENCHMARK_CONCAT(registrar_, __LINE__)(name, BENCHMARK_CONCAT(benchmark_, __LINE__)); \
+	static void BENCHMARK_CONCAT(benchmark_, __LINE__)(const std::string& path)
+
+#endif
@@ -0,0 +1,197 @@
+#ifdef BENCHMARK_BUILD
+
+#include "benchmarks/benchmark.h"
+#include "io/mapped-file.h"
+#include "midi/midi.h"
+#include "midi/event-batch.h"
+#include "midi/combinators.h"
+#include "midi/threaded-multicaster.h"
+#include <functional>
+#include <utility>
+
+
+namespace
+{
+	// Counts note on events and ignores the rest; the empty callbacks compile away
+	// when called statically
+	struct NoteOnCounter
+	{
+		uint64_t count = 0;
+
+		void note_on(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t velocity) { count += velocity != 0; }
+		void note_off(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t) { }
+		void polyphonic_key_pressure(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t) { }
+		void control_change(midi::Duration, midi::Channel, uint8_t, uint8_t) { }
+		void program_change(midi::Duration, midi::Channel, midi::Instrument) { }
+		void channel_pressure(midi::Duration, midi::Channel, uint8_t) { }
+		void pitch_wheel_change(midi::Duration, midi::Channel, uint16_t) { }
+		void meta(midi::Duration, uint8_t, io::ByteView) { }
+		void sysex(midi::Duration, io::ByteView) { }
+	};
+
+	struct VirtualNoteOnCounter : midi::EventReceiver
+	{
+		NoteOnCounter counter;
+
+		void note_on(midi::Duration dt, midi::Channel channel, midi::NoteNumber note, uint8_t velocity) override { counter.note_on(dt, channel, note, velocity); }
+		void note_off(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t) override { }
+		void polyphonic_key_pressure(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t) override { }
+		void control_change(midi::Duration, midi::Channel, uint8_t, uint8_t) override { }
+		void program_change(midi::Duration, midi::Channel, midi::Instrument) override { }
+		void channel_pressure(midi::Duration, midi::Channel, uint8_t) override { }
+		void pitch_wheel_change(midi::Duration, midi::Channel, uint16_t) override { }
+		void meta(midi::Duration, uint8_t, std::unique_ptr<uint8_t[]>, uint64_t) override { }
+		void sysex(midi::Duration, std::unique_ptr<uint8_t[]>, uint64_t) override { }
+		void meta(midi::Duration, uint8_t, io::ByteView) override { }
+		void sysex(midi::Duration, io::ByteView) override { }
+	};
+
+	// NoteCollector as it was before receivers declared their interests
+	struct NoteCollectorOfAllEvents : midi::NoteCollector
+	{
+		using NoteCollector::NoteCollector;
+
+		midi::EventMask interests() const override { return midi::ALL_EVENTS; }
+	};
+
+	// collect_notes as it was before the flat collector: a ChannelNoteCollector per channel
+	template<size_t... CHANNELS>
+	auto channel_note_collectors(const std::function<void(const midi::NOTE&)>& receiver, std::index_sequence<CHANNELS...>)
+	{
+		return midi::tee(midi::ChannelNoteCollector(midi::Channel(CHANNELS), receiver)...);
+	}
+}
+
+
+BENCHMARK("read_mtrk: virtual vs static dispatch")
+{
+	io::MappedFile file(path);
+	io::Cursor cursor = file.cursor();
+	midi::CHUNK_INDEX index = midi::index_chunks(cursor);
+
+	double dynamic = benchmarks::seconds_per_run([&]() {
+		VirtualNoteOnCounter counter;
+		midi::EventReceiver& receiver = counter;
+		for (const midi::CHUNK_INFO& track : index.tracks)
+		{
+			io::Cursor in = cursor.at(track.offset);
+			midi::read_mtrk(in, receiver, midi::ChunkMode::bounded);
+		}
+	});
+	benchmarks::report("EventReceiver&", file.size(), dynamic);
+
+	double fixed = benchmarks::seconds_per_run([&]() {
+		NoteOnCounter counter;
+		for (const midi::CHUNK_INFO& track : index.tracks)
+		{
+			io::Cursor in = cursor.at(track.offset);
+			midi::read_mtrk(in, counter, midi::ChunkMode::bounded);
+		}
+	});
+	benchmarks::report("NoteOnCounter&", file.size(), fixed);
+
+	uint64_t count = 0;
+	double batched = benchmarks::seconds_per_run([&]() {
+		midi::EventBatch batch;
+		batch.reserve(4096);
+		for (const midi::CHUNK_INFO& track : index.tracks)
+		{
+			io::Cursor in = cursor.at(track.offset);
+			midi::TrackDecoder decoder(in, midi::ChunkMode::bounded);
+			while (!decoder.finished())
+			{
+				batch.clear();
+				decoder.decode(batch, 4096);
+				for (size_t i = 0; i != batch.size(); ++i)
+				{
+					count += (batch.kind[i] == midi::EventKind::note_on) & (batch.data2[i] != 0);
+				}
+			}
+		}
+	});
+	benchmarks::report("EventBatch of 4096, column scan", file.size(), batched);
+}
+
+BENCHMARK("NoteCollector: all events vs declared interests vs combinators vs flat arrays")
+{
+	io::MappedFile file(path);
+	io::Cursor cursor = file.cursor();
+	midi::CHUNK_INDEX index = midi::index_chunks(cursor);
+	size_t nnotes = 0;
+
+	auto collect = [&](midi::NoteCollector& collector) {
+		for (const midi::CHUNK_INFO& track : index.tracks)
+		{
+			io::Cursor in = cursor.at(track.offset);
+			midi::read_mtrk(in, collector, midi::ChunkMode::bounded);
+		}
+	};
+
+	double all = benchmarks::seconds_per_run([&]() {
+		NoteCollectorOfAllEvents collector([&nnotes](const midi::NOTE&) { ++nnotes; });
+		collect(collector);
+	});
+	benchmarks::report("ALL_EVENTS", file.size(), all);
+
+	double interests = benchmarks::seconds_per_run([&]() {
+		midi::NoteCollector collector([&nnotes](const midi::NOTE&) { ++nnotes; });
+		collect(collector);
+	});
+	benchmarks::report("NOTE_EVENTS | program_change", file.size(), interests);
+
+	double combined = benchmarks::seconds_per_run([&]() {
+		auto collector = channel_note_collectors([&nnotes](const midi::NOTE&) { ++nnotes; }, std::make_index_sequence<16>());
+		for (const midi::CHUNK_INFO& track : index.tracks)
+		{
+			io::Cursor in = cursor.at(track.offset);
+			midi::read_mtrk(in, collector, midi::ChunkMode::bounded);
+		}
+	});
+	benchmarks::report("tee of 16 ChannelNoteCollectors", file.size(), combined);
+
+	double flat = benchmarks::seconds_per_run([&]() {
+		auto collector = midi::collect_notes([&nnotes](const midi::NOTE&) { ++nnotes; });
+		for (const midi::CHUNK_INFO& track : index.tracks)
+		{
+			io::Cursor in = cursor.at(track.offset);
+			midi::read_mtrk(in, collector, midi::ChunkMode::bounded);
+		}
+	});
+	benchmarks::report("collect_notes, flat arrays", file.size(), flat);
+}
+
+BENCHMARK("Fan-out to two note collectors: inline vs threaded")
+{
+	io::MappedFile file(path);
+	io::Cursor cursor = file.cursor();
+	midi::CHUNK_INDEX index = midi::index_chunks(cursor);
+
+	auto collect = [&](midi::EventReceiver& receiver) {
+		for (const midi::CHUNK_INFO& track : index.tracks)
+		{
+			io::Cursor in = cursor.at(track.offset);
+			midi::read_mtrk(in, receiver, midi::ChunkMode::bounded);
+		}
+	};
+
+	double inline_ = benchmarks::seconds_per_run([&]() {
+		size_t first = 0, second = 0;
+		midi::EventMulticaster multicaster({
+			std::make_shared<midi::NoteCollector>([&first](const midi::NOTE&) { ++first; }),
+			std::make_shared<midi::NoteCollector>([&second](const midi::NOTE&) { ++second; }) });
+		collect(multicaster);
+	});
+	benchmarks::report("EventMulticaster", file.size(), inline_);
+
+	double threaded = benchmarks::seconds_per_run([&]() {
+		size_t first = 0, second = 0;
+		midi::ThreadedMulticaster multicaster({
+			std::make_shared<midi::NoteCollector>([&first](const midi::NOTE&) { ++first; }),
+			std::make_shared<midi::NoteCollector>([&second](const midi::NOTE&) { ++second; }) });
+		collect(multicaster);
+		multicaster.finish();
+	});
+	benchmarks::report("ThreadedMulticaster", file.size(), threaded);
+}
+
+#endif
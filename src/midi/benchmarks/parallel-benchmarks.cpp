@@ -0,0 +1,36 @@
+#ifdef BENCHMARK_BUILD
+
+#include "benchmarks/benchmark.h"
+#include "io/mapped-file.h"
+#include "midi/midi.h"
+#include "util/parallel.h"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+
+BENCHMARK("read_notes: serial vs parallel track decoding")
+{
+	io::MappedFile file(path);
+	size_t nnotes = 0;
+
+	double serial = benchmarks::seconds_per_run([&]() {
+		io::Cursor cursor = file.cursor();
+		nnotes = midi::read_notes(cursor, midi::ChunkMode::bounded).size();
+	});
+	benchmarks::report("serial", file.size(), serial);
+
+	unsigned most = std::max(default_thread_count(), 8u);
+	for (unsigned nthreads = 1; nthreads <= most; nthreads *= 2)
+	{
+		double parallel = benchmarks::seconds_per_run([&]() {
+			io::Cursor cursor = file.cursor();
+			nnotes = midi::read_notes_parallel(cursor, nthreads).size();
+		});
+		std::ostringstream label;
+		label << nthreads << " thread(s), " << std::fixed << std::setprecision(2) << serial / parallel << "x serial";
+		benchmarks::report(label.str(), file.size(), parallel);
+	}
+}
+
+#endif
@@ -0,0 +1,375 @@
+#ifdef BENCHMARK_BUILD
+
+#include "benchmarks/benchmark.h"
+#include "io/mapped-file.h"
+#include "midi/midi.h"
+#include "midi/combinators.h"
+#include "midi/event-reader.h"
+#include "midi/note-cache.h"
+#include "midi/note-index.h"
+#include "midi/note-merger.h"
+#include "midi/note-statistics.h"
+#include "midi/note-table.h"
+#include "midi/tempo-map.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+
+BENCHMARK("read_notes: istream vs memory-mapped cursor")
+{
+	size_t size = io::MappedFile(path).size();
+	size_t nnotes = 0;
+
+	double bytewise = benchmarks::seconds_per_run([&]() {
+		std::ifstream in(path, std::ifstream::binary);
+		midi::MTHD mthd;
+		midi::read_mthd(in, &mthd);
+		std::vector<midi::NOTE> notes;
+		for (int i = 0; i < mthd.ntracks; i++)
+		{
+			midi::NoteCollector collector([&notes](const midi::NOTE& note) { notes.push_back(note); });
+			midi::read_mtrk(in, collector);
+		}
+		nnotes = notes.size();
+	});
+	benchmarks::report("std::ifstream, read_mtrk per track", size, bytewise);
+
+	double stream = benchmarks::seconds_per_run([&]() {
+		std::ifstream in(path, std::ifstream::binary);
+		nnotes = midi::read_notes(in).size();
+	});
+	benchmarks::report("std::ifstream, read_notes", size, stream);
+
+	double mapped = benchmarks::seconds_per_run([&]() {
+		io::MappedFile file(path);
+		io::Cursor cursor = file.cursor();
+		nnotes = midi::read_notes(cursor).size();
+	});
+	benchmarks::report("io::MappedFile, read_notes", size, mapped);
+}
+
+BENCHMARK("read_notes: lenient vs chunk-bounded decoding")
+{
+	io::MappedFile file(path);
+	size_t nnotes = 0;
+
+	double lenient = benchmarks::seconds_per_run([&]() {
+		io::Cursor cursor = file.cursor();
+		nnotes = midi::read_notes(cursor, midi::ChunkMode::lenient).size();
+	});
+	benchmarks::report("ChunkMode::lenient", file.size(), lenient);
+
+	double bounded = benchmarks::seconds_per_run([&]() {
+		io::Cursor cursor = file.cursor();
+		nnotes = midi::read_notes(cursor, midi::ChunkMode::bounded).size();
+	});
+	benchmarks::report("ChunkMode::bounded", file.size(), bounded);
+}
+
+BENCHMARK("Random access through the chunk index")
+{
+	io::MappedFile file(path);
+	io::Cursor cursor = file.cursor();
+	midi::CHUNK_INDEX index;
+	size_t nnotes = 0;
+
+	double scan = benchmarks::seconds_per_run([&]() {
+		index = midi::index_chunks(cursor);
+	});
+	benchmarks::report("index_chunks", file.size(), scan);
+
+	size_t last = index.tracks.size() - 1;
+	size_t track_size = index.tracks[last].header.size;
+	double single = benchmarks::seconds_per_run([&]() {
+		nnotes = midi::read_track_notes(cursor, midi::index_chunks(cursor), last).size();
+	});
+	benchmarks::report("index_chunks + last track only", track_size, single);
+}
+
+BENCHMARK("Preview: first events of each track vs whole tracks")
+{
+	io::MappedFile file(path);
+	io::Cursor cursor = file.cursor();
+	midi::CHUNK_INDEX index = midi::index_chunks(cursor);
+	size_t nnotes = 0;
+
+	double full = benchmarks::seconds_per_run([&]() {
+		std::vector<midi::NOTE> notes;
+		midi::NoteCollector collector([&notes](const midi::NOTE& note) { notes.push_back(note); });
+		for (const midi::CHUNK_INFO& track : index.tracks) {
+			io::Cursor in = cursor.at(track.offset);
+			midi::read_mtrk(in, collector, midi::ChunkMode::bounded);
+		}
+		nnotes = notes.size();
+	});
+	benchmarks::report("read_mtrk, whole tracks", file.size(), full);
+
+	for (size_t max_events : { 100000, 10000, 1000 }) {
+		double preview = benchmarks::seconds_per_run([&]() {
+			std::vector<midi::NOTE> notes;
+			midi::NoteCollector collector([&notes](const midi::NOTE& note) { notes.push_back(note); });
+			for (const midi::CHUNK_INFO& track : index.tracks) {
+				io::Cursor in = cursor.at(track.offset);
+				midi::read_mtrk_until(in, collector, midi::Time(UINT64_MAX), max_events, midi::ChunkMode::bounded);
+			}
+			nnotes = notes.size();
+		});
+		benchmarks::report("read_mtrk_until, " + std::to_string(max_events) + " events/track", file.size(), preview);
+	}
+}
+
+BENCHMARK("Tempo map: point lookups vs bulk conversion")
+{
+	io::MappedFile file(path);
+	io::Cursor cursor = file.cursor();
+	midi::TempoMap tempo_map;
+	std::vector<midi::NOTE> notes = midi::read_notes(cursor, tempo_map);
+	std::vector<uint64_t> ticks;
+	for (const midi::NOTE& note : notes) {
+		ticks.push_back(value(note.start));
+	}
+	std::vector<double> out(ticks.size());
+	size_t bytes = ticks.size() * sizeof(uint64_t);
+
+	double point = benchmarks::seconds_per_run([&]() {
+		for (size_t i = 0; i != ticks.size(); ++i) {
+			out[i] = tempo_map.microseconds(midi::Time(ticks[i]));
+		}
+	});
+	benchmarks::report("microseconds(Time), " + std::to_string(tempo_map.size()) + " segments", bytes, point);
+
+	double bulk = benchmarks::seconds_per_run([&]() {
+		tempo_map.microseconds(ticks.data(), out.data(), ticks.size());
+	});
+	benchmarks::report("microseconds, bulk", bytes, bulk);
+
+	std::sort(ticks.begin(), ticks.end());
+	double sorted = benchmarks::seconds_per_run([&]() {
+		tempo_map.microseconds(ticks.data(), out.data(), ticks.size());
+	});
+	benchmarks::report("microseconds, bulk on sorted ticks", bytes, sorted);
+}
+
+BENCHMARK("Note output: growing vector vs reserved vs reused vector")
+{
+	io::MappedFile file(path);
+	size_t nnotes = 0;
+
+	double growing = benchmarks::seconds_per_run([&]() {
+		io::Cursor cursor = file.cursor();
+		midi::MTHD mthd;
+		midi::read_mthd(cursor, &mthd);
+		std::vector<midi::NOTE> notes;
+		for (int i = 0; i < mthd.ntracks; i++) {
+			auto collector = midi::collect_notes([&notes](const midi::NOTE& note) { notes.push_back(note); });
+			midi::read_mtrk(cursor, collector);
+		}
+		nnotes = notes.size();
+	});
+	benchmarks::report("push_back without reserve", file.size(), growing);
+
+	double reserved = benchmarks::seconds_per_run([&]() {
+		io::Cursor cursor = file.cursor();
+		nnotes = midi::read_notes(cursor).size();
+	});
+	benchmarks::report("read_notes, reserved from chunk sizes", file.size(), reserved);
+
+	// As batch mode does with its NoteTable, one vector keeps its memory from run to run
+	std::vector<midi::NOTE> notes;
+	double reused = benchmarks::seconds_per_run([&]() {
+		io::Cursor cursor = file.cursor();
+		notes.clear();
+		midi::read_notes(cursor, notes);
+		nnotes = notes.size();
+	});
+	benchmarks::report("read_notes into a reused vector", file.size(), reused);
+}
+
+BENCHMARK("Note reductions: vector of NOTE vs NoteTable columns")
+{
+	io::MappedFile file(path);
+	midi::NoteTable table;
+	midi::TempoMap tempo_map;
+	io::Cursor cursor = file.cursor();
+	midi::read_notes(cursor, table, tempo_map);
+	std::vector<midi::NOTE> notes;
+	for (size_t i = 0; i != table.size(); ++i) {
+		notes.push_back(table.note(i));
+	}
+	size_t bytes = notes.size() * sizeof(midi::NOTE);
+	uint64_t checksum = 0;
+
+	double rows = benchmarks::seconds_per_run([&]() {
+		uint64_t end = 0;
+		uint8_t lowest = 128, highest = 0;
+		for (const midi::NOTE& note : notes) {
+			end = std::max(end, value(note.start + note.duration));
+			lowest = std::min(lowest, value(note.note_number));
+			highest = std::max(highest, value(note.note_number));
+		}
+		checksum += end + lowest + highest;
+	});
+	benchmarks::report("vector<NOTE>, one loop", bytes, rows);
+
+	double columns = benchmarks::seconds_per_run([&]() {
+		checksum += midi::end_time(table) + midi::lowest_note(table) + midi::highest_note(table);
+	});
+	benchmarks::report("NoteTable, column scans", bytes, columns);
+
+	double by_start = benchmarks::seconds_per_run([&]() {
+		midi::NoteTable copy = table;
+		copy.sort_by_pitch();
+		copy.sort_by_start();
+		checksum += copy.start.back();
+	});
+	benchmarks::report("NoteTable, copy + sort by pitch + sort by start", bytes, by_start);
+}
+
+BENCHMARK("Notes in 1000 frame windows: linear scan vs NoteIndex")
+{
+	io::MappedFile file(path);
+	midi::NoteTable table;
+	midi::TempoMap tempo_map;
+	io::Cursor cursor = file.cursor();
+	midi::read_notes(cursor, table, tempo_map);
+	uint64_t end = midi::end_time(table);
+	uint64_t width = end / 1000 + 1;
+	size_t bytes = table.size() * sizeof(midi::NOTE);
+	size_t found = 0;
+
+	double linear = benchmarks::seconds_per_run([&]() {
+		for (uint64_t from = 0; from < end; from += width) {
+			for (size_t i = 0; i != table.size(); ++i) {
+				found += table.start[i] < from + width && table.start[i] + table.duration[i] > from;
+			}
+		}
+	});
+	benchmarks::report("linear scan", bytes, linear);
+
+	double build = benchmarks::seconds_per_run([&]() {
+		midi::NoteIndex index(table);
+		found += index.size();
+	});
+	benchmarks::report("NoteIndex, build", bytes, build);
+
+	midi::NoteIndex index(table);
+	std::vector<size_t> rows;
+	double indexed = benchmarks::seconds_per_run([&]() {
+		for (uint64_t from = 0; from < end; from += width) {
+			rows.clear();
+			index.overlapping(midi::Time(from), midi::Time(from + width), rows);
+			found += rows.size();
+		}
+	});
+	benchmarks::report("NoteIndex, queries", bytes, indexed);
+}
+
+BENCHMARK("Notes in order of start: read_notes + sort vs NoteMerger")
+{
+	io::MappedFile file(path);
+	uint64_t checksum = 0;
+
+	double sorted = benchmarks::seconds_per_run([&]() {
+		io::Cursor cursor = file.cursor();
+		std::vector<midi::NOTE> notes = midi::read_notes(cursor, midi::ChunkMode::bounded);
+		std::stable_sort(notes.begin(), notes.end(), [](const midi::NOTE& a, const midi::NOTE& b) { return a.start < b.start; });
+		for (const midi::NOTE& note : notes) {
+			checksum += value(note.start);
+		}
+	});
+	benchmarks::report("read_notes + stable_sort", file.size(), sorted);
+
+	double merged = benchmarks::seconds_per_run([&]() {
+		for (midi::NoteMerger merger(file.cursor()); !merger.at_end(); merger.advance()) {
+			checksum += value(merger.note().start);
+		}
+	});
+	benchmarks::report("NoteMerger", file.size(), merged);
+}
+
+BENCHMARK("Note statistics: separate passes vs note_statistics")
+{
+	io::MappedFile file(path);
+	midi::NoteTable table;
+	midi::TempoMap tempo_map;
+	io::Cursor cursor = file.cursor();
+	midi::read_notes(cursor, table, tempo_map);
+	size_t bytes = table.size() * sizeof(midi::NOTE);
+	uint64_t checksum = 0;
+
+	double separate = benchmarks::seconds_per_run([&]() {
+		uint64_t pitches[128] = {}, velocities[128] = {}, instruments[128] = {};
+		for (size_t i = 0; i != table.size(); ++i) {
+			++pitches[table.note_number[i] & 0x7F];
+		}
+		for (size_t i = 0; i != table.size(); ++i) {
+			++velocities[table.velocity[i] & 0x7F];
+		}
+		for (size_t i = 0; i != table.size(); ++i) {
+			++instruments[table.instrument[i] & 0x7F];
+		}
+		std::vector<uint64_t> durations = table.duration;
+		std::sort(durations.begin(), durations.end());
+		std::vector<uint64_t> starts, ends;
+		for (size_t i = 0; i != table.size(); ++i) {
+			if (table.duration[i] != 0) {
+				starts.push_back(table.start[i]);
+				ends.push_back(table.start[i] + table.duration[i]);
+			}
+		}
+		std::sort(starts.begin(), starts.end());
+		std::sort(ends.begin(), ends.end());
+		size_t ended = 0, most = 0;
+		for (size_t i = 0; i != starts.size(); ++i) {
+			while (ends[ended] <= starts[i]) {
+				++ended;
+			}
+			most = std::max(most, i + 1 - ended);
+		}
+		checksum += most;
+		checksum += pitches[60] + velocities[64] + instruments[0] + durations[durations.size() / 2]
+			+ midi::end_time(table) + midi::lowest_note(table) + midi::highest_note(table);
+	});
+	benchmarks::report("separate passes, sorts and sweep", bytes, separate);
+
+	double fused = benchmarks::seconds_per_run([&]() {
+		midi::NOTE_STATISTICS statistics = midi::note_statistics(table);
+		checksum += statistics.pitches[60] + statistics.max_polyphony;
+	});
+	benchmarks::report("note_statistics, polyphony included", bytes, fused);
+}
+
+BENCHMARK("Notes of a file: read_notes vs NoteCache hit")
+{
+	io::MappedFile file(path);
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "note-cache-benchmark";
+	midi::NoteCache cache(directory.string());
+	midi::NoteTable notes;
+	midi::TempoMap tempo_map;
+	cache.read_notes(file.cursor(), notes, tempo_map);
+	uint64_t checksum = 0;
+
+	double parsed = benchmarks::seconds_per_run([&]() {
+		io::Cursor cursor = file.cursor();
+		notes.clear();
+		midi::read_notes(cursor, notes, tempo_map);
+	});
+	benchmarks::report("read_notes into NoteTable", file.size(), parsed);
+
+	double hashed = benchmarks::seconds_per_run([&]() {
+		checksum += midi::content_hash(file.data(), file.size());
+	});
+	benchmarks::report("content_hash", file.size(), hashed);
+
+	double loaded = benchmarks::seconds_per_run([&]() {
+		cache.load(file.cursor(), notes, tempo_map);
+	});
+	benchmarks::report("NoteCache::load, hash included", file.size(), loaded);
+
+	std::error_code error;
+	std::filesystem::remove_all(directory, error);
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifdef BENCHMARK_BUILD
+
+#include "benchmarks/benchmark.h"
+#include "io/mapped-file.h"
+#include "io/vli.h"
+#include "midi/midi.h"
+#include <sstream>
+#include <vector>
+
+namespace
+{
+	// Collects the delta time of every event so they can be decoded in isolation
+	struct DeltaRecorder : public midi::EventReceiver
+	{
+		std::vector<uint64_t> deltas;
+
+		void note_on(midi::Duration dt, midi::Channel, midi::NoteNumber, uint8_t) override { deltas.push_back(value(dt)); }
+		void note_off(midi::Duration dt, midi::Channel, midi::NoteNumber, uint8_t) override { deltas.push_back(value(dt)); }
+		void polyphonic_key_pressure(midi::Duration dt, midi::Channel, midi::NoteNumber, uint8_t) override { deltas.push_back(value(dt)); }
+		void control_change(midi::Duration dt, midi::Channel, uint8_t, uint8_t) override { deltas.push_back(value(dt)); }
+		void program_change(midi::Duration dt, midi::Channel, midi::Instrument) override { deltas.push_back(value(dt)); }
+		void channel_pressure(midi::Duration dt, midi::Channel, uint8_t) override { deltas.push_back(value(dt)); }
+		void pitch_wheel_change(midi::Duration dt, midi::Channel, uint16_t) override { deltas.push_back(value(dt)); }
+		void meta(midi::Duration dt, uint8_t, std::unique_ptr<uint8_t[]>, uint64_t) override { deltas.push_back(value(dt)); }
+		void sysex(midi::Duration dt, std::unique_ptr<uint8_t[]>, uint64_t) override { deltas.push_back(value(dt)); }
+	};
+
+	std::vector<uint8_t> encode(const std::vector<uint64_t>& values)
+	{
+		std::vector<uint8_t> out;
+
+		for (uint64_t value : values)
+		{
+			uint8_t bytes[10];
+			int n = 0;
+
+			do
+			{
+				bytes[n++] = value & 0x7F;
+				value >>= 7;
+			} while (value != 0);
+
+			while (n != 0)
+			{
+				--n;
+				out.push_back(uint8_t(bytes[n] | (n != 0 ? 0x80 : 0x00)));
+			}
+		}
+
+		return out;
+	}
+}
+
+
+BENCHMARK("Delta time decoding: stream vs cursor vs bulk")
+{
+	DeltaRecorder recorder;
+	{
+		io::MappedFile file(path);
+		io::Cursor cursor = file.cursor();
+		midi::MTHD mthd;
+		midi::read_mthd(cursor, &mthd);
+		for (int i = 0; i < mthd.ntracks; i++)
+		{
+			midi::read_mtrk(cursor, recorder);
+		}
+	}
+
+	std::vector<uint8_t> packed = encode(recorder.deltas);
+	std::string data(packed.begin(), packed.end());
+	std::vector<uint64_t> decoded(recorder.deltas.size());
+	uint64_t checksum = 0;
+
+	double stream = benchmarks::seconds_per_run([&]() {
+		std::stringstream ss(data);
+		for (auto& delta : decoded)
+		{
+			delta = io::read_variable_length_integer(ss);
+		}
+		checksum += decoded.back();
+	});
+	benchmarks::report("std::istream, one at a time", packed.size(), stream);
+
+	double cursor = benchmarks::seconds_per_run([&]() {
+		io::Cursor in(packed);
+		for (auto& delta : decoded)
+		{
+			delta = io::read_variable_length_integer(in);
+		}
+		checksum += decoded.back();
+	});
+	benchmarks::report("io::Cursor, one at a time", packed.size(), cursor);
+
+	double bulk = benchmarks::seconds_per_run([&]() {
+		io::Cursor in(packed);
+		io::read_variable_length_integers(in, decoded.data(), decoded.size());
+		checksum += decoded.back();
+	});
+	benchmarks::report("io::Cursor, bulk", packed.size(), bulk);
+}
+
+#endif
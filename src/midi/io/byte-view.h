@@ -0,0 +1,40 @@
+#ifndef BYTE_VIEW_H
+#define BYTE_VIEW_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace io {
+	/// <summary>
+	/// Non-owning view on a range of bytes, e.g. an event payload inside the parse buffer.
+	/// Only valid as long as the underlying buffer is; copy() the bytes to keep them.
+	/// </summary>
+	class ByteView {
+	public:
+		ByteView() : m_data(nullptr), m_size(0) { }
+		ByteView(const uint8_t* data, size_t size) : m_data(data), m_size(size) { }
+
+		const uint8_t* data() const { return m_data; }
+		size_t size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+
+		const uint8_t* begin() const { return m_data; }
+		const uint8_t* end() const { return m_data + m_size; }
+
+		uint8_t operator [](size_t index) const { return m_data[index]; }
+
+		std::unique_ptr<uint8_t[]> copy() const {
+			std::unique_ptr<uint8_t[]> result = std::make_unique<uint8_t[]>(m_size);
+			if (m_size != 0) {
+				std::memcpy(result.get(), m_data, m_size);
+			}
+			return result;
+		}
+
+	private:
+		const uint8_t* m_data;
+		size_t m_size;
+	};
+}
+#endif
@@ -0,0 +1,172 @@
+#ifndef CURSOR_H
+#define CURSOR_H
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "io/byte-view.h"
+#include "io/parse-error.h"
+
+namespace io {
+	/// <summary>
+	/// Read position inside a contiguous, read-only block of bytes,
+	/// e.g. a memory-mapped file. The cursor does not own the bytes.
+	/// Reading past the end raises a ParseError.
+	/// </summary>
+	class Cursor {
+	public:
+		Cursor(const uint8_t* begin, const uint8_t* end) :
+			m_begin(begin), m_current(begin), m_end(end) { }
+
+		Cursor(const uint8_t* data, size_t size) :
+			Cursor(data, data + size) { }
+
+		explicit Cursor(const std::vector<uint8_t>& buffer) :
+			Cursor(buffer.data(), buffer.size()) { }
+
+		const uint8_t* begin() const { return m_begin; }
+		const uint8_t* position() const { return m_current; }
+		const uint8_t* end() const { return m_end; }
+
+		/// <summary>
+		/// Number of bytes consumed since the start of the buffer.
+		/// Cursors created by take() share the start of their parent.
+		/// </summary>
+		size_t offset() const { return m_current - m_begin; }
+		size_t remaining() const { return m_end - m_current; }
+		bool at_end() const { return m_current == m_end; }
+
+		void require(size_t n) const {
+			if (n > remaining()) {
+				throw ParseError(offset(), "unexpected end of data, " + std::to_string(n) + " bytes needed but only " + std::to_string(remaining()) + " left");
+			}
+		}
+
+		void skip(size_t n) {
+			require(n);
+			m_current += n;
+		}
+
+		/// <summary>
+		/// Skips without checking; only for callers that validated the bounds beforehand.
+		/// </summary>
+		void advance(size_t n) {
+			m_current += n;
+		}
+
+		/// <summary>
+		/// Cursor on the same buffer, positioned <paramref name="offset" /> bytes from its start.
+		/// </summary>
+		Cursor at(size_t offset) const {
+			if (offset > size_t(m_end - m_begin)) {
+				throw ParseError(offset, "position lies beyond the end of the data");
+			}
+			return Cursor(m_begin, m_begin + offset, m_end);
+		}
+
+		/// <summary>
+		/// Splits off the next <paramref name="n" /> bytes as a separate cursor
+		/// and moves past them.
+		/// </summary>
+		Cursor take(size_t n) {
+			require(n);
+			Cursor result(m_begin, m_current, m_current + n);
+			m_current += n;
+			return result;
+		}
+
+	private:
+		Cursor(const uint8_t* begin, const uint8_t* current, const uint8_t* end) :
+			m_begin(begin), m_current(current), m_end(end) { }
+
+		const uint8_t* m_begin;
+		const uint8_t* m_current;
+		const uint8_t* m_end;
+	};
+
+	/// <summary>
+	/// Stretch of reads from a cursor whose bounds were validated up front,
+	/// e.g. against the size of the enclosing chunk. Fixed-size reads are not checked;
+	/// reads whose length comes from the data itself still are.
+	/// </summary>
+	class UncheckedCursor {
+	public:
+		explicit UncheckedCursor(Cursor& cursor) : m_cursor(cursor) { }
+
+		Cursor& cursor() { return m_cursor; }
+
+	private:
+		Cursor& m_cursor;
+	};
+
+	template<typename T>
+	void read_to(Cursor& in, T* buffer, size_t size) {
+		in.require(sizeof(T) * size);
+		std::memcpy(buffer, in.position(), sizeof(T) * size);
+		in.skip(sizeof(T) * size);
+	};
+
+	template<typename T>
+	void read_to(Cursor& in, T* buffer) {
+		read_to(in, buffer, 1);
+	};
+
+	template<typename T, typename std::enable_if<std::is_fundamental<T>::value, T>::type* = nullptr>
+	T read(Cursor& in)
+	{
+		T buffer;
+		read_to(in, &buffer);
+		return buffer;
+	};
+
+	/// <summary>
+	/// Views the next sizeof(T) bytes as a T, without copying, and moves past them.
+	/// T must not require alignment, e.g. a packed struct of big_endian fields.
+	/// </summary>
+	template<typename T>
+	const T* overlay(Cursor& in) {
+		static_assert(alignof(T) == 1, "overlaid types must not require alignment");
+		in.require(sizeof(T));
+		const T* result = reinterpret_cast<const T*>(in.position());
+		in.advance(sizeof(T));
+		return result;
+	};
+
+	/// <summary>
+	/// Returns the next <paramref name="n" /> bytes without copying them and moves past them.
+	/// </summary>
+	inline ByteView read_view(Cursor& in, size_t n) {
+		in.require(n);
+		ByteView result(in.position(), n);
+		in.advance(n);
+		return result;
+	}
+
+	template<typename T>
+	std::unique_ptr<T[]> read_array(Cursor& in, size_t n) {
+		in.require(sizeof(T) * n);
+		std::unique_ptr<T[]> object = std::make_unique<T[]>(n);
+		read_to(in, object.get(), n);
+		return object;
+	};
+
+	template<typename T, typename std::enable_if<std::is_fundamental<T>::value, T>::type* = nullptr>
+	T read(UncheckedCursor& in)
+	{
+		T buffer;
+		std::memcpy(&buffer, in.cursor().position(), sizeof(T));
+		in.cursor().advance(sizeof(T));
+		return buffer;
+	};
+
+	template<typename T>
+	std::unique_ptr<T[]> read_array(UncheckedCursor& in, size_t n) {
+		return read_array<T>(in.cursor(), n);
+	};
+
+	inline ByteView read_view(UncheckedCursor& in, size_t n) {
+		return read_view(in.cursor(), n);
+	}
+}
+#endif
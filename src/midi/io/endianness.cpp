@@ -1,24 +1,73 @@
 #include "io/endianness.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENDIANNESS_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace io {
 	void switch_endianness(uint16_t* n) {
-		*n = (*n >> 8) | (*n << 8);
+		*n = byteswap(*n);
 	}
 
 	void switch_endianness(uint32_t* n) {
-		*n = (*n >> 24) | (*n << 24) | (*n & 0x00FF0000) >> 8 | (*n & 0x0000FF00) << 8;
+		*n = byteswap(*n);
 	}
 
 	void switch_endianness(uint64_t* n) {
-		uint64_t byte8 = (*n & 0xFF00000000000000) >> 56;
-		uint64_t byte7 = (*n & 0x00FF000000000000) >> 40;
-		uint64_t byte6 = (*n & 0x0000FF0000000000) >> 24;
-		uint64_t byte5 = (*n & 0x000000FF00000000) >> 8;
-		uint64_t byte4 = (*n & 0x00000000FF000000) << 8;
-		uint64_t byte3 = (*n & 0x0000000000FF0000) << 24;
-		uint64_t byte2 = (*n & 0x000000000000FF00) << 40;
-		uint64_t byte1 = (*n & 0x00000000000000FF) << 56;
-
-		*n = byte1 | byte2 | byte3 | byte4 | byte5 | byte6 | byte7 | byte8;
+		*n = byteswap(*n);
+	}
+
+	namespace {
+#ifdef ENDIANNESS_SSE2
+		// Swaps the two bytes of every 16-bit lane
+		__m128i swap_bytes(__m128i x) {
+			return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+		}
+
+		// The pointer argument only selects the lane width
+		__m128i byteswap_lanes(__m128i x, const uint16_t*) {
+			return swap_bytes(x);
+		}
+
+		__m128i byteswap_lanes(__m128i x, const uint32_t*) {
+			x = swap_bytes(x);
+			x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+			return _mm_shufflehi_epi16(x, _MM_SHUFFLE(2, 3, 0, 1));
+		}
+
+		__m128i byteswap_lanes(__m128i x, const uint64_t*) {
+			x = swap_bytes(x);
+			x = _mm_shufflelo_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+			return _mm_shufflehi_epi16(x, _MM_SHUFFLE(0, 1, 2, 3));
+		}
+#endif
+
+		template<typename T>
+		void switch_endianness_bulk(T* values, size_t count) {
+			size_t i = 0;
+#ifdef ENDIANNESS_SSE2
+			const size_t per_block = sizeof(__m128i) / sizeof(T);
+			for (; i + per_block <= count; i += per_block) {
+				__m128i* block = reinterpret_cast<__m128i*>(values + i);
+				_mm_storeu_si128(block, byteswap_lanes(_mm_loadu_si128(block), values));
+			}
+#endif
+			for (; i != count; ++i) {
+				values[i] = byteswap(values[i]);
+			}
+		}
+	}
+
+	void switch_endianness(uint16_t* values, size_t count) {
+		switch_endianness_bulk(values, count);
+	}
+
+	void switch_endianness(uint32_t* values, size_t count) {
+		switch_endianness_bulk(values, count);
+	}
+
+	void switch_endianness(uint64_t* values, size_t count) {
+		switch_endianness_bulk(values, count);
 	}
 }
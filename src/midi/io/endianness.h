@@ -2,10 +2,84 @@
 #define ENDIANNESS_H
 
 
+#include <cstddef>
 #include <cstdint>
+#ifdef _MSC_VER
+#include <stdlib.h>
+#endif
+
 namespace io {
+	/// <summary>
+	/// Reverses the byte order. GCC and Clang evaluate their intrinsics at compile time;
+	/// MSVC's _byteswap_* are not constexpr, so there the shifts are spelled out,
+	/// which the optimizer turns into a single bswap.
+	/// </summary>
+	constexpr uint16_t byteswap(uint16_t n) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_bswap16(n);
+#else
+		return uint16_t((n >> 8) | (n << 8));
+#endif
+	}
+
+	constexpr uint32_t byteswap(uint32_t n) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_bswap32(n);
+#else
+		return (n >> 24) | (n << 24) | (n & 0x00FF0000) >> 8 | (n & 0x0000FF00) << 8;
+#endif
+	}
+
+	constexpr uint64_t byteswap(uint64_t n) {
+#if defined(__GNUC__) || defined(__clang__)
+		return __builtin_bswap64(n);
+#else
+		return (uint64_t(byteswap(uint32_t(n))) << 32) | byteswap(uint32_t(n >> 32));
+#endif
+	}
+
 	void switch_endianness(uint16_t* n);
 	void switch_endianness(uint32_t* n);
 	void switch_endianness(uint64_t* n);
+
+	/// <summary>
+	/// Switches the endianness of <paramref name="count" /> consecutive values in place,
+	/// sixteen bytes at a time where SSE2 is available.
+	/// </summary>
+	void switch_endianness(uint16_t* values, size_t count);
+	void switch_endianness(uint32_t* values, size_t count);
+	void switch_endianness(uint64_t* values, size_t count);
+
+#pragma pack(push,1)
+	/// <summary>
+	/// Unsigned integer stored in big endian byte order, as in MIDI files.
+	/// Has no alignment requirement, so structs built from these
+	/// can be overlaid directly on a (mapped) file buffer.
+	/// The bytes are converted on access; assumes a little endian host.
+	/// </summary>
+	template<typename T>
+	class big_endian {
+	public:
+		constexpr big_endian() : m_raw(0) { }
+		constexpr big_endian(T value) : m_raw(byteswap(value)) { }
+
+		constexpr T value() const { return byteswap(m_raw); }
+		constexpr operator T() const { return value(); }
+
+		/// <summary>
+		/// The value as it is stored, i.e. in big endian byte order.
+		/// </summary>
+		constexpr T raw() const { return m_raw; }
+
+	private:
+		T m_raw;
+	};
+#pragma pack(pop)
+
+	using be_uint16 = big_endian<uint16_t>;
+	using be_uint32 = big_endian<uint32_t>;
+	using be_uint64 = big_endian<uint64_t>;
+
+	static_assert(alignof(be_uint32) == 1, "big endian integers must not require alignment");
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,119 @@
+#include "io/mapped-file.h"
+#include <system_error>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace io {
+#ifdef _WIN32
+	namespace {
+		[[noreturn]] void fail(const std::string& message) {
+			throw std::system_error(int(GetLastError()), std::system_category(), message);
+		}
+	}
+
+	MappedFile::MappedFile(const std::string& path) :
+		m_data(nullptr), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr) {
+		m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE) {
+			fail("Could not open " + path);
+		}
+
+		// The destructor does not run for a constructor that throws
+		try {
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(m_file, &size)) {
+				fail("Could not determine size of " + path);
+			}
+			m_size = size_t(size.QuadPart);
+
+			// Empty files cannot be mapped; they simply yield an empty buffer
+			if (m_size != 0) {
+				m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (m_mapping == nullptr) {
+					fail("Could not map " + path);
+				}
+				m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+				if (m_data == nullptr) {
+					fail("Could not map " + path);
+				}
+			}
+		}
+		catch (...) {
+			release();
+			throw;
+		}
+	}
+
+	void MappedFile::release() {
+		if (m_data != nullptr) {
+			UnmapViewOfFile(m_data);
+		}
+		if (m_mapping != nullptr) {
+			CloseHandle(m_mapping);
+		}
+		if (m_file != INVALID_HANDLE_VALUE) {
+			CloseHandle(m_file);
+		}
+	}
+#else
+	namespace {
+		[[noreturn]] void fail(const std::string& message) {
+			throw std::system_error(errno, std::generic_category(), message);
+		}
+	}
+
+	MappedFile::MappedFile(const std::string& path) :
+		m_data(nullptr), m_size(0), m_descriptor(-1) {
+		m_descriptor = open(path.c_str(), O_RDONLY);
+		if (m_descriptor == -1) {
+			fail("Could not open " + path);
+		}
+
+		// The destructor does not run for a constructor that throws
+		try {
+			struct stat status;
+			if (fstat(m_descriptor, &status) != 0) {
+				fail("Could not determine size of " + path);
+			}
+			m_size = size_t(status.st_size);
+
+			// Empty files cannot be mapped; they simply yield an empty buffer
+			if (m_size != 0) {
+				void* address = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_descriptor, 0);
+				if (address == MAP_FAILED) {
+					fail("Could not map " + path);
+				}
+				madvise(address, m_size, MADV_SEQUENTIAL);
+				m_data = static_cast<const uint8_t*>(address);
+			}
+		}
+		catch (...) {
+			release();
+			throw;
+		}
+	}
+
+	void MappedFile::release() {
+		if (m_data != nullptr) {
+			munmap(const_cast<uint8_t*>(m_data), m_size);
+		}
+		if (m_descriptor != -1) {
+			close(m_descriptor);
+		}
+	}
+#endif
+
+	MappedFile::~MappedFile() {
+		release();
+	}
+}
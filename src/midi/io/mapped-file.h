@@ -0,0 +1,42 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstdint>
+#include <string>
+#include "io/cursor.h"
+
+namespace io {
+	/// <summary>
+	/// Maps a file read-only into memory for the lifetime of the object.
+	/// Raises std::system_error if the file cannot be opened or mapped.
+	/// </summary>
+	class MappedFile {
+	public:
+		explicit MappedFile(const std::string& path);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator =(const MappedFile&) = delete;
+
+		const uint8_t* data() const { return m_data; }
+		size_t size() const { return m_size; }
+
+		/// <summary>
+		/// Returns a cursor positioned at the start of the file.
+		/// </summary>
+		Cursor cursor() const { return Cursor(m_data, m_size); }
+
+	private:
+		void release();
+
+		const uint8_t* m_data;
+		size_t m_size;
+#ifdef _WIN32
+		void* m_file;
+		void* m_mapping;
+#else
+		int m_descriptor;
+#endif
+	};
+}
+#endif
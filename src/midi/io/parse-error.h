@@ -0,0 +1,27 @@
+#ifndef PARSE_ERROR_H
+#define PARSE_ERROR_H
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+namespace io {
+	/// <summary>
+	/// Raised when input is malformed or ends prematurely.
+	/// Carries the byte offset at which the problem was detected.
+	/// </summary>
+	class ParseError : public std::runtime_error {
+	public:
+		ParseError(uint64_t offset, const std::string& reason) :
+			std::runtime_error("offset " + std::to_string(offset) + ": " + reason),
+			m_offset(offset), m_reason(reason) { }
+
+		uint64_t offset() const { return m_offset; }
+		const std::string& reason() const { return m_reason; }
+
+	private:
+		uint64_t m_offset;
+		std::string m_reason;
+	};
+}
+#endif
@@ -3,13 +3,28 @@
 
 #include <cstdint>
 #include <istream>
-#include "logging.h"
+#include <memory>
+#include <string>
+#include "io/parse-error.h"
 
 namespace io {
+	/// <summary>
+	/// Reads <paramref name="size" /> objects. Raises ParseError, at the offset where the data
+	/// ran out, if the stream ends first.
+	/// </summary>
 	template<typename T>
 	void read_to(std::istream & in, T* buffer, size_t size) {
 		in.read(reinterpret_cast<char*>(buffer), sizeof(T) * size);
-		CHECK(!in.fail()) << __FUNCTION__ << " failed";
+		if (in.fail()) {
+			// The position is only looked up on failure: it costs a seek query on the stream buffer.
+			// tellg() needs a good stream, the failure is restored afterwards
+			std::ios::iostate state = in.rdstate();
+			in.clear();
+			std::streamoff end = in.tellg();
+			in.clear(state);
+			uint64_t offset = end < 0 ? 0 : uint64_t(end);
+			throw ParseError(offset, "unexpected end of data, " + std::to_string(sizeof(T) * size) + " bytes needed but only " + std::to_string(in.gcount()) + " left");
+		}
 	};
 
 	template<typename T>
@@ -32,4 +47,4 @@ namespace io {
 		return object;
 	};
 }
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
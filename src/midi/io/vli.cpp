@@ -1,5 +1,13 @@
 #include "io/vli.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VLI_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
 namespace io {
 
 	bool leftmost_bit_set(uint8_t byte) {
@@ -22,4 +30,109 @@ namespace io {
 		return acc;
 
 	}
+
+	uint64_t read_long_variable_length_integer(Cursor & in, size_t max_bytes) {
+		uint64_t start = in.offset();
+		uint8_t byte = read<uint8_t>(in);
+		uint64_t acc = 0;
+		size_t length = 1;
+		while (leftmost_bit_set(byte)) {
+			if (length == max_bytes) {
+				throw ParseError(start, "variable length integer exceeds " + std::to_string(max_bytes) + " bytes");
+			}
+			acc = (acc << 7) | lowest_7_bit(byte);
+			byte = read<uint8_t>(in);
+			++length;
+		}
+
+		acc = (acc << 7) | lowest_7_bit(byte);
+		return acc;
+	}
+
+#ifdef VLI_SSE2
+	namespace {
+		unsigned highest_set_bit(unsigned bits) {
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse(&index, bits);
+			return index;
+#else
+			return 31 - __builtin_clz(bits);
+#endif
+		}
+
+		// Zero-extends sixteen bytes to sixteen 64-bit integers
+		void widen(__m128i bytes, uint64_t* out) {
+			const __m128i zero = _mm_setzero_si128();
+			__m128i words[2] = { _mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero) };
+
+			for (int i = 0; i != 2; ++i) {
+				__m128i lo = _mm_unpacklo_epi16(words[i], zero);
+				__m128i hi = _mm_unpackhi_epi16(words[i], zero);
+				__m128i* target = reinterpret_cast<__m128i*>(out + 8 * i);
+				_mm_storeu_si128(target + 0, _mm_unpacklo_epi32(lo, zero));
+				_mm_storeu_si128(target + 1, _mm_unpackhi_epi32(lo, zero));
+				_mm_storeu_si128(target + 2, _mm_unpacklo_epi32(hi, zero));
+				_mm_storeu_si128(target + 3, _mm_unpackhi_epi32(hi, zero));
+			}
+		}
+	}
+#endif
+
+	size_t read_variable_length_integers(Cursor & in, uint64_t* out, size_t count) {
+		size_t n = 0;
+
+#ifdef VLI_SSE2
+		// One byte of slack past the block lets the two-byte case read ahead unconditionally
+		while (count - n >= 16 && in.remaining() > 16) {
+			const uint8_t* bytes = in.position();
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+			unsigned continuations = unsigned(_mm_movemask_epi8(block));
+
+			if (continuations == 0) {
+				widen(block, out + n);
+				n += 16;
+				in.skip(16);
+				continue;
+			}
+
+			// Every clear high bit terminates an integer; decode all of them
+			// that end inside this block without further bounds checks
+			unsigned terminators = ~continuations & 0xFFFF;
+			if (terminators == 0) {
+				out[n++] = read_long_variable_length_integer(in);
+				continue;
+			}
+
+			const uint8_t* stop = bytes + highest_set_bit(terminators) + 1;
+			const uint8_t* current = bytes;
+			while (current != stop) {
+				uint32_t first = current[0];
+				uint32_t second = current[1];
+				uint32_t more = first >> 7;
+
+				if ((more & (second >> 7)) == 0) {
+					uint32_t mask = 0u - more;
+					uint32_t two = ((first & 0x7F) << 7) | second;
+					out[n++] = (first & ~mask) | (two & mask);
+					current += 1 + more;
+				}
+				else {
+					uint64_t acc = 0;
+					while (leftmost_bit_set(*current)) {
+						acc = (acc << 7) | lowest_7_bit(*current++);
+					}
+					out[n++] = (acc << 7) | *current++;
+				}
+			}
+			in.skip(stop - bytes);
+		}
+#endif
+
+		while (n != count && !in.at_end()) {
+			out[n++] = read_variable_length_integer(in);
+		}
+
+		return n;
+	}
 }
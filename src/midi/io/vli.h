@@ -2,11 +2,78 @@
 #define VLI_H
 
 #include "read.h"
+#include "cursor.h"
+#include "parse-error.h"
 #include <istream>
 #include <cstdint>
-#include "read.h"
 
 namespace io {
 	uint64_t read_variable_length_integer(std::istream & in);
+
+	/// <summary>
+	/// Byte-at-a-time decoder, used for integers of three or more bytes
+	/// and near the end of the buffer. Integers longer than <paramref name="max_bytes" /> are rejected.
+	/// </summary>
+	uint64_t read_long_variable_length_integer(Cursor & in, size_t max_bytes = SIZE_MAX);
+
+	/// <summary>
+	/// Decodes one integer. Delta times and payload lengths are almost always
+	/// one or two bytes long; those are decoded without data-dependent branches.
+	/// Integers longer than <paramref name="max_bytes" /> are rejected.
+	/// </summary>
+	inline uint64_t read_variable_length_integer(Cursor & in, size_t max_bytes = SIZE_MAX) {
+		if (in.remaining() >= 2) {
+			const uint8_t* bytes = in.position();
+			uint32_t first = bytes[0];
+			uint32_t second = bytes[1];
+			uint32_t more = first >> 7;
+
+			if ((more & (second >> 7)) == 0) {
+				uint32_t mask = 0u - more;
+				uint32_t two = ((first & 0x7F) << 7) | second;
+				in.skip(1 + more);
+				return (first & ~mask) | (two & mask);
+			}
+		}
+
+		return read_long_variable_length_integer(in, max_bytes);
+	}
+
+	/// <summary>
+	/// Decodes one integer of at most four bytes, the limit imposed by the MIDI standard,
+	/// without bounds checks. The caller guarantees that at least four bytes remain.
+	/// </summary>
+	inline uint64_t read_variable_length_integer(UncheckedCursor & in) {
+		Cursor& cursor = in.cursor();
+		const uint8_t* bytes = cursor.position();
+		uint32_t first = bytes[0];
+		uint32_t second = bytes[1];
+		uint32_t more = first >> 7;
+
+		if ((more & (second >> 7)) == 0) {
+			uint32_t mask = 0u - more;
+			uint32_t two = ((first & 0x7F) << 7) | second;
+			cursor.advance(1 + more);
+			return (first & ~mask) | (two & mask);
+		}
+
+		uint64_t acc = ((first & 0x7F) << 7) | (second & 0x7F);
+		for (int i = 2; i != 4; ++i) {
+			acc = (acc << 7) | (bytes[i] & 0x7F);
+			if ((bytes[i] >> 7) == 0) {
+				cursor.advance(i + 1);
+				return acc;
+			}
+		}
+
+		throw ParseError(cursor.offset(), "variable length integer exceeds four bytes");
+	}
+
+	/// <summary>
+	/// Decodes up to <paramref name="count" /> consecutive integers into <paramref name="out" />
+	/// and returns how many were decoded; fewer than requested only if the buffer runs out.
+	/// Runs of single-byte integers are widened sixteen at a time where SSE2 is available.
+	/// </summary>
+	size_t read_variable_length_integers(Cursor & in, uint64_t* out, size_t count);
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,209 @@
+#ifndef COMBINATORS_H
+#define COMBINATORS_H
+
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "midi/midi.h"
+#include "midi/note-collector.h"
+#include "midi/read-mtrk.h"
+#include "midi/status-table.h"
+
+namespace midi {
+	// Receivers built from other receivers at compile time. Combined, they form a single
+	// concrete type that the read_mtrk templates call directly, so the callbacks of the
+	// parts can be inlined into the decoding loop.
+	// A part passed as an lvalue is referred to and must outlive the combination;
+	// a part passed as an rvalue is moved into it. EventReceivers can be parts as well,
+	// they are then called virtually.
+
+	/// <summary>
+	/// Passes every event to each of its parts, in order.
+	/// </summary>
+	template<typename... RECEIVERS>
+	class Tee {
+	public:
+		explicit Tee(RECEIVERS&&... receivers) : m_receivers(std::forward<RECEIVERS>(receivers)...) { }
+
+		void note_on(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) {
+			each([&](auto& receiver) { receiver.note_on(dt, channel, note, velocity); });
+		}
+		void note_off(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) {
+			each([&](auto& receiver) { receiver.note_off(dt, channel, note, velocity); });
+		}
+		void polyphonic_key_pressure(Duration dt, Channel channel, NoteNumber note, uint8_t pressure) {
+			each([&](auto& receiver) { receiver.polyphonic_key_pressure(dt, channel, note, pressure); });
+		}
+		void control_change(Duration dt, Channel channel, uint8_t controller, uint8_t amount) {
+			each([&](auto& receiver) { receiver.control_change(dt, channel, controller, amount); });
+		}
+		void program_change(Duration dt, Channel channel, Instrument program) {
+			each([&](auto& receiver) { receiver.program_change(dt, channel, program); });
+		}
+		void channel_pressure(Duration dt, Channel channel, uint8_t pressure) {
+			each([&](auto& receiver) { receiver.channel_pressure(dt, channel, pressure); });
+		}
+		void pitch_wheel_change(Duration dt, Channel channel, uint16_t wheel) {
+			each([&](auto& receiver) { receiver.pitch_wheel_change(dt, channel, wheel); });
+		}
+		void meta(Duration dt, uint8_t type, io::ByteView data) {
+			each([&](auto& receiver) { receiver.meta(dt, type, data); });
+		}
+		void sysex(Duration dt, io::ByteView data) {
+			each([&](auto& receiver) { receiver.sysex(dt, data); });
+		}
+
+		EventMask interests() const {
+			return std::apply([](const auto&... receivers) { return EventMask((EventMask(0) | ... | decoding::interests_of(receivers))); }, m_receivers);
+		}
+
+	private:
+		template<typename F>
+		void each(F f) {
+			std::apply([&](auto&... receivers) { (f(receivers), ...); }, m_receivers);
+		}
+
+		std::tuple<RECEIVERS...> m_receivers;
+	};
+
+	template<typename... RECEIVERS>
+	Tee<RECEIVERS...> tee(RECEIVERS&&... receivers) {
+		return Tee<RECEIVERS...>(std::forward<RECEIVERS>(receivers)...);
+	}
+
+	/// <summary>
+	/// Base of the combinators that pass events on selectively. The delta times of
+	/// held back events are added to that of the next event passed on, as the readers
+	/// do for skipped events.
+	/// </summary>
+	template<typename RECEIVER>
+	class Selector {
+	protected:
+		explicit Selector(RECEIVER&& receiver) : m_receiver(std::forward<RECEIVER>(receiver)), m_held(0) { }
+
+		void hold(Duration dt) { m_held += value(dt); }
+
+		Duration pass(Duration dt) {
+			Duration result(m_held + value(dt));
+			m_held = 0;
+			return result;
+		}
+
+		RECEIVER m_receiver;
+		uint64_t m_held;
+	};
+
+	/// <summary>
+	/// Passes on the channel events of one channel, and all meta and sysex events.
+	/// </summary>
+	template<typename RECEIVER>
+	class ChannelFilter : Selector<RECEIVER> {
+	public:
+		ChannelFilter(Channel channel, RECEIVER&& receiver) : Selector<RECEIVER>(std::forward<RECEIVER>(receiver)), m_channel(channel) { }
+
+		void note_on(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) {
+			if (channel == m_channel) this->m_receiver.note_on(this->pass(dt), channel, note, velocity); else this->hold(dt);
+		}
+		void note_off(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) {
+			if (channel == m_channel) this->m_receiver.note_off(this->pass(dt), channel, note, velocity); else this->hold(dt);
+		}
+		void polyphonic_key_pressure(Duration dt, Channel channel, NoteNumber note, uint8_t pressure) {
+			if (channel == m_channel) this->m_receiver.polyphonic_key_pressure(this->pass(dt), channel, note, pressure); else this->hold(dt);
+		}
+		void control_change(Duration dt, Channel channel, uint8_t controller, uint8_t amount) {
+			if (channel == m_channel) this->m_receiver.control_change(this->pass(dt), channel, controller, amount); else this->hold(dt);
+		}
+		void program_change(Duration dt, Channel channel, Instrument program) {
+			if (channel == m_channel) this->m_receiver.program_change(this->pass(dt), channel, program); else this->hold(dt);
+		}
+		void channel_pressure(Duration dt, Channel channel, uint8_t pressure) {
+			if (channel == m_channel) this->m_receiver.channel_pressure(this->pass(dt), channel, pressure); else this->hold(dt);
+		}
+		void pitch_wheel_change(Duration dt, Channel channel, uint16_t wheel) {
+			if (channel == m_channel) this->m_receiver.pitch_wheel_change(this->pass(dt), channel, wheel); else this->hold(dt);
+		}
+		void meta(Duration dt, uint8_t type, io::ByteView data) {
+			this->m_receiver.meta(this->pass(dt), type, data);
+		}
+		void sysex(Duration dt, io::ByteView data) {
+			this->m_receiver.sysex(this->pass(dt), data);
+		}
+
+		EventMask interests() const { return decoding::interests_of(this->m_receiver); }
+
+	private:
+		Channel m_channel;
+	};
+
+	template<typename RECEIVER>
+	ChannelFilter<RECEIVER> filter_channel(Channel channel, RECEIVER&& receiver) {
+		return ChannelFilter<RECEIVER>(channel, std::forward<RECEIVER>(receiver));
+	}
+
+	/// <summary>
+	/// Passes on note on and note off events only.
+	/// </summary>
+	template<typename RECEIVER>
+	class NotesOnly : Selector<RECEIVER> {
+	public:
+		explicit NotesOnly(RECEIVER&& receiver) : Selector<RECEIVER>(std::forward<RECEIVER>(receiver)) { }
+
+		void note_on(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) { this->m_receiver.note_on(this->pass(dt), channel, note, velocity); }
+		void note_off(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) { this->m_receiver.note_off(this->pass(dt), channel, note, velocity); }
+		void polyphonic_key_pressure(Duration dt, Channel, NoteNumber, uint8_t) { this->hold(dt); }
+		void control_change(Duration dt, Channel, uint8_t, uint8_t) { this->hold(dt); }
+		void program_change(Duration dt, Channel, Instrument) { this->hold(dt); }
+		void channel_pressure(Duration dt, Channel, uint8_t) { this->hold(dt); }
+		void pitch_wheel_change(Duration dt, Channel, uint16_t) { this->hold(dt); }
+		void meta(Duration dt, uint8_t, io::ByteView) { this->hold(dt); }
+		void sysex(Duration dt, io::ByteView) { this->hold(dt); }
+
+		EventMask interests() const { return decoding::interests_of(this->m_receiver) & NOTE_EVENTS; }
+	};
+
+	template<typename RECEIVER>
+	NotesOnly<RECEIVER> only_notes(RECEIVER&& receiver) {
+		return NotesOnly<RECEIVER>(std::forward<RECEIVER>(receiver));
+	}
+
+	/// <summary>
+	/// Passes on every event with its delta time transformed by a function Duration -> Duration,
+	/// e.g. to rescale ticks.
+	/// </summary>
+	template<typename F, typename RECEIVER>
+	class TimeMap {
+	public:
+		TimeMap(F f, RECEIVER&& receiver) : m_f(f), m_receiver(std::forward<RECEIVER>(receiver)) { }
+
+		void note_on(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) { m_receiver.note_on(m_f(dt), channel, note, velocity); }
+		void note_off(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) { m_receiver.note_off(m_f(dt), channel, note, velocity); }
+		void polyphonic_key_pressure(Duration dt, Channel channel, NoteNumber note, uint8_t pressure) { m_receiver.polyphonic_key_pressure(m_f(dt), channel, note, pressure); }
+		void control_change(Duration dt, Channel channel, uint8_t controller, uint8_t amount) { m_receiver.control_change(m_f(dt), channel, controller, amount); }
+		void program_change(Duration dt, Channel channel, Instrument program) { m_receiver.program_change(m_f(dt), channel, program); }
+		void channel_pressure(Duration dt, Channel channel, uint8_t pressure) { m_receiver.channel_pressure(m_f(dt), channel, pressure); }
+		void pitch_wheel_change(Duration dt, Channel channel, uint16_t wheel) { m_receiver.pitch_wheel_change(m_f(dt), channel, wheel); }
+		void meta(Duration dt, uint8_t type, io::ByteView data) { m_receiver.meta(m_f(dt), type, data); }
+		void sysex(Duration dt, io::ByteView data) { m_receiver.sysex(m_f(dt), data); }
+
+		EventMask interests() const { return decoding::interests_of(m_receiver); }
+
+	private:
+		F m_f;
+		RECEIVER m_receiver;
+	};
+
+	template<typename F, typename RECEIVER>
+	TimeMap<F, RECEIVER> map_time(F f, RECEIVER&& receiver) {
+		return TimeMap<F, RECEIVER>(f, std::forward<RECEIVER>(receiver));
+	}
+
+	/// <summary>
+	/// NoteCollector as a static receiver, to combine with others. Passes the same notes in the same order.
+	/// </summary>
+	template<typename SINK>
+	BasicNoteCollector<std::decay_t<SINK>> collect_notes(SINK&& sink) {
+		return BasicNoteCollector<std::decay_t<SINK>>(std::forward<SINK>(sink));
+	}
+}
+#endif
@@ -0,0 +1,108 @@
+#include "midi/event-batch.h"
+#include "midi/event-reader.h"
+#include "midi/read-mtrk.h"
+#include <algorithm>
+
+namespace midi {
+	namespace {
+		// Writes each event into the next row of a batch whose columns have been
+		// sized in advance, through EventEncoder
+		struct BatchAppender {
+			EventBatch& batch;
+			const uint8_t* base;
+			size_t row;
+
+			void add(Duration dt, EventKind kind, uint8_t channel, uint8_t data1, uint8_t data2, io::ByteView payload = io::ByteView()) {
+				batch.dt[row] = value(dt);
+				batch.kind[row] = kind;
+				batch.channel[row] = channel;
+				batch.data1[row] = data1;
+				batch.data2[row] = data2;
+				batch.payload_offset[row] = payload.empty() ? 0 : uint64_t(payload.data() - base);
+				batch.payload_size[row] = uint32_t(payload.size());
+				++row;
+			}
+
+			void add_payload(Duration dt, EventKind kind, uint8_t data1, io::ByteView payload) {
+				add(dt, kind, 0, data1, 0, payload);
+			}
+		};
+	}
+
+	void EventBatch::clear() {
+		dt.clear();
+		kind.clear();
+		channel.clear();
+		data1.clear();
+		data2.clear();
+		payload_offset.clear();
+		payload_size.clear();
+	}
+
+	void EventBatch::reserve(size_t n) {
+		dt.reserve(n);
+		kind.reserve(n);
+		channel.reserve(n);
+		data1.reserve(n);
+		data2.reserve(n);
+		payload_offset.reserve(n);
+		payload_size.reserve(n);
+	}
+
+	void EventBatch::resize(size_t n) {
+		dt.resize(n);
+		kind.resize(n);
+		channel.resize(n);
+		data1.resize(n);
+		data2.resize(n);
+		payload_offset.resize(n);
+		payload_size.resize(n);
+	}
+
+	TrackDecoder::TrackDecoder(io::Cursor& in, ChunkMode mode) :
+		m_in(&in), m_track(in), m_bounded(mode == ChunkMode::bounded), m_finished(false) {
+		if (m_bounded) {
+			m_track = decoding::take_mtrk_chunk(in);
+		}
+		else {
+			io::overlay<RAW_CHUNK_HEADER>(in);
+		}
+	}
+
+	size_t TrackDecoder::decode(EventBatch& batch, size_t max_events) {
+		// Rows are added a block at a time and the unused ones dropped afterwards
+		const size_t BLOCK = 4096;
+
+		// Lenient tracks are bounded by the end of the buffer, bounded ones by their chunk;
+		// either way the unchecked fast path applies
+		io::Cursor& in = source();
+		EventEncoder<BatchAppender> appender{ { batch, in.begin(), batch.size() } };
+		size_t n = 0;
+		while (n != max_events && !m_finished) {
+			size_t block = std::min(max_events - n, BLOCK);
+			batch.resize(appender.row + block);
+			try {
+				for (size_t i = 0; i != block && !m_finished; ++i) {
+					m_finished = !decoding::read_bounded_event(in, appender, m_state);
+					++n;
+				}
+			}
+			catch (...) {
+				// Keep only the events decoded before the error
+				batch.resize(appender.row);
+				throw;
+			}
+			batch.resize(appender.row);
+		}
+		return n;
+	}
+
+	EventBatch read_mtrk_batch(io::Cursor& in, ChunkMode mode) {
+		EventBatch batch;
+		TrackDecoder decoder(in, mode);
+		while (!decoder.finished()) {
+			decoder.decode(batch, SIZE_MAX);
+		}
+		return batch;
+	}
+}
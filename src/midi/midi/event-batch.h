@@ -0,0 +1,69 @@
+#ifndef EVENT_BATCH_H
+#define EVENT_BATCH_H
+
+#include <cstdint>
+#include <vector>
+#include "midi/midi.h"
+#include "midi/status-table.h"
+#include "io/cursor.h"
+
+namespace midi {
+	/// <summary>
+	/// Decoded events of a track, one column per field, for consumers that
+	/// process events in loops rather than through per-event callbacks.
+	/// Meta and sysex payloads are not copied; they are located in the parse buffer
+	/// by payload_offset, counted from the start of the buffer.
+	/// </summary>
+	struct EventBatch {
+		std::vector<uint64_t> dt;
+		std::vector<EventKind> kind;
+		std::vector<uint8_t> channel;
+		// Note, controller, program or pressure; the lower 7 bits of a pitch wheel change; the type of a meta event
+		std::vector<uint8_t> data1;
+		// Velocity, pressure or controller value; the upper 7 bits of a pitch wheel change
+		std::vector<uint8_t> data2;
+		std::vector<uint64_t> payload_offset;
+		std::vector<uint32_t> payload_size;
+
+		size_t size() const { return dt.size(); }
+		bool empty() const { return dt.empty(); }
+
+		void clear();
+		void reserve(size_t n);
+		void resize(size_t n);
+	};
+
+	/// <summary>
+	/// Decodes a track into batches of events, a number of events at a time.
+	/// In ChunkMode::bounded the constructor moves <paramref name="in" /> past the whole chunk;
+	/// in lenient mode <paramref name="in" /> advances as events are decoded and must outlive the decoder.
+	/// </summary>
+	class TrackDecoder {
+	public:
+		TrackDecoder(io::Cursor& in, ChunkMode mode = ChunkMode::lenient);
+
+		/// <summary>
+		/// Appends at most <paramref name="max_events" /> events to <paramref name="batch" />,
+		/// fewer only once End-of-Track is reached. Returns the number of events appended.
+		/// </summary>
+		size_t decode(EventBatch& batch, size_t max_events);
+
+		bool finished() const { return m_finished; }
+
+	private:
+		// The chunk itself in bounded mode, <paramref name="in" /> otherwise
+		io::Cursor& source() { return m_bounded ? m_track : *m_in; }
+
+		io::Cursor* m_in;
+		io::Cursor m_track;
+		decoding::TRACK_STATE m_state;
+		bool m_bounded;
+		bool m_finished;
+	};
+
+	/// <summary>
+	/// Decodes a whole track into a single batch.
+	/// </summary>
+	EventBatch read_mtrk_batch(io::Cursor& in, ChunkMode mode = ChunkMode::lenient);
+}
+#endif
@@ -0,0 +1,47 @@
+#include "midi/event-reader.h"
+#include "midi/read-mtrk.h"
+
+namespace midi {
+	namespace {
+		// Stores the single event it is passed, through EventEncoder
+		struct EventCapture {
+			TRACK_EVENT& event;
+
+			void add(Duration dt, EventKind kind, uint8_t channel, uint8_t data1, uint8_t data2, io::ByteView payload = io::ByteView()) {
+				event.dt = dt;
+				event.kind = kind;
+				event.channel = channel;
+				event.data1 = data1;
+				event.data2 = data2;
+				event.payload = payload;
+			}
+
+			void add_payload(Duration dt, EventKind kind, uint8_t data1, io::ByteView payload) {
+				add(dt, kind, 0, data1, 0, payload);
+			}
+		};
+	}
+
+	EventReader::EventReader(io::Cursor& in, ChunkMode mode) :
+		m_in(&in), m_track(in), m_bounded(mode == ChunkMode::bounded), m_time(0), m_count(0), m_finished(false) {
+		if (m_bounded) {
+			m_track = decoding::take_mtrk_chunk(in);
+		}
+		else {
+			io::overlay<RAW_CHUNK_HEADER>(in);
+		}
+	}
+
+	bool EventReader::next(TRACK_EVENT& event) {
+		if (m_finished) {
+			return false;
+		}
+
+		EventEncoder<EventCapture> capture{ { event } };
+		m_finished = !decoding::read_bounded_event(source(), capture, m_state);
+		m_time += event.dt;
+		event.time = m_time;
+		++m_count;
+		return true;
+	}
+}
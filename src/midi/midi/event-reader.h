@@ -0,0 +1,216 @@
+#ifndef EVENT_READER_H
+#define EVENT_READER_H
+
+#include <cstdint>
+#include <iterator>
+#include "midi/midi.h"
+#include "midi/primitives.h"
+#include "midi/status-table.h"
+#include "io/byte-view.h"
+#include "io/cursor.h"
+
+namespace midi {
+	/// <summary>
+	/// A decoded event. The fields mean the same as the columns of an EventBatch;
+	/// the payload of a meta or sysex event is viewed in the parse buffer.
+	/// </summary>
+	struct TRACK_EVENT {
+		Duration dt;
+		// Absolute, counted from the start of the track
+		Time time;
+		EventKind kind;
+		uint8_t channel;
+		uint8_t data1;
+		uint8_t data2;
+		io::ByteView payload;
+	};
+
+	/// <summary>
+	/// Passes <paramref name="event" /> to the matching callback of <paramref name="receiver" />.
+	/// </summary>
+	template<typename RECEIVER>
+	void dispatch(const TRACK_EVENT& event, RECEIVER& receiver) {
+		Channel channel(event.channel);
+
+		switch (event.kind) {
+		case EventKind::note_off:
+			receiver.note_off(event.dt, channel, NoteNumber(event.data1), event.data2);
+			break;
+		case EventKind::note_on:
+			receiver.note_on(event.dt, channel, NoteNumber(event.data1), event.data2);
+			break;
+		case EventKind::polyphonic_key_pressure:
+			receiver.polyphonic_key_pressure(event.dt, channel, NoteNumber(event.data1), event.data2);
+			break;
+		case EventKind::control_change:
+			receiver.control_change(event.dt, channel, event.data1, event.data2);
+			break;
+		case EventKind::program_change:
+			receiver.program_change(event.dt, channel, Instrument(event.data1));
+			break;
+		case EventKind::channel_pressure:
+			receiver.channel_pressure(event.dt, channel, event.data1);
+			break;
+		case EventKind::pitch_wheel_change:
+			receiver.pitch_wheel_change(event.dt, channel, uint16_t(event.data1 | (event.data2 << 7)));
+			break;
+		case EventKind::meta:
+			receiver.meta(event.dt, event.data1, event.payload);
+			break;
+		case EventKind::sysex:
+			receiver.sysex(event.dt, event.payload);
+			break;
+		default:
+			break;
+		}
+	}
+
+	/// <summary>
+	/// Receiver turning each callback back into the (kind, channel, data1, data2) encoding
+	/// of TRACK_EVENT, the inverse of dispatch(). Events are passed on to
+	/// <c>add(Duration, EventKind, uint8_t channel, uint8_t data1, uint8_t data2)</c> of ADD,
+	/// meta and sysex events to <c>add_payload(Duration, EventKind, uint8_t data1, io::ByteView)</c>.
+	/// ADD is a base, so its state stays accessible through the encoder.
+	/// </summary>
+	template<typename ADD>
+	struct EventEncoder : ADD {
+		void note_on(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) {
+			this->add(dt, EventKind::note_on, value(channel), value(note), velocity);
+		}
+		void note_off(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) {
+			this->add(dt, EventKind::note_off, value(channel), value(note), velocity);
+		}
+		void polyphonic_key_pressure(Duration dt, Channel channel, NoteNumber note, uint8_t pressure) {
+			this->add(dt, EventKind::polyphonic_key_pressure, value(channel), value(note), pressure);
+		}
+		void control_change(Duration dt, Channel channel, uint8_t controller, uint8_t amount) {
+			this->add(dt, EventKind::control_change, value(channel), controller, amount);
+		}
+		void program_change(Duration dt, Channel channel, Instrument program) {
+			this->add(dt, EventKind::program_change, value(channel), value(program), 0);
+		}
+		void channel_pressure(Duration dt, Channel channel, uint8_t pressure) {
+			this->add(dt, EventKind::channel_pressure, value(channel), pressure, 0);
+		}
+		void pitch_wheel_change(Duration dt, Channel channel, uint16_t wheel) {
+			this->add(dt, EventKind::pitch_wheel_change, value(channel), uint8_t(wheel & 0x7F), uint8_t(wheel >> 7));
+		}
+		void meta(Duration dt, uint8_t type, io::ByteView data) {
+			this->add_payload(dt, EventKind::meta, type, data);
+		}
+		void sysex(Duration dt, io::ByteView data) {
+			this->add_payload(dt, EventKind::sysex, 0, data);
+		}
+	};
+
+	struct EVENT_COUNT {
+		uint64_t count = 0;
+
+		void add(Duration, EventKind, uint8_t, uint8_t, uint8_t) { ++count; }
+		void add_payload(Duration, EventKind, uint8_t, io::ByteView) { ++count; }
+	};
+
+	/// <summary>
+	/// Counts the events; combine it with the receivers that handle them.
+	/// </summary>
+	typedef EventEncoder<EVENT_COUNT> EventCounter;
+
+	/// <summary>
+	/// Decodes a track one event at a time, only as far as the caller asks,
+	/// e.g. to stop after the first seconds of a long track.
+	/// Ownership of <paramref name="in" /> follows the rules of TrackDecoder.
+	/// </summary>
+	class EventReader {
+	public:
+		class iterator;
+
+		EventReader(io::Cursor& in, ChunkMode mode = ChunkMode::lenient);
+
+		/// <summary>
+		/// Decodes the next event into <paramref name="event" />.
+		/// Returns false, leaving <paramref name="event" /> untouched, once End-of-Track has been returned.
+		/// </summary>
+		bool next(TRACK_EVENT& event);
+
+		bool finished() const { return m_finished; }
+
+		/// <summary>
+		/// Number of events returned so far.
+		/// </summary>
+		size_t count() const { return m_count; }
+
+		/// <summary>
+		/// Time of the last event returned.
+		/// </summary>
+		Time time() const { return m_time; }
+
+		/// <summary>
+		/// Iterates over the events not yet returned. Iterators share the reader's position.
+		/// </summary>
+		iterator begin();
+		iterator end();
+
+	private:
+		// The chunk itself in bounded mode, <paramref name="in" /> otherwise
+		io::Cursor& source() { return m_bounded ? m_track : *m_in; }
+
+		io::Cursor* m_in;
+		io::Cursor m_track;
+		decoding::TRACK_STATE m_state;
+		bool m_bounded;
+		Time m_time;
+		size_t m_count;
+		bool m_finished;
+	};
+
+	class EventReader::iterator {
+	public:
+		typedef std::input_iterator_tag iterator_category;
+		typedef TRACK_EVENT value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const TRACK_EVENT* pointer;
+		typedef const TRACK_EVENT& reference;
+
+		iterator() : m_reader(nullptr) { }
+		explicit iterator(EventReader* reader) : m_reader(reader) { ++*this; }
+
+		reference operator *() const { return m_event; }
+		pointer operator ->() const { return &m_event; }
+
+		iterator& operator ++() {
+			if (!m_reader->next(m_event)) {
+				m_reader = nullptr;
+			}
+			return *this;
+		}
+
+		bool operator ==(const iterator& other) const { return m_reader == other.m_reader; }
+		bool operator !=(const iterator& other) const { return m_reader != other.m_reader; }
+
+	private:
+		EventReader* m_reader;
+		TRACK_EVENT m_event;
+	};
+
+	inline EventReader::iterator EventReader::begin() { return iterator(this); }
+	inline EventReader::iterator EventReader::end() { return iterator(); }
+
+	/// <summary>
+	/// Passes the events of a track to <paramref name="receiver" /> up to and including the last
+	/// one at or before <paramref name="until" />, and at most <paramref name="max_events" /> events.
+	/// Decoding stops there; the rest of the track is not read.
+	/// Returns the number of events passed on.
+	/// </summary>
+	template<typename RECEIVER>
+	size_t read_mtrk_until(io::Cursor& in, RECEIVER& receiver, Time until, size_t max_events = SIZE_MAX, ChunkMode mode = ChunkMode::lenient) {
+		EventReader reader(in, mode);
+		TRACK_EVENT event;
+		size_t n = 0;
+		while (n != max_events && reader.next(event) && event.time <= until) {
+			dispatch(event, receiver);
+			++n;
+		}
+		return n;
+	}
+}
+#endif
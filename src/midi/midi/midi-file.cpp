@@ -0,0 +1,128 @@
+#include "midi/midi-file.h"
+#include "midi/read-mtrk.h"
+#include "midi/event-reader.h"
+#include "io/parse-error.h"
+#include "util/check-size.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace midi {
+	namespace {
+		// Appends each event of a track as a record, with payloads copied into
+		// the side buffer, through EventEncoder
+		struct RecordAppender {
+			std::vector<EVENT_RECORD>& events;
+			std::vector<uint8_t>& payloads;
+			uint64_t time;
+
+			void add(Duration dt, EventKind kind, uint8_t channel, uint8_t data1, uint8_t data2, uint32_t payload = 0) {
+				time += value(dt);
+				events.push_back(EVENT_RECORD{ time, kind, channel, data1, data2, payload });
+			}
+
+			uint32_t store(io::ByteView data) {
+				size_t offset = payloads.size();
+				if (offset + sizeof(uint32_t) + data.size() > UINT32_MAX) {
+					throw io::ParseError(offset, "meta and sysex payloads exceed 4 GiB");
+				}
+				uint32_t size = uint32_t(data.size());
+				payloads.resize(offset + sizeof(size) + size);
+				std::memcpy(payloads.data() + offset, &size, sizeof(size));
+				if (size != 0) {
+					std::memcpy(payloads.data() + offset + sizeof(size), data.data(), size);
+				}
+				return uint32_t(offset);
+			}
+
+			void add_payload(Duration dt, EventKind kind, uint8_t data1, io::ByteView data) {
+				add(dt, kind, 0, data1, 0, store(data));
+			}
+		};
+	}
+
+	size_t TrackView::find(Time time) const {
+		const EVENT_RECORD* found = std::lower_bound(m_begin, m_end, value(time), [](const EVENT_RECORD& event, uint64_t t) {
+			return event.time < t;
+		});
+		return found - m_begin;
+	}
+
+	Time TrackView::duration() const {
+		return Time(empty() ? 0 : m_end[-1].time);
+	}
+
+	TrackView MidiFile::track(size_t i) const {
+		const EVENT_RECORD* events = m_events.data();
+		return TrackView(events + m_track_starts.at(i), events + m_track_starts.at(i + 1));
+	}
+
+	io::ByteView MidiFile::payload(const EVENT_RECORD& event) const {
+		uint32_t size;
+		std::memcpy(&size, m_payloads.data() + event.payload, sizeof(size));
+		return io::ByteView(m_payloads.data() + event.payload + sizeof(size), size);
+	}
+
+	void MidiFile::replay(size_t track, EventReceiver& receiver) const {
+		uint64_t previous = 0;
+		for (const EVENT_RECORD& record : this->track(track)) {
+			TRACK_EVENT event;
+			event.dt = Duration(record.time - previous);
+			event.time = Time(record.time);
+			event.kind = record.kind;
+			event.channel = record.channel;
+			event.data1 = record.data1;
+			event.data2 = record.data2;
+			if (record.kind == EventKind::meta || record.kind == EventKind::sysex) {
+				event.payload = payload(record);
+			}
+			previous = record.time;
+
+			dispatch(event, receiver);
+		}
+	}
+
+	size_t MidiFile::memory_usage() const {
+		return m_events.capacity() * sizeof(EVENT_RECORD)
+			+ m_track_starts.capacity() * sizeof(size_t)
+			+ m_payloads.capacity();
+	}
+
+	MidiFile read_midi_file(io::Cursor& in, ChunkMode mode) {
+		check_size<EVENT_RECORD, 16>();
+
+		MidiFile file;
+		EventEncoder<RecordAppender> appender{ { file.m_events, file.m_payloads, 0 } };
+
+		if (mode == ChunkMode::bounded) {
+			CHUNK_INDEX index = index_chunks(in);
+			file.m_mthd = index.mthd;
+			for (const CHUNK_INFO& track : index.tracks) {
+				appender.time = 0;
+				io::Cursor chunk = in.at(track.offset);
+				read_mtrk(chunk, appender, ChunkMode::bounded);
+				file.m_track_starts.push_back(file.m_events.size());
+			}
+			in = in.at(index.end);
+		}
+		else {
+			read_mthd(in, &file.m_mthd);
+			for (int i = 0; i < file.m_mthd.ntracks; i++) {
+				appender.time = 0;
+				read_mtrk(in, appender, mode);
+				file.m_track_starts.push_back(file.m_events.size());
+			}
+		}
+
+		file.m_events.shrink_to_fit();
+		file.m_track_starts.shrink_to_fit();
+		file.m_payloads.shrink_to_fit();
+		return file;
+	}
+
+	MidiFile read_midi_file(std::istream& in) {
+		std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		io::Cursor cursor(buffer);
+		return read_midi_file(cursor);
+	}
+}
@@ -0,0 +1,104 @@
+#ifndef MIDI_FILE_H
+#define MIDI_FILE_H
+
+#include <cstdint>
+#include <istream>
+#include <vector>
+#include "midi/midi.h"
+#include "midi/primitives.h"
+#include "midi/status-table.h"
+#include "io/byte-view.h"
+#include "io/cursor.h"
+
+namespace midi {
+	/// <summary>
+	/// A single event of a MidiFile, 16 bytes regardless of its kind.
+	/// Fields have the same meaning as the columns of an EventBatch.
+	/// </summary>
+	struct EVENT_RECORD {
+		// Absolute, counted from the start of the track
+		uint64_t time;
+		EventKind kind;
+		uint8_t channel;
+		uint8_t data1;
+		uint8_t data2;
+		// Meta and sysex only: location of the payload in MidiFile's side buffer
+		uint32_t payload;
+	};
+
+	/// <summary>
+	/// Events of one track of a MidiFile, ordered by time.
+	/// </summary>
+	class TrackView {
+	public:
+		typedef const EVENT_RECORD* iterator;
+
+		TrackView(const EVENT_RECORD* begin, const EVENT_RECORD* end) : m_begin(begin), m_end(end) { }
+
+		iterator begin() const { return m_begin; }
+		iterator end() const { return m_end; }
+		size_t size() const { return m_end - m_begin; }
+		bool empty() const { return m_begin == m_end; }
+		const EVENT_RECORD& operator [](size_t i) const { return m_begin[i]; }
+
+		/// <summary>
+		/// Index of the first event at or after <paramref name="time" />, size() if there is none.
+		/// </summary>
+		size_t find(Time time) const;
+
+		/// <summary>
+		/// Time of the last event, usually End-of-Track; zero for an empty track.
+		/// </summary>
+		Time duration() const;
+
+	private:
+		const EVENT_RECORD* m_begin;
+		const EVENT_RECORD* m_end;
+	};
+
+	/// <summary>
+	/// Parsed contents of a MIDI file, kept compact so that many files can stay in memory:
+	/// the events of all tracks share one array of EVENT_RECORDs, and the meta and sysex
+	/// payloads share one side buffer. Unknown chunks are not kept.
+	/// </summary>
+	class MidiFile {
+	public:
+		MidiFile() : m_mthd(), m_track_starts(1, 0) { }
+
+		const MTHD& mthd() const { return m_mthd; }
+
+		size_t track_count() const { return m_track_starts.size() - 1; }
+		TrackView track(size_t i) const;
+
+		/// <summary>
+		/// Total number of events over all tracks.
+		/// </summary>
+		size_t event_count() const { return m_events.size(); }
+
+		io::ByteView payload(const EVENT_RECORD& event) const;
+
+		/// <summary>
+		/// Passes the events of a track to <paramref name="receiver" /> as read_mtrk would.
+		/// </summary>
+		void replay(size_t track, EventReceiver& receiver) const;
+
+		/// <summary>
+		/// Bytes of heap memory held, excluding the object itself.
+		/// </summary>
+		size_t memory_usage() const;
+
+		friend MidiFile read_midi_file(io::Cursor&, ChunkMode);
+
+	private:
+		MTHD m_mthd;
+		std::vector<EVENT_RECORD> m_events;
+		// Index of the first event of each track, followed by event_count()
+		std::vector<size_t> m_track_starts;
+		// Per payload: its size as a uint32_t in native byte order, followed by its bytes
+		std::vector<uint8_t> m_payloads;
+	};
+
+	MidiFile read_midi_file(io::Cursor& in, ChunkMode mode = ChunkMode::lenient);
+	MidiFile read_midi_file(std::istream& in);
+}
+#endif
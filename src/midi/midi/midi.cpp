@@ -1,20 +1,46 @@
 #include "midi.h"
+#include "combinators.h"
 #include "../io/read.h"
 #include "../io/endianness.h"
 #include "../io/vli.h"
+#include "../io/parse-error.h"
+#include "../util/check-size.h"
+#include "../util/parallel.h"
+#include <cstring>
+#include <iterator>
 
 namespace midi {
+	void read_chunk_header(io::Cursor& in, CHUNK_HEADER* header) {
+		check_size<RAW_CHUNK_HEADER, sizeof(CHUNK_HEADER)>();
+
+		const RAW_CHUNK_HEADER* raw = io::overlay<RAW_CHUNK_HEADER>(in);
+		std::memcpy(header->id, raw->id, sizeof(header->id));
+		header->size = raw->size;
+	}
+
 	void read_chunk_header(std::istream& in, CHUNK_HEADER* header) {
-		io::read_to(in, header);
-		io::switch_endianness(&header->size);
+		uint8_t buffer[sizeof(CHUNK_HEADER)];
+		io::read_to(in, buffer, sizeof(buffer));
+		io::Cursor cursor(buffer, sizeof(buffer));
+		read_chunk_header(cursor, header);
+	}
+
+	void read_mthd(io::Cursor& in, MTHD* mthd) {
+		check_size<RAW_MTHD, sizeof(MTHD)>();
+
+		const RAW_MTHD* raw = io::overlay<RAW_MTHD>(in);
+		std::memcpy(mthd->header.id, raw->header.id, sizeof(mthd->header.id));
+		mthd->header.size = raw->header.size;
+		mthd->type = raw->type;
+		mthd->ntracks = raw->ntracks;
+		mthd->division = raw->division;
 	}
 
 	void read_mthd(std::istream& in, MTHD* mthd) {
-		io::read_to(in, mthd);
-		io::switch_endianness(&mthd->header.size);
-		io::switch_endianness(&mthd->type);
-		io::switch_endianness(&mthd->ntracks);
-		io::switch_endianness(&mthd->division);
+		uint8_t buffer[sizeof(MTHD)];
+		io::read_to(in, buffer, sizeof(buffer));
+		io::Cursor cursor(buffer, sizeof(buffer));
+		read_mthd(cursor, mthd);
 	}
 
 	std::string header_id(CHUNK_HEADER header) {
@@ -25,48 +51,6 @@ namespace midi {
 		return res;
 	}
 
-	bool is_sysex_event(uint8_t byte) {
-		return (byte == 0xF0) | (byte == 0xF7);
-	};
-	bool is_meta_event(uint8_t byte) {
-		return byte == 0xFF;
-	};
-	bool is_midi_event(uint8_t byte) {
-		return (byte >= 0x80) & (byte < 0xF0);
-	};
-	bool is_running_status(uint8_t byte) {
-		return byte < 0x80;
-	};
-
-	uint8_t extract_midi_event_type(uint8_t status) {
-		return status >> 4;
-	};
-	Channel extract_midi_event_channel(uint8_t status) {
-		return Channel(status & 0x0F);
-	};
-
-	bool is_note_off(uint8_t status) {
-		return status == 0x08;
-	};
-	bool is_note_on(uint8_t status) {
-		return status == 0x09;
-	};
-	bool is_polyphonic_key_pressure(uint8_t status) {
-		return status == 0x0A;
-	};
-	bool is_control_change(uint8_t status) {
-		return status == 0x0B;
-	};
-	bool is_program_change(uint8_t status) {
-		return status == 0x0C;
-	};
-	bool is_channel_pressure(uint8_t status) {
-		return status == 0x0D;
-	};
-	bool is_pitch_wheel_change(uint8_t status) {
-		return status == 0x0E;
-	};
-
 	bool NOTE::operator ==(const NOTE other) const {
 		return this->note_number == other.note_number &&
 			this->start == other.start &&
@@ -82,83 +66,20 @@ namespace midi {
 			this->instrument != other.instrument;
 	}
 
-	void read_mtrk(std::istream& in, EventReceiver& receiver) {
-		CHUNK_HEADER header;
-		read_chunk_header(in, &header);
-		bool has_next = true;
-
-		uint8_t previousID;
-		uint8_t firstBytes;
-
-		while (has_next) {
-			Duration duration(io::read_variable_length_integer(in));
-			uint8_t identifier = io::read<uint8_t>(in);
+	void EventReceiver::meta(Duration dt, uint8_t type, io::ByteView data) {
+		this->meta(dt, type, data.copy(), data.size());
+	}
 
-			if (is_running_status(identifier)) {
-				firstBytes = identifier;
-				identifier = previousID;
-			}
-			else {
-				firstBytes = io::read<uint8_t>(in);
-			}
-			if (is_meta_event(identifier)) {
-				uint8_t type = firstBytes;
-				uint64_t length(io::read_variable_length_integer(in));
-				std::unique_ptr<uint8_t[]> data = io::read_array<uint8_t>(in, length);
-				receiver.meta(duration, type, std::move(data), length);
-				if (type == 0x2F) {
-					// end of track
-					has_next = false;
-				}
-			}
-			else if (is_sysex_event(identifier)) {
-				in.putback(firstBytes);
-				uint64_t length(io::read_variable_length_integer(in));
-				std::unique_ptr<uint8_t[]> data = io::read_array<uint8_t>(in, length);
-				receiver.sysex(duration, std::move(data), length);
-			}
-			else if (is_midi_event(identifier)) {
-				uint8_t midiEventType = extract_midi_event_type(identifier);
-				Channel channel = extract_midi_event_channel(identifier);
-				if (is_note_off(midiEventType)) {
-					uint8_t note = firstBytes;
-					uint8_t velocity = io::read<uint8_t>(in);
-					receiver.note_off(duration, channel, NoteNumber(note), velocity);
-				}
-				else if (is_note_on(midiEventType)) {
-					uint8_t note = firstBytes;
-					uint8_t velocity = io::read<uint8_t>(in);
-					receiver.note_on(duration, channel, NoteNumber(note), velocity);
-				}
-				else if (is_polyphonic_key_pressure(midiEventType)) {
-					uint8_t note = firstBytes;
-					uint8_t pressure = io::read<uint8_t>(in);
-					receiver.polyphonic_key_pressure(duration, channel, NoteNumber(note), pressure);
-				}
-				else if (is_control_change(midiEventType)) {
-					uint8_t controller = firstBytes;
-					uint8_t value = io::read<uint8_t>(in);
-					receiver.control_change(duration, channel, controller, value);
-				}
-				else if (is_program_change(midiEventType)) {
-					uint8_t program = firstBytes;
-					receiver.program_change(duration, channel, Instrument(program));
-				}
-				else if (is_channel_pressure(midiEventType)) {
-					uint8_t pressure = firstBytes;
-					receiver.channel_pressure(duration, channel, pressure);
-				}
-				else if (is_pitch_wheel_change(midiEventType)) {
-					uint8_t lower = firstBytes;
-					uint8_t upper = io::read<uint8_t>(in);
-					uint16_t lower_upper = lower | (upper << 7);
-					receiver.pitch_wheel_change(duration, channel, lower_upper);
-				}
-				previousID = identifier;
-			}
+	void EventReceiver::sysex(Duration dt, io::ByteView data) {
+		this->sysex(dt, data.copy(), data.size());
+	}
 
-		}
+	void read_mtrk(io::Cursor& in, EventReceiver& receiver, ChunkMode mode) {
+		decoding::read_mtrk_chunk(in, receiver, mode);
+	}
 
+	void read_mtrk(std::istream& in, EventReceiver& receiver) {
+		decoding::read_mtrk_chunk(in, receiver);
 	}
 
 
@@ -237,6 +158,22 @@ namespace midi {
 
 	}
 
+	void ChannelNoteCollector::meta(Duration dt, uint8_t type, io::ByteView data)
+	{
+		this->current += dt;
+	}
+
+	void ChannelNoteCollector::sysex(Duration dt, io::ByteView data)
+	{
+		this->current += dt;
+	}
+
+	EventMask ChannelNoteCollector::interests() const
+	{
+		// Time is kept by the delta times, which the readers carry over from skipped events
+		return NOTE_EVENTS | event_mask(EventKind::program_change);
+	}
+
 	void EventMulticaster::note_on(Duration dt, Channel channel, NoteNumber note, uint8_t velocity)
 	{
 		for (std::shared_ptr<EventReceiver> receiver : this->receivers) {
@@ -287,17 +224,39 @@ namespace midi {
 	}
 
 	void EventMulticaster::meta(Duration dt, uint8_t type, std::unique_ptr<uint8_t[]> data, uint64_t data_size)
+	{
+		// Every receiver needs the payload, so it cannot be moved into the first one
+		this->meta(dt, type, io::ByteView(data.get(), size_t(data_size)));
+	}
+
+	void EventMulticaster::sysex(Duration dt, std::unique_ptr<uint8_t[]> data, uint64_t data_size)
+	{
+		this->sysex(dt, io::ByteView(data.get(), size_t(data_size)));
+	}
+
+	void EventMulticaster::meta(Duration dt, uint8_t type, io::ByteView data)
 	{
 		for (std::shared_ptr<EventReceiver> receiver : this->receivers) {
-			receiver->meta(dt, type, std::move(data), data_size);
+			receiver->meta(dt, type, data);
 		}
 	}
 
-	void EventMulticaster::sysex(Duration dt, std::unique_ptr<uint8_t[]> data, uint64_t data_size)
+	void EventMulticaster::sysex(Duration dt, io::ByteView data)
 	{
 		for (std::shared_ptr<EventReceiver> receiver : this->receivers) {
-			receiver->sysex(dt, std::move(data), data_size);
+			receiver->sysex(dt, data);
+		}
+	}
+
+	EventMask EventMulticaster::interests() const
+	{
+		// Receivers are passed the events any of them wants, which may include
+		// events they did not ask for
+		EventMask mask = 0;
+		for (const std::shared_ptr<EventReceiver>& receiver : this->receivers) {
+			mask |= receiver->interests();
 		}
+		return mask;
 	}
 
 	void NoteCollector::note_on(Duration dt, Channel channel, NoteNumber note, uint8_t velocity)
@@ -344,18 +303,140 @@ namespace midi {
 	{
 		this->multicaster.sysex(dt, std::move(data), data_size);
 	}
-	std::vector<NOTE> read_notes(std::istream& in)
+
+	void NoteCollector::meta(Duration dt, uint8_t type, io::ByteView data)
+	{
+		this->multicaster.meta(dt, type, data);
+	}
+
+	void NoteCollector::sysex(Duration dt, io::ByteView data)
+	{
+		this->multicaster.sysex(dt, data);
+	}
+
+	EventMask NoteCollector::interests() const
 	{
+		return this->multicaster.interests();
+	}
+
+	void read_notes(io::Cursor& in, std::vector<NOTE>& notes, ChunkMode mode)
+	{
+		// One collector for all tracks, reset in between
+		auto collector = collect_notes([&notes](const NOTE& note) { notes.push_back(note); });
+
+		if (mode == ChunkMode::bounded) {
+			CHUNK_INDEX index = index_chunks(in);
+			uint64_t mtrk_bytes = 0;
+			for (const CHUNK_INFO& track : index.tracks) {
+				mtrk_bytes += track.header.size;
+			}
+			notes.reserve(notes.size() + estimate_note_count(mtrk_bytes));
+
+			for (const CHUNK_INFO& track : index.tracks) {
+				collector.reset();
+				io::Cursor chunk = in.at(track.offset);
+				read_mtrk(chunk, collector, ChunkMode::bounded);
+			}
+			in = in.at(index.end);
+			return;
+		}
+
 		MTHD methhead;
 		read_mthd(in, &methhead);
-		std::vector<NOTE> notes;
+		notes.reserve(notes.size() + estimate_note_count(in.remaining()));
 		for (int i = 0; i < methhead.ntracks; i++)
 		{
-			NoteCollector collector =
-				NoteCollector([&notes](const NOTE& note)
-			{ notes.push_back(note); });
-			read_mtrk(in, collector);
+			collector.reset();
+			read_mtrk(in, collector, mode);
 		}
+	}
+
+	std::vector<NOTE> read_notes(io::Cursor& in, ChunkMode mode)
+	{
+		std::vector<NOTE> notes;
+		read_notes(in, notes, mode);
+		return notes;
+	}
+
+	std::vector<NOTE> read_notes(std::istream& in)
+	{
+		std::vector<uint8_t> buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		io::Cursor cursor(buffer);
+		return read_notes(cursor);
+	}
+
+	bool is_mtrk(const CHUNK_HEADER& header) {
+		return std::memcmp(header.id, "MTrk", sizeof(header.id)) == 0;
+	}
+
+	CHUNK_INDEX index_chunks(const io::Cursor& file, bool record_truncated) {
+		io::Cursor in = file;
+		CHUNK_INDEX index;
+		read_mthd(in, &index.mthd);
+		if (index.mthd.header.size > 6) {
+			// Later revisions of the standard may extend the header
+			in.skip(index.mthd.header.size - 6);
+		}
+
+		while (in.remaining() >= sizeof(RAW_CHUNK_HEADER)) {
+			CHUNK_INFO chunk;
+			chunk.offset = in.offset();
+			read_chunk_header(in, &chunk.header);
+			if (chunk.header.size > in.remaining() && record_truncated) {
+				index.truncated = chunk;
+				index.end = chunk.offset;
+				return index;
+			}
+			if (chunk.header.size > in.remaining()) {
+				throw io::ParseError(chunk.offset, header_id(chunk.header) + " chunk of " + std::to_string(chunk.header.size) + " bytes exceeds the " + std::to_string(in.remaining()) + " bytes left");
+			}
+			in.advance(chunk.header.size);
+
+			index.chunks.push_back(chunk);
+			if (is_mtrk(chunk.header)) {
+				index.tracks.push_back(chunk);
+			}
+		}
+
+		index.end = in.offset();
+		return index;
+	}
+
+	void read_track(const io::Cursor& file, const CHUNK_INDEX& index, size_t track, EventReceiver& receiver) {
+		io::Cursor in = file.at(index.tracks.at(track).offset);
+		read_mtrk(in, receiver, ChunkMode::bounded);
+	}
+
+	std::vector<NOTE> read_track_notes(const io::Cursor& file, const CHUNK_INDEX& index, size_t track) {
+		std::vector<NOTE> notes;
+		notes.reserve(estimate_note_count(index.tracks.at(track).header.size));
+		auto collector = collect_notes([&notes](const NOTE& note) { notes.push_back(note); });
+		io::Cursor in = file.at(index.tracks.at(track).offset);
+		read_mtrk(in, collector, ChunkMode::bounded);
+		return notes;
+	}
+
+	std::vector<NOTE> read_notes_parallel(io::Cursor& in, unsigned nthreads) {
+		CHUNK_INDEX index = index_chunks(in);
+		const io::Cursor& file = in;
+
+		std::vector<std::vector<NOTE>> per_track(index.tracks.size());
+		parallel_for(per_track.size(), nthreads == 0 ? default_thread_count() : nthreads, [&](size_t track) {
+			per_track[track] = read_track_notes(file, index, track);
+		});
+
+		// Concatenating in track order yields the serial reader's order
+		size_t total = 0;
+		for (const std::vector<NOTE>& notes : per_track) {
+			total += notes.size();
+		}
+		std::vector<NOTE> notes;
+		notes.reserve(total);
+		for (const std::vector<NOTE>& track : per_track) {
+			notes.insert(notes.end(), track.begin(), track.end());
+		}
+
+		in = in.at(index.end);
 		return notes;
 	}
-}
\ No newline at end of file
+}
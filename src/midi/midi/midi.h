@@ -2,11 +2,18 @@
 #ifndef MIDI_H
 #define MIDI_H
 
+#include <algorithm>
 #include <cstdint>
+#include <istream>
 #include <ostream>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <vector>
 #include "primitives.h"
+#include "midi/status-table.h"
+#include "io/cursor.h"
+#include "io/endianness.h"
 
 namespace midi {
 	struct CHUNK_HEADER {
@@ -15,6 +22,7 @@ namespace midi {
 	};
 
 	void read_chunk_header(std::istream&, CHUNK_HEADER*);
+	void read_chunk_header(io::Cursor&, CHUNK_HEADER*);
 
 	std::string header_id(CHUNK_HEADER);
 
@@ -28,23 +36,70 @@ namespace midi {
 	};
 #pragma pack(pop)
 
+#pragma pack(push,1)
+	/// <summary>
+	/// Chunk header as stored in the file. Can be overlaid on a buffer with io::overlay.
+	/// </summary>
+	struct RAW_CHUNK_HEADER {
+		char id[4];
+		io::be_uint32 size;
+	};
+
+	/// <summary>
+	/// MThd as stored in the file. Can be overlaid on a buffer with io::overlay.
+	/// </summary>
+	struct RAW_MTHD {
+		RAW_CHUNK_HEADER header;
+		io::be_uint16 type;
+		io::be_uint16 ntracks;
+		io::be_uint16 division;
+	};
+#pragma pack(pop)
+
 	void read_mthd(std::istream&, MTHD*);
+	void read_mthd(io::Cursor&, MTHD*);
 
-	bool is_sysex_event(uint8_t);
-	bool is_meta_event(uint8_t);
-	bool is_midi_event(uint8_t);
-	bool is_running_status(uint8_t);
+	inline bool is_sysex_event(uint8_t byte) {
+		return (byte == 0xF0) | (byte == 0xF7);
+	}
+	inline bool is_meta_event(uint8_t byte) {
+		return byte == 0xFF;
+	}
+	inline bool is_midi_event(uint8_t byte) {
+		return (byte >= 0x80) & (byte < 0xF0);
+	}
+	inline bool is_running_status(uint8_t byte) {
+		return byte < 0x80;
+	}
 
-	uint8_t extract_midi_event_type(uint8_t);
-	Channel extract_midi_event_channel(uint8_t);
+	inline uint8_t extract_midi_event_type(uint8_t status) {
+		return status >> 4;
+	}
+	inline Channel extract_midi_event_channel(uint8_t status) {
+		return Channel(status & 0x0F);
+	}
 
-	bool is_note_off(uint8_t);
-	bool is_note_on(uint8_t);
-	bool is_polyphonic_key_pressure(uint8_t);
-	bool is_control_change(uint8_t);
-	bool is_program_change(uint8_t);
-	bool is_channel_pressure(uint8_t);
-	bool is_pitch_wheel_change(uint8_t);
+	inline bool is_note_off(uint8_t status) {
+		return status == 0x08;
+	}
+	inline bool is_note_on(uint8_t status) {
+		return status == 0x09;
+	}
+	inline bool is_polyphonic_key_pressure(uint8_t status) {
+		return status == 0x0A;
+	}
+	inline bool is_control_change(uint8_t status) {
+		return status == 0x0B;
+	}
+	inline bool is_program_change(uint8_t status) {
+		return status == 0x0C;
+	}
+	inline bool is_channel_pressure(uint8_t status) {
+		return status == 0x0D;
+	}
+	inline bool is_pitch_wheel_change(uint8_t status) {
+		return status == 0x0E;
+	}
 
 	struct EventReceiver {
 		virtual void note_on(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) = 0;
@@ -56,9 +111,36 @@ namespace midi {
 		virtual void pitch_wheel_change(Duration dt, Channel channel, uint16_t value) = 0;
 		virtual void meta(Duration dt, uint8_t type, std::unique_ptr<uint8_t[]> data, uint64_t data_size) = 0;
 		virtual void sysex(Duration dt, std::unique_ptr<uint8_t[]> data, uint64_t data_size) = 0;
+
+		/// <summary>
+		/// Called by the readers for every meta and sysex event. The payload is only valid
+		/// during the call. By default it is copied and passed to the owning overloads;
+		/// receivers that do not keep payloads override these to avoid the allocation.
+		/// </summary>
+		virtual void meta(Duration dt, uint8_t type, io::ByteView data);
+		virtual void sysex(Duration dt, io::ByteView data);
+
+		/// <summary>
+		/// Kinds of events this receiver handles, asked once per track. The readers skip
+		/// other events without calling back or allocating; their delta times are added
+		/// to that of the next event passed on.
+		/// </summary>
+		virtual EventMask interests() const { return ALL_EVENTS; }
+	};
+
+	/// <summary>
+	/// How buffer-based readers treat the size announced in a chunk header.
+	/// </summary>
+	enum class ChunkMode {
+		// Decode until End-of-Track, regardless of the announced size
+		lenient,
+		// Validate the chunk against the buffer once and decode inside it;
+		// overruns and a missing End-of-Track raise io::ParseError
+		bounded
 	};
 
 	void read_mtrk(std::istream&, EventReceiver&);
+	void read_mtrk(io::Cursor&, EventReceiver&, ChunkMode mode = ChunkMode::lenient);
 
 	struct NOTE {
 		NoteNumber note_number;
@@ -114,6 +196,9 @@ namespace midi {
 		virtual void pitch_wheel_change(Duration dt, Channel channel, uint16_t value) override;
 		virtual void meta(Duration dt, uint8_t type, std::unique_ptr<uint8_t[]> data, uint64_t data_size) override;
 		virtual void sysex(Duration dt, std::unique_ptr<uint8_t[]> data, uint64_t data_size) override;
+		virtual void meta(Duration dt, uint8_t type, io::ByteView data) override;
+		virtual void sysex(Duration dt, io::ByteView data) override;
+		virtual EventMask interests() const override;
 	};
 
 	struct EventMulticaster : public EventReceiver {
@@ -134,6 +219,9 @@ namespace midi {
 		virtual void pitch_wheel_change(Duration dt, Channel channel, uint16_t value) override;
 		virtual void meta(Duration dt, uint8_t type, std::unique_ptr<uint8_t[]> data, uint64_t data_size) override;
 		virtual void sysex(Duration dt, std::unique_ptr<uint8_t[]> data, uint64_t data_size) override;
+		virtual void meta(Duration dt, uint8_t type, io::ByteView data) override;
+		virtual void sysex(Duration dt, io::ByteView data) override;
+		virtual EventMask interests() const override;
 	};
 
 	struct NoteCollector : EventReceiver
@@ -167,9 +255,84 @@ namespace midi {
 		virtual void pitch_wheel_change(Duration dt, Channel channel, uint16_t value) override;
 		virtual void meta(Duration dt, uint8_t type, std::unique_ptr<uint8_t[]> data, uint64_t data_size) override;
 		virtual void sysex(Duration dt, std::unique_ptr<uint8_t[]> data, uint64_t data_size) override;
+		virtual void meta(Duration dt, uint8_t type, io::ByteView data) override;
+		virtual void sysex(Duration dt, io::ByteView data) override;
+		virtual EventMask interests() const override;
 	};
 
 	std::vector<NOTE> read_notes(std::istream&);
+	std::vector<NOTE> read_notes(io::Cursor&, ChunkMode mode = ChunkMode::lenient);
+
+	/// <summary>
+	/// Appends the notes of a file to <paramref name="notes" />, reserving room for them once up front.
+	/// </summary>
+	void read_notes(io::Cursor&, std::vector<NOTE>& notes, ChunkMode mode = ChunkMode::lenient);
+
+	/// <summary>
+	/// Most notes the reservation for <paramref name="mtrk_bytes" /> bytes of MTrk chunks covers.
+	/// </summary>
+	const size_t MAX_RESERVED_NOTES = size_t(1) << 16;
+
+	/// <summary>
+	/// Number of notes to reserve room for in <paramref name="mtrk_bytes" /> bytes of MTrk chunks.
+	/// This is an upper bound rather than an estimate: a note takes at least six bytes, a note on and
+	/// a note off with one byte delta times and running status, so only notes struck again before their
+	/// note off can exceed it. Files full of other events, e.g. controllers, hold far fewer notes, so the
+	/// bound is capped at MAX_RESERVED_NOTES and larger outputs grow as they are filled.
+	/// </summary>
+	inline size_t estimate_note_count(uint64_t mtrk_bytes) { return size_t(std::min<uint64_t>(mtrk_bytes / 6, MAX_RESERVED_NOTES)); }
+
+	/// <summary>
+	/// A chunk located by index_chunks.
+	/// </summary>
+	struct CHUNK_INFO {
+		CHUNK_HEADER header;
+		// Position of the chunk header, counted from the start of the buffer
+		size_t offset;
+	};
+
+	bool is_mtrk(const CHUNK_HEADER&);
+
+	/// <summary>
+	/// Layout of a MIDI file, built from the chunk sizes alone without decoding any events.
+	/// </summary>
+	struct CHUNK_INDEX {
+		MTHD mthd;
+		// Every chunk after MThd in file order, including types this reader does not know
+		std::vector<CHUNK_INFO> chunks;
+		// The MTrk chunks among them; a file's tracks are numbered in this order
+		std::vector<CHUNK_INFO> tracks;
+		// Position just past the last chunk
+		size_t end;
+		// The chunk that runs past the end of the buffer, where the scan stopped;
+		// only recorded on request, and in neither chunks nor tracks
+		std::optional<CHUNK_INFO> truncated;
+	};
+
+	/// <summary>
+	/// Scans the chunks of the file starting at the cursor's position.
+	/// A chunk that runs past the end of the buffer raises io::ParseError, or, with
+	/// <paramref name="record_truncated" />, ends the scan and is kept in CHUNK_INDEX::truncated,
+	/// so that the chunks before it can still be read.
+	/// Trailing bytes too short to form a chunk header are ignored.
+	/// </summary>
+	CHUNK_INDEX index_chunks(const io::Cursor& file, bool record_truncated = false);
+
+	/// <summary>
+	/// Decodes a single track, bounded by its chunk. <paramref name="file" /> must be
+	/// (a cursor on) the buffer the index was built from. Independent tracks can be
+	/// read concurrently.
+	/// </summary>
+	void read_track(const io::Cursor& file, const CHUNK_INDEX& index, size_t track, EventReceiver& receiver);
+	std::vector<NOTE> read_track_notes(const io::Cursor& file, const CHUNK_INDEX& index, size_t track);
+
+	/// <summary>
+	/// Like read_notes in ChunkMode::bounded, but decodes the tracks on <paramref name="nthreads" />
+	/// threads (0 picks one per core). The notes are returned in the same order as the serial reader.
+	/// </summary>
+	std::vector<NOTE> read_notes_parallel(io::Cursor&, unsigned nthreads = 0);
 }
 
+#include "midi/read-mtrk.h"
+
 #endif
@@ -0,0 +1,299 @@
+#include "midi/note-cache.h"
+#include "io/mapped-file.h"
+#include "util/check-size.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+namespace midi {
+	namespace {
+		namespace fs = std::filesystem;
+
+		// "MNC1" read as a little-endian uint32_t; other byte orders do not match
+		const uint32_t CACHE_MAGIC = 0x31434E4D;
+		// Bump whenever the layout or the meaning of the notes changes
+		const uint32_t CACHE_VERSION = 2;
+		const char* const CACHE_EXTENSION = ".notes";
+
+		// Start of an entry. It is followed by the start and duration columns, the times of the tempo
+		// changes, their tempos and then the note number, velocity, instrument and channel columns.
+		struct CACHE_HEADER {
+			uint32_t magic;
+			uint32_t version;
+			uint64_t source_hash;
+			uint64_t source_size;
+			uint64_t notes;
+			// Events the notes were read from, for statistics
+			uint64_t events;
+			uint32_t tempo_changes;
+			uint16_t division;
+			// The ChunkMode the notes were read in
+			uint16_t mode;
+		};
+
+		uint64_t entry_size(uint64_t notes, uint64_t tempo_changes) {
+			return sizeof(CACHE_HEADER) + notes * (2 * sizeof(uint64_t) + 4) + tempo_changes * (sizeof(uint64_t) + sizeof(uint32_t));
+		}
+
+		uint64_t mix(uint64_t x) {
+			x ^= x >> 33;
+			x *= 0xFF51AFD7ED558CCD;
+			x ^= x >> 33;
+			x *= 0xC4CEB9FE1A85EC53;
+			x ^= x >> 33;
+			return x;
+		}
+
+		template<typename T>
+		void write_column(std::ofstream& out, const T* data, size_t n) {
+			out.write(reinterpret_cast<const char*>(data), std::streamsize(n * sizeof(T)));
+		}
+
+		template<typename T>
+		void read_column(const uint8_t*& in, std::vector<T>& column, size_t n) {
+			column.resize(n);
+			if (n != 0) {
+				std::memcpy(column.data(), in, n * sizeof(T));
+				in += n * sizeof(T);
+			}
+		}
+
+		// Unique among the threads and processes that may write the same entry at once
+		fs::path temporary_name(const fs::path& entry) {
+			static std::atomic<uint64_t> counter{ 0 };
+			std::ostringstream suffix;
+			suffix << ".tmp" << std::hash<std::thread::id>()(std::this_thread::get_id())
+				<< '-' << std::chrono::steady_clock::now().time_since_epoch().count()
+				<< '-' << counter++;
+			fs::path result = entry;
+			return result += suffix.str();
+		}
+	}
+
+	uint64_t content_hash(const uint8_t* data, size_t size) {
+		const uint64_t K = 0x9E3779B97F4A7C15;
+		uint64_t hash = mix(size ^ K);
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8) {
+			uint64_t word;
+			std::memcpy(&word, data + i, 8);
+			hash ^= mix(word);
+			hash = (hash << 27 | hash >> 37) * K;
+		}
+		uint64_t tail = 0;
+		if (i != size) {
+			std::memcpy(&tail, data + i, size - i);
+		}
+		return mix(hash ^ mix(tail));
+	}
+
+	NoteCache::NoteCache(const std::string& directory, uint64_t max_bytes) : m_directory(directory), m_max_bytes(max_bytes), m_stored(0) {
+		check_size<CACHE_HEADER, 48>();
+		fs::create_directories(m_directory);
+		if (m_max_bytes != 0) {
+			m_stored = size();
+		}
+	}
+
+	fs::path NoteCache::entry(uint64_t hash, ChunkMode mode) const {
+		std::ostringstream name;
+		name << std::hex << std::setw(16) << std::setfill('0') << hash << (mode == ChunkMode::bounded ? "-bounded" : "") << CACHE_EXTENSION;
+		return m_directory / name.str();
+	}
+
+	bool NoteCache::load(const io::Cursor& file, NoteTable& notes, TempoMap& tempo_map, ChunkMode mode) const {
+		return load(content_hash(file.position(), file.remaining()), file, notes, tempo_map, mode);
+	}
+
+	bool NoteCache::load(uint64_t hash, const io::Cursor& file, NoteTable& notes, TempoMap& tempo_map, ChunkMode mode, uint64_t* events) const {
+		fs::path path = entry(hash, mode);
+		std::error_code error;
+		if (!fs::exists(path, error)) {
+			return false;
+		}
+
+		bool valid = false;
+		try {
+			io::MappedFile cached(path.string());
+			CACHE_HEADER header;
+			if (cached.size() >= sizeof(header)) {
+				std::memcpy(&header, cached.data(), sizeof(header));
+				valid = header.magic == CACHE_MAGIC && header.version == CACHE_VERSION
+					&& header.source_hash == hash && header.source_size == file.remaining() && header.mode == uint16_t(mode)
+					&& header.notes <= cached.size() && header.tempo_changes <= cached.size()
+					&& entry_size(header.notes, header.tempo_changes) == cached.size();
+			}
+
+			if (valid) {
+				size_t n = size_t(header.notes);
+				const uint8_t* in = cached.data() + sizeof(header);
+				read_column(in, notes.start, n);
+				read_column(in, notes.duration, n);
+
+				std::vector<uint64_t> times;
+				std::vector<uint32_t> tempos;
+				read_column(in, times, header.tempo_changes);
+				read_column(in, tempos, header.tempo_changes);
+				std::vector<TEMPO_CHANGE> changes;
+				for (size_t i = 0; i != times.size(); ++i) {
+					changes.push_back(TEMPO_CHANGE{ Time(times[i]), tempos[i] });
+				}
+				tempo_map = TempoMap(header.division, std::move(changes));
+
+				read_column(in, notes.note_number, n);
+				read_column(in, notes.velocity, n);
+				read_column(in, notes.instrument, n);
+				read_column(in, notes.channel, n);
+				if (events != nullptr) {
+					*events = header.events;
+				}
+			}
+		}
+		catch (const std::system_error&) {
+			// Removed by another process in the meantime
+			return false;
+		}
+		catch (const std::invalid_argument&) {
+			// Division the tempo map rejects
+			valid = false;
+		}
+
+		if (!valid) {
+			notes.clear();
+			fs::remove(path, error);
+			return false;
+		}
+		// Mark as recently used for eviction
+		fs::last_write_time(path, fs::file_time_type::clock::now(), error);
+		return true;
+	}
+
+	bool NoteCache::store(const io::Cursor& file, const NoteTable& notes, const TempoMap& tempo_map, ChunkMode mode, uint64_t events) const {
+		return store(content_hash(file.position(), file.remaining()), file, notes, tempo_map, mode, events);
+	}
+
+	bool NoteCache::store(uint64_t hash, const io::Cursor& file, const NoteTable& notes, const TempoMap& tempo_map, ChunkMode mode, uint64_t events) const {
+		std::vector<TEMPO_CHANGE> changes = tempo_map.changes();
+		uint64_t size = entry_size(notes.size(), changes.size());
+		if (m_max_bytes != 0 && size > m_max_bytes) {
+			return false;
+		}
+
+		CACHE_HEADER header = { CACHE_MAGIC, CACHE_VERSION, hash, file.remaining(), notes.size(), events, uint32_t(changes.size()), tempo_map.division(), uint16_t(mode) };
+		std::vector<uint64_t> times(changes.size());
+		std::vector<uint32_t> tempos(changes.size());
+		for (size_t i = 0; i != changes.size(); ++i) {
+			times[i] = value(changes[i].time);
+			tempos[i] = changes[i].microseconds_per_quarter;
+		}
+
+		fs::path path = entry(hash, mode);
+		fs::path temporary = temporary_name(path);
+		{
+			std::ofstream out(temporary, std::ofstream::binary);
+			write_column(out, &header, 1);
+			write_column(out, notes.start.data(), notes.size());
+			write_column(out, notes.duration.data(), notes.size());
+			write_column(out, times.data(), times.size());
+			write_column(out, tempos.data(), tempos.size());
+			write_column(out, notes.note_number.data(), notes.size());
+			write_column(out, notes.velocity.data(), notes.size());
+			write_column(out, notes.instrument.data(), notes.size());
+			write_column(out, notes.channel.data(), notes.size());
+			out.close();
+			if (!out) {
+				std::error_code error;
+				fs::remove(temporary, error);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		fs::rename(temporary, path, error);
+		if (error) {
+			fs::remove(temporary, error);
+			return false;
+		}
+		// A replaced entry is counted twice, which at worst brings the next scan forward
+		if (m_max_bytes != 0 && (m_stored += size) > m_max_bytes) {
+			trim();
+		}
+		return true;
+	}
+
+	bool NoteCache::read_notes(const io::Cursor& file, NoteTable& notes, TempoMap& tempo_map, ChunkMode mode, uint64_t* events) const {
+		uint64_t hash = content_hash(file.position(), file.remaining());
+		if (load(hash, file, notes, tempo_map, mode, events)) {
+			return true;
+		}
+
+		io::Cursor in = file;
+		notes.clear();
+		uint64_t count = 0;
+		midi::read_notes(in, notes, tempo_map, mode, count);
+		store(hash, file, notes, tempo_map, mode, count);
+		if (events != nullptr) {
+			*events = count;
+		}
+		return false;
+	}
+
+	void NoteCache::trim() const {
+		if (m_max_bytes == 0) {
+			return;
+		}
+
+		struct ENTRY {
+			fs::file_time_type used;
+			uint64_t size;
+			fs::path path;
+		};
+		std::vector<ENTRY> entries;
+		uint64_t total = 0;
+		std::error_code error;
+		for (const fs::directory_entry& file : fs::directory_iterator(m_directory, error)) {
+			if (file.path().extension() == CACHE_EXTENSION) {
+				std::error_code time_error, size_error;
+				ENTRY entry = { file.last_write_time(time_error), file.file_size(size_error), file.path() };
+				if (!time_error && !size_error) {
+					entries.push_back(entry);
+					total += entry.size;
+				}
+			}
+		}
+		if (total <= m_max_bytes) {
+			m_stored = total;
+			return;
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const ENTRY& a, const ENTRY& b) { return a.used < b.used; });
+		for (const ENTRY& entry : entries) {
+			if (total <= m_max_bytes) {
+				break;
+			}
+			// Another process may have removed it already
+			fs::remove(entry.path, error);
+			total -= entry.size;
+		}
+		m_stored = total;
+	}
+
+	uint64_t NoteCache::size() const {
+		uint64_t total = 0;
+		std::error_code error;
+		for (const fs::directory_entry& file : fs::directory_iterator(m_directory, error)) {
+			if (file.path().extension() == CACHE_EXTENSION) {
+				uint64_t size = file.file_size(error);
+				total += error ? 0 : size;
+			}
+		}
+		return total;
+	}
+}
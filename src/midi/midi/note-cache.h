@@ -0,0 +1,98 @@
+#ifndef NOTE_CACHE_H
+#define NOTE_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include "midi/note-table.h"
+#include "midi/tempo-map.h"
+#include "io/cursor.h"
+
+namespace midi {
+	/// <summary>
+	/// Hash of <paramref name="size" /> bytes, to recognize a file by its contents.
+	/// Fast rather than cryptographic: it guards against stale cache entries, not against forgery.
+	/// </summary>
+	uint64_t content_hash(const uint8_t* data, size_t size);
+
+	/// <summary>
+	/// Directory of parsed notes, one file per MIDI file and ChunkMode, named after the hash of its
+	/// contents and the mode, which may yield different notes or an error for the same file.
+	/// An entry holds the NoteTable columns and the tempo map one after the other, in native
+	/// byte order and with the 64-bit columns aligned, so that it can be mapped and copied out
+	/// without decoding. Loading an entry costs a pass to hash the MIDI file and a check of the
+	/// entry's header and size. Damaged or foreign entries count as misses and are removed.
+	/// With a size limit, storing evicts the least recently used entries; a hit counts as a use.
+	/// The cache keeps a running total of the entry sizes and only scans the directory once it
+	/// passes the limit, so entries stored by other processes are noticed at that scan.
+	/// Several threads or processes may share a directory: entries are written under a temporary
+	/// name and renamed into place.
+	/// </summary>
+	class NoteCache {
+	public:
+		/// <summary>
+		/// Creates <paramref name="directory" /> if needed. A <paramref name="max_bytes" /> of 0 means no limit.
+		/// Raises std::filesystem::filesystem_error if the directory cannot be created.
+		/// </summary>
+		explicit NoteCache(const std::string& directory, uint64_t max_bytes = 0);
+
+		const std::filesystem::path& directory() const { return m_directory; }
+		uint64_t max_bytes() const { return m_max_bytes; }
+
+		/// <summary>
+		/// Replaces <paramref name="notes" /> and <paramref name="tempo_map" /> by those cached for the
+		/// MIDI file <paramref name="file" /> read in <paramref name="mode" />, whose cursor must be at
+		/// the start of the file. Returns false on a miss.
+		/// </summary>
+		bool load(const io::Cursor& file, NoteTable& notes, TempoMap& tempo_map, ChunkMode mode = ChunkMode::lenient) const;
+
+		/// <summary>
+		/// load for a file whose content_hash is already known to be <paramref name="hash" />.
+		/// Unless null, <paramref name="events" /> receives the number of events stored with the notes.
+		/// </summary>
+		bool load(uint64_t hash, const io::Cursor& file, NoteTable& notes, TempoMap& tempo_map, ChunkMode mode = ChunkMode::lenient, uint64_t* events = nullptr) const;
+
+		/// <summary>
+		/// Caches the notes and tempo map of <paramref name="file" /> read in <paramref name="mode" />,
+		/// with the number of <paramref name="events" /> they were read from, then trims the cache if it is
+		/// over its limit. Returns false, leaving the cache as it was, if the entry cannot be written or is
+		/// larger than the limit.
+		/// </summary>
+		bool store(const io::Cursor& file, const NoteTable& notes, const TempoMap& tempo_map, ChunkMode mode = ChunkMode::lenient, uint64_t events = 0) const;
+
+		/// <summary>
+		/// store for a file whose content_hash is already known to be <paramref name="hash" />.
+		/// </summary>
+		bool store(uint64_t hash, const io::Cursor& file, const NoteTable& notes, const TempoMap& tempo_map, ChunkMode mode = ChunkMode::lenient, uint64_t events = 0) const;
+
+		/// <summary>
+		/// read_notes through the cache: loads the notes of <paramref name="file" /> if they are
+		/// cached, and otherwise reads and stores them. Returns whether they came from the cache.
+		/// Unless null, <paramref name="events" /> receives the number of events of the file either way.
+		/// </summary>
+		bool read_notes(const io::Cursor& file, NoteTable& notes, TempoMap& tempo_map, ChunkMode mode = ChunkMode::lenient, uint64_t* events = nullptr) const;
+
+		/// <summary>
+		/// Removes least recently used entries until the cache is within its limit. Scans the directory.
+		/// </summary>
+		void trim() const;
+
+		/// <summary>
+		/// Total size in bytes of the entries.
+		/// </summary>
+		uint64_t size() const;
+
+		/// <summary>
+		/// Path of the entry for a MIDI file whose content_hash is <paramref name="hash" />, read in <paramref name="mode" />.
+		/// </summary>
+		std::filesystem::path entry(uint64_t hash, ChunkMode mode = ChunkMode::lenient) const;
+
+	private:
+		std::filesystem::path m_directory;
+		uint64_t m_max_bytes;
+		// Size of the entries at the last scan plus those stored since, an estimate between scans
+		mutable std::atomic<uint64_t> m_stored;
+	};
+}
+#endif
@@ -0,0 +1,107 @@
+#ifndef NOTE_COLLECTOR_H
+#define NOTE_COLLECTOR_H
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "midi/midi.h"
+#include "midi/status-table.h"
+
+namespace midi {
+	/// <summary>
+	/// Collects the notes of all channels in a single receiver, passing each to
+	/// <c>sink(const NOTE&amp;)</c>, or to <c>sink(const NOTE&amp;, Channel)</c> if the sink
+	/// takes the channel as well. Behaves like NoteCollector, but keeps the state of
+	/// every channel in flat arrays with one clock, so an event is handled once rather
+	/// than by 16 ChannelNoteCollectors, and the sink is called without type erasure.
+	/// </summary>
+	template<typename SINK>
+	class BasicNoteCollector {
+	public:
+		explicit BasicNoteCollector(SINK sink) : m_sink(std::move(sink)), m_time(0), m_starts(), m_instruments() {
+			std::fill(std::begin(m_velocities), std::end(m_velocities), RELEASED);
+		}
+
+		/// <summary>
+		/// Returns to the state of a new collector, to start on the next track.
+		/// Notes still sounding are dropped.
+		/// </summary>
+		void reset() {
+			m_time = Time(0);
+			std::fill(std::begin(m_velocities), std::end(m_velocities), RELEASED);
+			std::fill(std::begin(m_instruments), std::end(m_instruments), Instrument(0));
+		}
+
+		void note_on(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) {
+			if (velocity == 0) {
+				note_off(dt, channel, note, velocity);
+				return;
+			}
+
+			m_time += dt;
+			if (!in_range(channel, note)) {
+				return;
+			}
+			size_t key = index(channel, note);
+			if (m_velocities[key] != RELEASED) {
+				emit(channel, note, key);
+			}
+			m_starts[key] = m_time;
+			m_velocities[key] = velocity;
+		}
+
+		void note_off(Duration dt, Channel channel, NoteNumber note, uint8_t) {
+			m_time += dt;
+			if (!in_range(channel, note)) {
+				return;
+			}
+			size_t key = index(channel, note);
+			emit(channel, note, key);
+			m_velocities[key] = RELEASED;
+		}
+
+		void program_change(Duration dt, Channel channel, Instrument program) {
+			m_time += dt;
+			if (value(channel) < CHANNELS) {
+				m_instruments[value(channel)] = program;
+			}
+		}
+
+		void polyphonic_key_pressure(Duration dt, Channel, NoteNumber, uint8_t) { m_time += dt; }
+		void control_change(Duration dt, Channel, uint8_t, uint8_t) { m_time += dt; }
+		void channel_pressure(Duration dt, Channel, uint8_t) { m_time += dt; }
+		void pitch_wheel_change(Duration dt, Channel, uint16_t) { m_time += dt; }
+		void meta(Duration dt, uint8_t, io::ByteView) { m_time += dt; }
+		void sysex(Duration dt, io::ByteView) { m_time += dt; }
+
+		EventMask interests() const { return NOTE_EVENTS | event_mask(EventKind::program_change); }
+
+	private:
+		static constexpr unsigned CHANNELS = 16;
+		static constexpr unsigned NOTES = 128;
+		// Velocity of a note that is not sounding; real velocities are 7 bit
+		static constexpr uint16_t RELEASED = 128;
+
+		static bool in_range(Channel channel, NoteNumber note) { return value(channel) < CHANNELS && value(note) < NOTES; }
+		static size_t index(Channel channel, NoteNumber note) { return size_t(value(channel)) * NOTES + value(note); }
+
+		void emit(Channel channel, NoteNumber note, size_t key) {
+			NOTE result(note, m_starts[key], m_time - m_starts[key], uint8_t(m_velocities[key]), m_instruments[value(channel)]);
+			if constexpr (std::is_invocable_v<SINK&, const NOTE&, Channel>) {
+				m_sink(result, channel);
+			}
+			else {
+				m_sink(result);
+			}
+		}
+
+		SINK m_sink;
+		Time m_time;
+		// Per channel and note number: when the sounding note started and its velocity
+		Time m_starts[CHANNELS * NOTES];
+		uint16_t m_velocities[CHANNELS * NOTES];
+		Instrument m_instruments[CHANNELS];
+	};
+}
+#endif
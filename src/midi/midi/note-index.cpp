@@ -0,0 +1,115 @@
+#include "midi/note-index.h"
+#include <algorithm>
+#include <numeric>
+
+namespace midi {
+	namespace {
+		// Subtrees up to this level are scanned rather than descended
+		const int SCAN_LEVEL = 3;
+
+		struct FRAME {
+			int level;
+			uint64_t node;
+			// Whether the left subtree has been visited
+			bool left_done;
+		};
+	}
+
+	NoteIndex::NoteIndex(const NoteTable& notes) : m_start(notes.start), m_root_level(-1) {
+		std::vector<uint64_t> ends(notes.size());
+		for (size_t i = 0; i != notes.size(); ++i) {
+			ends[i] = notes.start[i] + notes.duration[i];
+		}
+		build(std::move(ends));
+	}
+
+	NoteIndex::NoteIndex(const std::vector<NOTE>& notes) : m_start(notes.size()), m_root_level(-1) {
+		std::vector<uint64_t> ends(notes.size());
+		for (size_t i = 0; i != notes.size(); ++i) {
+			m_start[i] = value(notes[i].start);
+			ends[i] = value(notes[i].start + notes[i].duration);
+		}
+		build(std::move(ends));
+	}
+
+	void NoteIndex::build(std::vector<uint64_t> ends) {
+		size_t n = m_start.size();
+		m_row.resize(n);
+		std::iota(m_row.begin(), m_row.end(), size_t(0));
+		std::stable_sort(m_row.begin(), m_row.end(), [this](size_t a, size_t b) { return m_start[a] < m_start[b]; });
+
+		std::vector<uint64_t> starts(n);
+		m_end.resize(n);
+		for (size_t i = 0; i != n; ++i) {
+			starts[i] = m_start[m_row[i]];
+			m_end[i] = ends[m_row[i]];
+		}
+		m_start.swap(starts);
+		m_max_end = m_end;
+		if (n == 0) {
+			return;
+		}
+
+		// Bottom up, level by level. A node whose right subtree lies partly past the end
+		// takes the maximum of the last complete subtree instead
+		uint64_t last_node = 0, last_max = 0;
+		for (uint64_t i = 0; i < n; i += 2) {
+			last_node = i;
+			last_max = m_max_end[i];
+		}
+		int level = 1;
+		for (; (uint64_t(1) << level) <= n; ++level) {
+			uint64_t half = uint64_t(1) << (level - 1);
+			for (uint64_t i = (half << 1) - 1; i < n; i += half << 2) {
+				uint64_t left = m_max_end[i - half];
+				uint64_t right = i + half < n ? m_max_end[i + half] : last_max;
+				m_max_end[i] = std::max(m_end[i], std::max(left, right));
+			}
+			// Move to the parent of the last node
+			last_node = (last_node >> level & 1) ? last_node - half : last_node + half;
+			if (last_node < n) {
+				last_max = std::max(last_max, m_max_end[last_node]);
+			}
+		}
+		m_root_level = level - 1;
+	}
+
+	void NoteIndex::overlapping(Time from, Time to, std::vector<size_t>& rows) const {
+		uint64_t first = value(from), last = value(to);
+		uint64_t n = m_start.size();
+		if (n == 0) {
+			return;
+		}
+
+		// Depth first, left to right, so rows come in order of start
+		FRAME stack[64];
+		int top = 0;
+		stack[top++] = FRAME{ m_root_level, (uint64_t(1) << m_root_level) - 1, false };
+		while (top != 0) {
+			FRAME frame = stack[--top];
+			if (frame.level <= SCAN_LEVEL) {
+				uint64_t begin = frame.node >> frame.level << frame.level;
+				uint64_t end = std::min(n, begin + (uint64_t(1) << (frame.level + 1)) - 1);
+				for (uint64_t i = begin; i < end && m_start[i] < last; ++i) {
+					if (m_end[i] > first) {
+						rows.push_back(m_row[i]);
+					}
+				}
+			}
+			else if (!frame.left_done) {
+				// The left child may lie past the end; its subtree can still hold nodes
+				uint64_t left = frame.node - (uint64_t(1) << (frame.level - 1));
+				stack[top++] = FRAME{ frame.level, frame.node, true };
+				if (left >= n || m_max_end[left] > first) {
+					stack[top++] = FRAME{ frame.level - 1, left, false };
+				}
+			}
+			else if (frame.node < n && m_start[frame.node] < last) {
+				if (m_end[frame.node] > first) {
+					rows.push_back(m_row[frame.node]);
+				}
+				stack[top++] = FRAME{ frame.level - 1, frame.node + (uint64_t(1) << (frame.level - 1)), false };
+			}
+		}
+	}
+}
@@ -0,0 +1,49 @@
+#ifndef NOTE_INDEX_H
+#define NOTE_INDEX_H
+
+#include <cstdint>
+#include <vector>
+#include "midi/midi.h"
+#include "midi/note-table.h"
+
+namespace midi {
+	/// <summary>
+	/// Finds the notes sounding during a time window in time logarithmic in the number
+	/// of notes plus the number found. Built once over the output of read_notes.
+	/// The notes are kept sorted by start and read as an implicit binary search tree:
+	/// the node at position i is at level k if i ends in exactly k one bits, and each
+	/// node stores the latest end in its subtree, so subtrees ending before the window are skipped.
+	/// </summary>
+	class NoteIndex {
+	public:
+		explicit NoteIndex(const NoteTable& notes);
+		explicit NoteIndex(const std::vector<NOTE>& notes);
+
+		size_t size() const { return m_start.size(); }
+
+		/// <summary>
+		/// Appends to <paramref name="rows" /> the positions, in the notes the index was built
+		/// from, of the notes overlapping [from, to): those starting before <paramref name="to" />
+		/// and ending after <paramref name="from" />. They come in order of start.
+		/// </summary>
+		void overlapping(Time from, Time to, std::vector<size_t>& rows) const;
+
+		/// <summary>
+		/// Appends the positions of the notes sounding at <paramref name="time" />.
+		/// </summary>
+		void at(Time time, std::vector<size_t>& rows) const { overlapping(time, time + Duration(1), rows); }
+
+	private:
+		void build(std::vector<uint64_t> ends);
+
+		// Per note, in order of start
+		std::vector<uint64_t> m_start;
+		std::vector<uint64_t> m_end;
+		std::vector<size_t> m_row;
+		// Latest end in the subtree of each node
+		std::vector<uint64_t> m_max_end;
+		// Level of the root
+		int m_root_level;
+	};
+}
+#endif
@@ -0,0 +1,115 @@
+#include "midi/note-merger.h"
+#include <algorithm>
+
+namespace midi {
+	TrackNoteCursor::TrackNoteCursor(const io::Cursor& chunk) :
+		m_chunk(chunk), m_reader(m_chunk, ChunkMode::bounded), m_collector(PendingSink{ this }), m_sequence(0), m_keep(true) {
+		fill();
+	}
+
+	void TrackNoteCursor::advance() {
+		std::pop_heap(m_pending.begin(), m_pending.end(), later);
+		m_pending.pop_back();
+		fill();
+	}
+
+	bool TrackNoteCursor::later(const PENDING_NOTE& a, const PENDING_NOTE& b) {
+		return a.note.start != b.note.start ? a.note.start > b.note.start : a.sequence > b.sequence;
+	}
+
+	void TrackNoteCursor::finish(const NOTE& note, Channel channel) {
+		if (!m_keep) {
+			return;
+		}
+		m_pending.push_back(PENDING_NOTE{ note, channel, m_sequence++ });
+		std::push_heap(m_pending.begin(), m_pending.end(), later);
+	}
+
+	bool TrackNoteCursor::track(const TRACK_EVENT& event) {
+		bool on = event.kind == EventKind::note_on && event.data2 != 0;
+		if ((!on && event.kind != EventKind::note_on && event.kind != EventKind::note_off) || event.data1 >= 128) {
+			return true;
+		}
+
+		auto sounding = std::find_if(m_sounding.begin(), m_sounding.end(), [&event](const SOUNDING_NOTE& note) {
+			return note.channel == event.channel && note.note_number == event.data1;
+		});
+		if (on) {
+			if (sounding != m_sounding.end()) {
+				sounding->start = event.time;
+			}
+			else {
+				m_sounding.push_back(SOUNDING_NOTE{ event.channel, event.data1, event.time });
+			}
+		}
+		else if (sounding != m_sounding.end()) {
+			*sounding = m_sounding.back();
+			m_sounding.pop_back();
+		}
+		else {
+			// Note off on a key that is not sounding
+			return false;
+		}
+		return true;
+	}
+
+	bool TrackNoteCursor::releasable() const {
+		if (m_pending.empty()) {
+			return false;
+		}
+		if (m_reader.finished()) {
+			return true;
+		}
+		// Notes yet to come start at the current time or later
+		Time earliest = m_reader.time();
+		for (const SOUNDING_NOTE& note : m_sounding) {
+			earliest = std::min(earliest, note.start);
+		}
+		return m_pending.front().note.start <= earliest;
+	}
+
+	void TrackNoteCursor::fill() {
+		TRACK_EVENT event;
+		while (!releasable() && m_reader.next(event)) {
+			m_keep = track(event);
+			dispatch(event, m_collector);
+		}
+	}
+
+	NoteMerger::NoteMerger(const io::Cursor& file) {
+		CHUNK_INDEX index = index_chunks(file);
+		for (const CHUNK_INFO& track : index.tracks) {
+			m_tracks.push_back(std::make_unique<TrackNoteCursor>(file.at(track.offset)));
+			if (!m_tracks.back()->at_end()) {
+				m_heap.push_back(m_tracks.size() - 1);
+			}
+		}
+		std::make_heap(m_heap.begin(), m_heap.end(), [this](size_t a, size_t b) { return later(a, b); });
+	}
+
+	void NoteMerger::advance() {
+		auto compare = [this](size_t a, size_t b) { return later(a, b); };
+		std::pop_heap(m_heap.begin(), m_heap.end(), compare);
+		TrackNoteCursor& track = *m_tracks[m_heap.back()];
+		track.advance();
+		if (track.at_end()) {
+			m_heap.pop_back();
+		}
+		else {
+			std::push_heap(m_heap.begin(), m_heap.end(), compare);
+		}
+	}
+
+	size_t NoteMerger::buffered() const {
+		size_t total = 0;
+		for (const auto& track : m_tracks) {
+			total += track->buffered();
+		}
+		return total;
+	}
+
+	bool NoteMerger::later(size_t a, size_t b) const {
+		Time start_a = m_tracks[a]->note().start, start_b = m_tracks[b]->note().start;
+		return start_a != start_b ? start_a > start_b : a > b;
+	}
+}
@@ -0,0 +1,150 @@
+#ifndef NOTE_MERGER_H
+#define NOTE_MERGER_H
+
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "midi/midi.h"
+#include "midi/event-reader.h"
+#include "midi/note-collector.h"
+#include "io/cursor.h"
+
+namespace midi {
+	/// <summary>
+	/// The notes of one track in order of start, decoded only as far as needed.
+	/// A note is known once it ends, so finished notes are held back until no note
+	/// still sounding, and no note yet to come, can start before them. Memory is
+	/// bounded by the notes ending while the longest note sounds, not by the track.
+	/// Notes with equal starts come in the order read_notes gives them.
+	/// Unlike read_notes, a note off on a key that is not sounding yields nothing: read_notes
+	/// emits a note with the key's last start, or 0, which could precede notes already released.
+	/// Parse errors are thrown when the events are decoded, i.e. by the constructor and by advance().
+	/// </summary>
+	class TrackNoteCursor {
+	public:
+		/// <summary>
+		/// <paramref name="chunk" /> is positioned at an MTrk header; the track is decoded
+		/// in ChunkMode::bounded. The buffer must outlive the cursor.
+		/// </summary>
+		explicit TrackNoteCursor(const io::Cursor& chunk);
+
+		// The collector passes finished notes back to this cursor
+		TrackNoteCursor(const TrackNoteCursor&) = delete;
+		TrackNoteCursor& operator =(const TrackNoteCursor&) = delete;
+
+		bool at_end() const { return m_pending.empty(); }
+
+		/// <summary>
+		/// The current note and its channel. Not at_end() only.
+		/// </summary>
+		const NOTE& note() const { return m_pending.front().note; }
+		Channel channel() const { return m_pending.front().channel; }
+
+		/// <summary>
+		/// Moves on to the next note.
+		/// </summary>
+		void advance();
+
+		/// <summary>
+		/// Number of finished notes held back, the current one included.
+		/// </summary>
+		size_t buffered() const { return m_pending.size(); }
+
+	private:
+		struct PENDING_NOTE {
+			NOTE note;
+			Channel channel;
+			// Order in which the collector finished the notes, to break ties in start
+			uint64_t sequence;
+		};
+
+		struct SOUNDING_NOTE {
+			uint8_t channel;
+			uint8_t note_number;
+			Time start;
+		};
+
+		struct PendingSink {
+			TrackNoteCursor* cursor;
+
+			void operator ()(const NOTE& note, Channel channel) { cursor->finish(note, channel); }
+		};
+
+		static bool later(const PENDING_NOTE& a, const PENDING_NOTE& b);
+
+		void finish(const NOTE& note, Channel channel);
+		// Whether the notes the event finishes are kept
+		bool track(const TRACK_EVENT& event);
+		bool releasable() const;
+		void fill();
+
+		io::Cursor m_chunk;
+		EventReader m_reader;
+		BasicNoteCollector<PendingSink> m_collector;
+		// Min-heap on (start, sequence)
+		std::vector<PENDING_NOTE> m_pending;
+		std::vector<SOUNDING_NOTE> m_sounding;
+		uint64_t m_sequence;
+		bool m_keep;
+	};
+
+	/// <summary>
+	/// Merges the notes of all tracks of a file into a single sequence in order of start,
+	/// keeping one TrackNoteCursor per track and a heap of the tracks on their current note.
+	/// Yields the notes of read_notes in ChunkMode::bounded, stably sorted by start,
+	/// without holding the whole file's notes. Equal starts come in track order.
+	/// Note offs on keys that are not sounding are dropped, see TrackNoteCursor.
+	/// </summary>
+	class NoteMerger {
+	public:
+		/// <summary>
+		/// Indexes the chunks of the file at <paramref name="file" /> and opens a cursor
+		/// on every track. The buffer must outlive the merger.
+		/// </summary>
+		explicit NoteMerger(const io::Cursor& file);
+
+		bool at_end() const { return m_heap.empty(); }
+
+		/// <summary>
+		/// The current note, its channel and the index of its track. Not at_end() only.
+		/// </summary>
+		const NOTE& note() const { return m_tracks[m_heap.front()]->note(); }
+		Channel channel() const { return m_tracks[m_heap.front()]->channel(); }
+		size_t track() const { return m_heap.front(); }
+
+		/// <summary>
+		/// Moves on to the next note in order of start. O(log n) in the number of tracks.
+		/// </summary>
+		void advance();
+
+		/// <summary>
+		/// Number of notes held back in all tracks together.
+		/// </summary>
+		size_t buffered() const;
+
+	private:
+		bool later(size_t a, size_t b) const;
+
+		std::vector<std::unique_ptr<TrackNoteCursor>> m_tracks;
+		// Min-heap of the tracks not at their end, on the start of their current note
+		std::vector<size_t> m_heap;
+	};
+
+	/// <summary>
+	/// Passes the notes of every track of a file to <paramref name="sink" /> in order of start.
+	/// Like BasicNoteCollector, the sink may take the channel after the note.
+	/// </summary>
+	template<typename SINK>
+	void merge_notes(const io::Cursor& file, SINK&& sink) {
+		for (NoteMerger merger(file); !merger.at_end(); merger.advance()) {
+			if constexpr (std::is_invocable_v<SINK&, const NOTE&, Channel>) {
+				sink(merger.note(), merger.channel());
+			}
+			else {
+				sink(merger.note());
+			}
+		}
+	}
+}
+#endif
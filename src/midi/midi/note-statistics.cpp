@@ -0,0 +1,137 @@
+#include "midi/note-statistics.h"
+#include <algorithm>
+
+namespace midi {
+	namespace {
+		// Interleaved copies of every histogram; row i is counted in copy i % LANES
+		const size_t LANES = 4;
+		// Bins per histogram, one per byte value, so no value needs a range check
+		const size_t BINS = 256;
+
+		enum Histogram { PITCH, VELOCITY, INSTRUMENT, CHANNEL, HISTOGRAMS };
+
+		template<size_t N>
+		void merge_lanes(const std::vector<uint32_t>& counts, Histogram histogram, std::array<uint64_t, N>& result) {
+			for (size_t bin = 0; bin != N; ++bin) {
+				uint64_t total = 0;
+				for (size_t lane = 0; lane != LANES; ++lane) {
+					total += counts[(lane * HISTOGRAMS + histogram) * BINS + bin];
+				}
+				result[bin] = total;
+			}
+		}
+
+		void duration_percentiles(const NoteTable& notes, NOTE_STATISTICS& statistics) {
+			std::vector<uint64_t> durations = notes.duration;
+			// Each selection leaves the larger durations behind the chosen one, so the next searches only those
+			auto from = durations.begin();
+			for (size_t i = 0; i != std::size(DURATION_PERCENTILES); ++i) {
+				size_t rank = (size_t(DURATION_PERCENTILES[i]) * durations.size() + 99) / 100;
+				auto nth = durations.begin() + std::max<size_t>(rank, 1) - 1;
+				std::nth_element(from, nth, durations.end());
+				statistics.duration_percentiles[i] = *nth;
+				from = nth;
+			}
+		}
+
+		void max_polyphony(const NoteTable& notes, NOTE_STATISTICS& statistics) {
+			std::vector<uint64_t> starts, ends;
+			starts.reserve(notes.size());
+			ends.reserve(notes.size());
+			for (size_t i = 0; i != notes.size(); ++i) {
+				if (notes.duration[i] != 0) {
+					starts.push_back(notes.start[i]);
+					ends.push_back(notes.start[i] + notes.duration[i]);
+				}
+			}
+			// read_notes output is nearly sorted by start per track, sorted tables need no sort at all
+			if (!std::is_sorted(starts.begin(), starts.end())) {
+				std::sort(starts.begin(), starts.end());
+			}
+			std::sort(ends.begin(), ends.end());
+
+			// Every note ends after it starts, so no more than s notes end by the s-th start
+			size_t ended = 0;
+			for (size_t s = 0; s != starts.size(); ++s) {
+				while (ends[ended] <= starts[s]) {
+					++ended;
+				}
+				if (s + 1 - ended > statistics.max_polyphony) {
+					statistics.max_polyphony = s + 1 - ended;
+					statistics.max_polyphony_time = starts[s];
+				}
+			}
+		}
+	}
+
+	NOTE_STATISTICS note_statistics(const NoteTable& notes) {
+		NOTE_STATISTICS statistics = NOTE_STATISTICS();
+		size_t n = notes.size();
+		statistics.notes = n;
+		statistics.lowest_note = 128;
+		if (n == 0) {
+			return statistics;
+		}
+
+		const uint64_t* start = notes.start.data();
+		const uint64_t* duration = notes.duration.data();
+		const uint8_t* note_number = notes.note_number.data();
+		const uint8_t* velocity = notes.velocity.data();
+		const uint8_t* instrument = notes.instrument.data();
+		const uint8_t* channel = notes.channel.data();
+
+		std::vector<uint32_t> counts(LANES * HISTOGRAMS * BINS);
+		uint64_t end = 0, shortest = UINT64_MAX, longest = 0, total = 0;
+		auto count = [&](size_t lane, size_t i) {
+			uint32_t* histograms = counts.data() + lane * HISTOGRAMS * BINS;
+			++histograms[PITCH * BINS + note_number[i]];
+			++histograms[VELOCITY * BINS + velocity[i]];
+			++histograms[INSTRUMENT * BINS + instrument[i]];
+			++histograms[CHANNEL * BINS + channel[i]];
+			end = std::max(end, start[i] + duration[i]);
+			shortest = std::min(shortest, duration[i]);
+			longest = std::max(longest, duration[i]);
+			total += duration[i];
+		};
+
+		size_t i = 0;
+		for (; i + LANES <= n; i += LANES) {
+			count(0, i);
+			count(1, i + 1);
+			count(2, i + 2);
+			count(3, i + 3);
+		}
+		for (; i != n; ++i) {
+			count(i % LANES, i);
+		}
+
+		merge_lanes(counts, PITCH, statistics.pitches);
+		merge_lanes(counts, VELOCITY, statistics.velocities);
+		merge_lanes(counts, INSTRUMENT, statistics.instruments);
+		merge_lanes(counts, CHANNEL, statistics.channels);
+
+		for (unsigned pitch = 0; pitch != 128; ++pitch) {
+			if (statistics.pitches[pitch] != 0) {
+				statistics.lowest_note = std::min(statistics.lowest_note, uint8_t(pitch));
+				statistics.highest_note = uint8_t(pitch);
+			}
+		}
+		statistics.end_time = end;
+		statistics.shortest = shortest;
+		statistics.longest = longest;
+		statistics.mean_duration = double(total) / n;
+
+		duration_percentiles(notes, statistics);
+		max_polyphony(notes, statistics);
+		return statistics;
+	}
+
+	NOTE_STATISTICS note_statistics(const std::vector<NOTE>& notes) {
+		NoteTable table;
+		table.reserve(notes.size());
+		for (const NOTE& note : notes) {
+			table.push_back(note, Channel(0));
+		}
+		return note_statistics(table);
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef NOTE_STATISTICS_H
+#define NOTE_STATISTICS_H
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#include "midi/midi.h"
+#include "midi/note-table.h"
+
+namespace midi {
+	/// <summary>
+	/// Percentiles of the note durations in NOTE_STATISTICS::duration_percentiles, by the nearest-rank method.
+	/// </summary>
+	constexpr unsigned DURATION_PERCENTILES[] = { 10, 25, 50, 75, 90, 99 };
+
+	/// <summary>
+	/// Summary of a set of notes. Times and durations are in ticks.
+	/// Data bytes above 127, found in malformed files only, are left out of the histograms.
+	/// </summary>
+	struct NOTE_STATISTICS {
+		uint64_t notes;
+		// Number of notes per note number, velocity, instrument and channel
+		std::array<uint64_t, 128> pitches;
+		std::array<uint64_t, 128> velocities;
+		std::array<uint64_t, 128> instruments;
+		std::array<uint64_t, 16> channels;
+		// 128 and 0 without notes, like lowest_note and highest_note
+		uint8_t lowest_note;
+		uint8_t highest_note;
+		uint64_t end_time;
+		uint64_t shortest;
+		uint64_t longest;
+		double mean_duration;
+		std::array<uint64_t, std::size(DURATION_PERCENTILES)> duration_percentiles;
+		// Most notes sounding at once, and the first time they do. Notes end before others start
+		// at the same tick, so notes back to back do not overlap; notes of length 0 never sound.
+		uint64_t max_polyphony;
+		uint64_t max_polyphony_time;
+	};
+
+	/// <summary>
+	/// Computes all statistics in one pass over the columns, plus a selection over the durations
+	/// for the percentiles and a sweep over the sorted starts and ends for the polyphony.
+	/// The histograms are counted into several interleaved copies, so that consecutive
+	/// notes with the same value do not wait on each other's increment.
+	/// </summary>
+	NOTE_STATISTICS note_statistics(const NoteTable& notes);
+
+	/// <summary>
+	/// Same for the output of read_notes, which is converted to columns first.
+	/// NOTE does not carry the channel, so all notes are counted on channel 0.
+	/// </summary>
+	NOTE_STATISTICS note_statistics(const std::vector<NOTE>& notes);
+}
+#endif
@@ -0,0 +1,106 @@
+#include "midi/note-table.h"
+#include <algorithm>
+#include <numeric>
+
+namespace midi {
+	namespace {
+		template<typename T>
+		void gather(std::vector<T>& column, const std::vector<uint32_t>& order) {
+			std::vector<T> sorted(order.size());
+			for (size_t i = 0; i != order.size(); ++i) {
+				sorted[i] = column[order[i]];
+			}
+			column.swap(sorted);
+		}
+	}
+
+	void NoteTable::clear() {
+		resize(0);
+	}
+
+	void NoteTable::reserve(size_t n) {
+		start.reserve(n);
+		duration.reserve(n);
+		note_number.reserve(n);
+		velocity.reserve(n);
+		instrument.reserve(n);
+		channel.reserve(n);
+	}
+
+	void NoteTable::resize(size_t n) {
+		start.resize(n);
+		duration.resize(n);
+		note_number.resize(n);
+		velocity.resize(n);
+		instrument.resize(n);
+		channel.resize(n);
+	}
+
+	void NoteTable::push_back(const NOTE& note, Channel note_channel) {
+		start.push_back(value(note.start));
+		duration.push_back(value(note.duration));
+		note_number.push_back(value(note.note_number));
+		velocity.push_back(note.velocity);
+		instrument.push_back(value(note.instrument));
+		channel.push_back(value(note_channel));
+	}
+
+	NOTE NoteTable::note(size_t i) const {
+		return NOTE(NoteNumber(note_number[i]), Time(start[i]), Duration(duration[i]), velocity[i], Instrument(instrument[i]));
+	}
+
+	void NoteTable::sort_by_start() {
+		std::vector<uint32_t> order(size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+			return start[a] < start[b];
+		});
+		permute(order);
+	}
+
+	void NoteTable::sort_by_pitch() {
+		std::vector<uint32_t> order(size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+			return note_number[a] != note_number[b] ? note_number[a] < note_number[b] : start[a] < start[b];
+		});
+		permute(order);
+	}
+
+	void NoteTable::permute(const std::vector<uint32_t>& order) {
+		gather(start, order);
+		gather(duration, order);
+		gather(note_number, order);
+		gather(velocity, order);
+		gather(instrument, order);
+		gather(channel, order);
+	}
+
+	uint64_t end_time(const NoteTable& notes) {
+		const uint64_t* start = notes.start.data();
+		const uint64_t* duration = notes.duration.data();
+		uint64_t result = 0;
+		for (size_t i = 0; i != notes.size(); ++i) {
+			result = std::max(result, start[i] + duration[i]);
+		}
+		return result;
+	}
+
+	uint8_t lowest_note(const NoteTable& notes) {
+		const uint8_t* note_number = notes.note_number.data();
+		uint8_t result = 128;
+		for (size_t i = 0; i != notes.size(); ++i) {
+			result = std::min(result, note_number[i]);
+		}
+		return result;
+	}
+
+	uint8_t highest_note(const NoteTable& notes) {
+		const uint8_t* note_number = notes.note_number.data();
+		uint8_t result = 0;
+		for (size_t i = 0; i != notes.size(); ++i) {
+			result = std::max(result, note_number[i]);
+		}
+		return result;
+	}
+}
@@ -0,0 +1,87 @@
+#ifndef NOTE_TABLE_H
+#define NOTE_TABLE_H
+
+#include <cstdint>
+#include <vector>
+#include "midi/midi.h"
+
+namespace midi {
+	struct NoteTable;
+
+	/// <summary>
+	/// Sink for BasicNoteCollector adding each note to a NoteTable, with its channel.
+	/// </summary>
+	struct NoteTableAppender {
+		NoteTable* table;
+
+		void operator ()(const NOTE& note, Channel channel) const;
+	};
+
+	/// <summary>
+	/// Notes stored one column per field, like EventBatch does for events: loops over
+	/// one field read only that field, without the padding of NOTE in between.
+	/// Row i of every column describes the same note.
+	/// </summary>
+	struct NoteTable {
+		std::vector<uint64_t> start;
+		std::vector<uint64_t> duration;
+		std::vector<uint8_t> note_number;
+		std::vector<uint8_t> velocity;
+		std::vector<uint8_t> instrument;
+		std::vector<uint8_t> channel;
+
+		size_t size() const { return start.size(); }
+		bool empty() const { return start.empty(); }
+
+		void clear();
+		void reserve(size_t n);
+		void resize(size_t n);
+
+		void push_back(const NOTE& note, Channel channel);
+
+		/// <summary>
+		/// Row <paramref name="i" /> as a NOTE.
+		/// </summary>
+		NOTE note(size_t i) const;
+
+		/// <summary>
+		/// Returns a sink for collect_notes that fills this table.
+		/// </summary>
+		NoteTableAppender appender() { return NoteTableAppender{ this }; }
+
+		/// <summary>
+		/// Orders the rows by start time. Notes starting together keep their order.
+		/// </summary>
+		void sort_by_start();
+
+		/// <summary>
+		/// Orders the rows by note number, and notes of the same number by start time.
+		/// </summary>
+		void sort_by_pitch();
+
+	private:
+		void permute(const std::vector<uint32_t>& order);
+	};
+
+	inline void NoteTableAppender::operator ()(const NOTE& note, Channel channel) const {
+		table->push_back(note, channel);
+	}
+
+	// Reductions over single columns, written as plain loops the compiler vectorizes
+
+	/// <summary>
+	/// Latest end of a note, 0 for an empty table.
+	/// </summary>
+	uint64_t end_time(const NoteTable& notes);
+
+	/// <summary>
+	/// Lowest note number, 128 for an empty table.
+	/// </summary>
+	uint8_t lowest_note(const NoteTable& notes);
+
+	/// <summary>
+	/// Highest note number, 0 for an empty table.
+	/// </summary>
+	uint8_t highest_note(const NoteTable& notes);
+}
+#endif
@@ -0,0 +1,277 @@
+#ifndef READ_MTRK_H
+#define READ_MTRK_H
+
+#include <istream>
+#include <type_traits>
+#include <utility>
+#include "midi/midi.h"
+#include "midi/status-table.h"
+#include "io/cursor.h"
+#include "io/parse-error.h"
+#include "io/read.h"
+#include "io/vli.h"
+
+namespace midi {
+	namespace decoding {
+		// Longest event prefix the bounded decoder reads without checks:
+		// a four byte delta time, status and type bytes and a four byte length
+		constexpr size_t MAXIMUM_EVENT_PREFIX = 10;
+
+		// Longest variable length integer the standard allows
+		constexpr size_t MAXIMUM_VLI_LENGTH = 4;
+
+		struct TRACK_STATE {
+			bool has_previous = false;
+			uint8_t previousID = 0;
+			// Holds the payload of the current meta or sysex event when reading from a stream
+			std::vector<uint8_t> payload;
+			// Events of other kinds are skipped
+			EventMask interests = ALL_EVENTS;
+			// Delta time of the events skipped since the last one passed on
+			uint64_t skipped = 0;
+			// Bounded tracks reject longer integers on the checked path too, as the unchecked one does
+			size_t maximum_vli_length = SIZE_MAX;
+		};
+
+		template<typename RECEIVER, typename = void>
+		struct has_interests : std::false_type { };
+
+		template<typename RECEIVER>
+		struct has_interests<RECEIVER, std::void_t<decltype(std::declval<const RECEIVER&>().interests())>> : std::true_type { };
+
+		// Receivers without an interests() member receive everything
+		template<typename RECEIVER>
+		EventMask interests_of(const RECEIVER& receiver) {
+			if constexpr (has_interests<RECEIVER>::value) {
+				return receiver.interests();
+			}
+			else {
+				return ALL_EVENTS;
+			}
+		}
+
+		inline uint64_t position(std::istream& in) { return uint64_t(in.tellg()); }
+		inline uint64_t position(io::Cursor& in) { return in.offset(); }
+		inline uint64_t position(io::UncheckedCursor& in) { return in.cursor().offset(); }
+
+		// Streams are always read leniently, the unchecked path enforces the limit itself
+		inline uint64_t read_vli(std::istream& in, const TRACK_STATE&) { return io::read_variable_length_integer(in); }
+		inline uint64_t read_vli(io::Cursor& in, const TRACK_STATE& state) { return io::read_variable_length_integer(in, state.maximum_vli_length); }
+		inline uint64_t read_vli(io::UncheckedCursor& in, const TRACK_STATE&) { return io::read_variable_length_integer(in); }
+
+		// Payloads are viewed in place in buffers, streams go through the per-track buffer
+		inline io::ByteView read_payload(std::istream& in, uint64_t length, TRACK_STATE& state) {
+			state.payload.resize(size_t(length));
+			io::read_to(in, state.payload.data(), state.payload.size());
+			return io::ByteView(state.payload.data(), state.payload.size());
+		}
+		inline io::ByteView read_payload(io::Cursor& in, uint64_t length, TRACK_STATE&) { return io::read_view(in, size_t(length)); }
+		inline io::ByteView read_payload(io::UncheckedCursor& in, uint64_t length, TRACK_STATE&) { return io::read_view(in, size_t(length)); }
+
+		inline void skip_payload(std::istream& in, uint64_t length) {
+			uint64_t start = position(in);
+			in.ignore(std::streamsize(length));
+			if (uint64_t(in.gcount()) != length) {
+				throw io::ParseError(start + in.gcount(), "unexpected end of data, " + std::to_string(length) + " bytes needed but only " + std::to_string(in.gcount()) + " left");
+			}
+		}
+		inline void skip_payload(io::Cursor& in, uint64_t length) { in.skip(size_t(length)); }
+		inline void skip_payload(io::UncheckedCursor& in, uint64_t length) { in.cursor().skip(size_t(length)); }
+
+		// Passes over the rest of an event the receiver has no interest in,
+		// keeping running status up to date. The first data byte has been read already
+		template<typename SOURCE>
+		bool skip_event(SOURCE& in, uint8_t status, STATUS_INFO info, TRACK_STATE& state) {
+			switch (info.kind) {
+			case EventKind::meta: {
+				uint8_t type = io::read<uint8_t>(in);
+				skip_payload(in, read_vli(in, state));
+				// end of track
+				return type != 0x2F;
+			}
+			case EventKind::sysex:
+				skip_payload(in, read_vli(in, state));
+				return true;
+			case EventKind::invalid:
+				throw io::ParseError(position(in) - 1, "unexpected status byte " + std::to_string(status));
+			default:
+				if (info.data_bytes == 2) {
+					io::read<uint8_t>(in);
+				}
+				state.previousID = status;
+				state.has_previous = true;
+				return true;
+			}
+		}
+
+		// Decodes a single event and reports whether more follow.
+		// Shared by the stream and the buffer overloads; both provide the same io:: readers.
+		// RECEIVER is either EventReceiver, dispatching virtually, or a concrete receiver type
+		template<typename SOURCE, typename RECEIVER>
+		bool read_event(SOURCE& in, RECEIVER& receiver, TRACK_STATE& state) {
+			uint64_t dt = read_vli(in, state) + state.skipped;
+			uint8_t status = io::read<uint8_t>(in);
+			STATUS_INFO info = status_table[status];
+
+			// Under running status the byte just read is the first data byte
+			uint8_t first = status;
+			if (info.kind == EventKind::running_status) {
+				if (!state.has_previous) {
+					throw io::ParseError(position(in) - 1, "running status without preceding MIDI event");
+				}
+				status = state.previousID;
+				info = status_table[status];
+			}
+			else if (info.data_bytes != 0) {
+				first = io::read<uint8_t>(in);
+			}
+
+			if ((state.interests & event_mask(info.kind)) == 0) {
+				state.skipped = dt;
+				return skip_event(in, status, info, state);
+			}
+			state.skipped = 0;
+			Duration duration(dt);
+
+			switch (info.kind) {
+			case EventKind::note_off:
+				receiver.note_off(duration, Channel(info.channel), NoteNumber(first), io::read<uint8_t>(in));
+				break;
+			case EventKind::note_on:
+				receiver.note_on(duration, Channel(info.channel), NoteNumber(first), io::read<uint8_t>(in));
+				break;
+			case EventKind::polyphonic_key_pressure:
+				receiver.polyphonic_key_pressure(duration, Channel(info.channel), NoteNumber(first), io::read<uint8_t>(in));
+				break;
+			case EventKind::control_change:
+				receiver.control_change(duration, Channel(info.channel), first, io::read<uint8_t>(in));
+				break;
+			case EventKind::program_change:
+				receiver.program_change(duration, Channel(info.channel), Instrument(first));
+				break;
+			case EventKind::channel_pressure:
+				receiver.channel_pressure(duration, Channel(info.channel), first);
+				break;
+			case EventKind::pitch_wheel_change: {
+				uint8_t upper = io::read<uint8_t>(in);
+				receiver.pitch_wheel_change(duration, Channel(info.channel), uint16_t(first | (upper << 7)));
+				break;
+			}
+			case EventKind::meta: {
+				uint8_t type = io::read<uint8_t>(in);
+				uint64_t length(read_vli(in, state));
+				receiver.meta(duration, type, read_payload(in, length, state));
+				// end of track
+				return type != 0x2F;
+			}
+			case EventKind::sysex: {
+				uint64_t length(read_vli(in, state));
+				receiver.sysex(duration, read_payload(in, length, state));
+				return true;
+			}
+			default:
+				throw io::ParseError(position(in) - 1, "unexpected status byte " + std::to_string(status));
+			}
+
+			state.previousID = status;
+			state.has_previous = true;
+			return true;
+		}
+
+		template<typename SOURCE, typename RECEIVER>
+		void read_mtrk_events(SOURCE& in, RECEIVER& receiver) {
+			TRACK_STATE state;
+			state.interests = interests_of(receiver);
+			while (read_event(in, receiver, state)) { }
+		}
+
+		// Decodes the next event of a track whose end is known to be a safe bound.
+		// Events whose prefix fits in the remaining bytes are decoded unchecked
+		template<typename RECEIVER>
+		bool read_bounded_event(io::Cursor& track, RECEIVER& receiver, TRACK_STATE& state) {
+			if (track.remaining() >= MAXIMUM_EVENT_PREFIX) {
+				io::UncheckedCursor unchecked(track);
+				return read_event(unchecked, receiver, state);
+			}
+			else if (track.at_end()) {
+				throw io::ParseError(track.offset(), "missing End-of-Track");
+			}
+			else {
+				return read_event(track, receiver, state);
+			}
+		}
+
+		template<typename RECEIVER>
+		void read_bounded_mtrk_events(io::Cursor& track, RECEIVER& receiver) {
+			TRACK_STATE state;
+			state.interests = interests_of(receiver);
+			state.maximum_vli_length = MAXIMUM_VLI_LENGTH;
+			while (read_bounded_event(track, receiver, state)) { }
+		}
+
+		// Reads the MTrk header, validates the chunk size against the buffer
+		// and splits the chunk's events off as a separate cursor
+		inline io::Cursor take_mtrk_chunk(io::Cursor& in) {
+			const RAW_CHUNK_HEADER* header = io::overlay<RAW_CHUNK_HEADER>(in);
+			uint32_t size = header->size;
+			if (size > in.remaining()) {
+				throw io::ParseError(in.offset(), "MTrk chunk of " + std::to_string(size) + " bytes exceeds the " + std::to_string(in.remaining()) + " bytes left");
+			}
+			return in.take(size);
+		}
+
+		template<typename RECEIVER>
+		void read_mtrk_chunk(io::Cursor& in, RECEIVER& receiver, ChunkMode mode) {
+			if (mode == ChunkMode::bounded) {
+				io::Cursor track = take_mtrk_chunk(in);
+				read_bounded_mtrk_events(track, receiver);
+			}
+			else {
+				io::overlay<RAW_CHUNK_HEADER>(in);
+				read_mtrk_events(in, receiver);
+			}
+		}
+
+		template<typename RECEIVER>
+		void read_mtrk_chunk(std::istream& in, RECEIVER& receiver) {
+			CHUNK_HEADER header;
+			read_chunk_header(in, &header);
+			read_mtrk_events(in, receiver);
+		}
+	}
+
+	/// <summary>
+	/// Tells whether RECEIVER has the callbacks of EventReceiver, with meta and sysex
+	/// taking their payload as io::ByteView, so it can be passed to the read_mtrk templates.
+	/// </summary>
+	template<typename RECEIVER, typename = void>
+	struct is_event_receiver : std::false_type { };
+
+	template<typename RECEIVER>
+	struct is_event_receiver<RECEIVER, std::void_t<
+		decltype(std::declval<RECEIVER&>().note_on(Duration(), Channel(), NoteNumber(), uint8_t())),
+		decltype(std::declval<RECEIVER&>().note_off(Duration(), Channel(), NoteNumber(), uint8_t())),
+		decltype(std::declval<RECEIVER&>().polyphonic_key_pressure(Duration(), Channel(), NoteNumber(), uint8_t())),
+		decltype(std::declval<RECEIVER&>().control_change(Duration(), Channel(), uint8_t(), uint8_t())),
+		decltype(std::declval<RECEIVER&>().program_change(Duration(), Channel(), Instrument())),
+		decltype(std::declval<RECEIVER&>().channel_pressure(Duration(), Channel(), uint8_t())),
+		decltype(std::declval<RECEIVER&>().pitch_wheel_change(Duration(), Channel(), uint16_t())),
+		decltype(std::declval<RECEIVER&>().meta(Duration(), uint8_t(), io::ByteView())),
+		decltype(std::declval<RECEIVER&>().sysex(Duration(), io::ByteView()))>> : std::true_type { };
+
+	/// <summary>
+	/// read_mtrk for a receiver whose type is known at compile time: the callbacks are
+	/// called directly and can be inlined. The EventReceiver overloads remain for
+	/// receivers that are only known through the interface.
+	/// </summary>
+	template<typename RECEIVER, typename std::enable_if<is_event_receiver<RECEIVER>::value && !std::is_same<RECEIVER, EventReceiver>::value, int>::type = 0>
+	void read_mtrk(io::Cursor& in, RECEIVER& receiver, ChunkMode mode = ChunkMode::lenient) {
+		decoding::read_mtrk_chunk(in, receiver, mode);
+	}
+
+	template<typename RECEIVER, typename std::enable_if<is_event_receiver<RECEIVER>::value && !std::is_same<RECEIVER, EventReceiver>::value, int>::type = 0>
+	void read_mtrk(std::istream& in, RECEIVER& receiver) {
+		decoding::read_mtrk_chunk(in, receiver);
+	}
+}
+#endif
@@ -0,0 +1,91 @@
+#ifndef STATUS_TABLE_H
+#define STATUS_TABLE_H
+
+#include <cstdint>
+
+namespace midi {
+	/// <summary>
+	/// What a status byte at the start of an event announces.
+	/// </summary>
+	enum class EventKind : uint8_t {
+		// Bytes below 0x80: a data byte, the previous status applies
+		running_status,
+		note_off,
+		note_on,
+		polyphonic_key_pressure,
+		control_change,
+		program_change,
+		channel_pressure,
+		pitch_wheel_change,
+		sysex,
+		meta,
+		// System common and real-time messages, which do not occur in files
+		invalid
+	};
+
+	/// <summary>
+	/// Set of event kinds, one bit per EventKind, with which receivers declare
+	/// the events they handle. The readers skip the others without decoding them.
+	/// </summary>
+	typedef uint16_t EventMask;
+
+	constexpr EventMask event_mask(EventKind kind) {
+		return EventMask(1u << uint8_t(kind));
+	}
+
+	constexpr EventMask ALL_EVENTS = EventMask(~0u);
+	constexpr EventMask NOTE_EVENTS = event_mask(EventKind::note_on) | event_mask(EventKind::note_off);
+	constexpr EventMask CHANNEL_EVENTS = NOTE_EVENTS
+		| event_mask(EventKind::polyphonic_key_pressure) | event_mask(EventKind::control_change)
+		| event_mask(EventKind::program_change) | event_mask(EventKind::channel_pressure)
+		| event_mask(EventKind::pitch_wheel_change);
+
+	struct STATUS_INFO {
+		EventKind kind;
+		// Data bytes following a channel message's status byte, 0 for anything else
+		uint8_t data_bytes;
+		uint8_t channel;
+	};
+
+	constexpr STATUS_INFO classify_status(uint8_t status) {
+		if (status < 0x80) {
+			return { EventKind::running_status, 0, 0 };
+		}
+		if (status < 0xF0) {
+			const EventKind kinds[] = {
+				EventKind::note_off, EventKind::note_on, EventKind::polyphonic_key_pressure, EventKind::control_change,
+				EventKind::program_change, EventKind::channel_pressure, EventKind::pitch_wheel_change
+			};
+			EventKind kind = kinds[(status >> 4) - 0x08];
+			bool one_byte = kind == EventKind::program_change || kind == EventKind::channel_pressure;
+			return { kind, uint8_t(one_byte ? 1 : 2), uint8_t(status & 0x0F) };
+		}
+		if (status == 0xF0 || status == 0xF7) {
+			return { EventKind::sysex, 0, 0 };
+		}
+		if (status == 0xFF) {
+			return { EventKind::meta, 0, 0 };
+		}
+		return { EventKind::invalid, 0, 0 };
+	}
+
+	struct STATUS_TABLE {
+		STATUS_INFO entries[256];
+
+		constexpr const STATUS_INFO& operator [](uint8_t status) const { return entries[status]; }
+	};
+
+	constexpr STATUS_TABLE make_status_table() {
+		STATUS_TABLE table = {};
+		for (unsigned status = 0; status != 256; ++status) {
+			table.entries[status] = classify_status(uint8_t(status));
+		}
+		return table;
+	}
+
+	/// <summary>
+	/// Classification of every status byte, computed at compile time.
+	/// </summary>
+	inline constexpr STATUS_TABLE status_table = make_status_table();
+}
+#endif
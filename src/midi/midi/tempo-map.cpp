@@ -0,0 +1,264 @@
+#include "midi/tempo-map.h"
+#include "midi/combinators.h"
+#include "midi/event-reader.h"
+#include "io/parse-error.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEMPO_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace midi {
+	namespace {
+		const uint32_t DEFAULT_TEMPO = 500000;
+
+		// Offset of the division field in a MIDI file
+		const size_t DIVISION_OFFSET = 12;
+
+		TempoMap make_tempo_map(const MTHD& mthd, std::vector<TEMPO_CHANGE> changes) {
+			try {
+				return TempoMap(mthd.division, std::move(changes));
+			}
+			catch (const std::invalid_argument& e) {
+				throw io::ParseError(DIVISION_OFFSET, e.what());
+			}
+		}
+
+		auto note_sink(std::vector<NOTE>& notes) {
+			return [&notes](const NOTE& note) { notes.push_back(note); };
+		}
+
+		NoteTableAppender note_sink(NoteTable& notes) {
+			return notes.appender();
+		}
+
+		// Counts the events into <paramref name="events" /> unless it is null
+		template<typename NOTES>
+		void read_notes_and_tempo(io::Cursor& in, NOTES& notes, TempoMap& tempo_map, ChunkMode mode, uint64_t* events = nullptr) {
+			std::vector<TEMPO_CHANGE> changes;
+			auto read_track = [&](io::Cursor& track, ChunkMode track_mode) {
+				if (events != nullptr) {
+					EventCounter counter;
+					auto receiver = tee(counter, collect_notes(note_sink(notes)), TempoRecorder(changes));
+					read_mtrk(track, receiver, track_mode);
+					*events += counter.count;
+				}
+				else {
+					auto receiver = tee(collect_notes(note_sink(notes)), TempoRecorder(changes));
+					read_mtrk(track, receiver, track_mode);
+				}
+			};
+
+			if (mode == ChunkMode::bounded) {
+				CHUNK_INDEX index = index_chunks(in);
+				uint64_t mtrk_bytes = 0;
+				for (const CHUNK_INFO& track : index.tracks) {
+					mtrk_bytes += track.header.size;
+				}
+				notes.reserve(notes.size() + estimate_note_count(mtrk_bytes));
+				for (const CHUNK_INFO& track : index.tracks) {
+					io::Cursor chunk = in.at(track.offset);
+					read_track(chunk, ChunkMode::bounded);
+				}
+				in = in.at(index.end);
+				tempo_map = make_tempo_map(index.mthd, std::move(changes));
+			}
+			else {
+				MTHD mthd;
+				read_mthd(in, &mthd);
+				notes.reserve(notes.size() + estimate_note_count(in.remaining()));
+				for (int i = 0; i < mthd.ntracks; i++) {
+					read_track(in, mode);
+				}
+				tempo_map = make_tempo_map(mthd, std::move(changes));
+			}
+		}
+	}
+
+	TempoMap::TempoMap(uint16_t division, std::vector<TEMPO_CHANGE> changes) : m_division(division) {
+		if (division & 0x8000) {
+			// SMPTE: the upper byte is minus the frame rate, where 29 stands for 29.97 drop-frame
+			int fps = -int8_t(division >> 8);
+			unsigned ticks_per_frame = division & 0xFF;
+			if (ticks_per_frame == 0 || fps <= 0) {
+				throw std::invalid_argument("SMPTE division without ticks");
+			}
+			double frame_rate = fps == 29 ? 30000.0 / 1001 : fps;
+			m_ticks.push_back(0);
+			m_microseconds.push_back(0);
+			m_tick_length.push_back(1e6 / (frame_rate * ticks_per_frame));
+			return;
+		}
+		if (division == 0) {
+			throw std::invalid_argument("division of zero ticks per quarter note");
+		}
+
+		m_ticks.push_back(0);
+		m_microseconds.push_back(0);
+		m_tick_length.push_back(double(DEFAULT_TEMPO) / division);
+
+		std::stable_sort(changes.begin(), changes.end(), [](const TEMPO_CHANGE& a, const TEMPO_CHANGE& b) {
+			return a.time < b.time;
+		});
+		for (const TEMPO_CHANGE& change : changes) {
+			if (change.microseconds_per_quarter == 0) {
+				continue;
+			}
+			uint64_t tick = value(change.time);
+			double length = double(change.microseconds_per_quarter) / division;
+			if (tick == m_ticks.back()) {
+				m_tick_length.back() = length;
+			}
+			else {
+				m_microseconds.push_back(m_microseconds.back() + double(tick - m_ticks.back()) * m_tick_length.back());
+				m_ticks.push_back(tick);
+				m_tick_length.push_back(length);
+			}
+		}
+	}
+
+	size_t TempoMap::segment(uint64_t tick) const {
+		return std::upper_bound(m_ticks.begin(), m_ticks.end(), tick) - m_ticks.begin() - 1;
+	}
+
+	double TempoMap::microseconds(Time time) const {
+		uint64_t tick = value(time);
+		size_t s = segment(tick);
+		return m_microseconds[s] + double(tick - m_ticks[s]) * m_tick_length[s];
+	}
+
+	void TempoMap::microseconds(const uint64_t* ticks, double* out, size_t n) const {
+		// Segment of the previous tick: [begin, end)
+		uint64_t begin = 0, end = 0;
+		double start = 0, length = 0;
+		auto select = [&](uint64_t tick) {
+			size_t s = segment(tick);
+			begin = m_ticks[s];
+			end = s + 1 == m_ticks.size() ? UINT64_MAX : m_ticks[s + 1];
+			start = m_microseconds[s];
+			length = m_tick_length[s];
+		};
+
+		size_t i = 0;
+#ifdef TEMPO_SSE2
+		// Adding 2^52 to an integer below 2^52 only fills in the mantissa, so OR-ing in the
+		// exponent of 2^52 and subtracting 2^52 converts without a 64-bit conversion instruction
+		const __m128i exponent = _mm_set1_epi64x(0x4330000000000000);
+		const __m128d two_52 = _mm_set1_pd(4503599627370496.0);
+		for (; i + 2 <= n; i += 2) {
+			uint64_t first = ticks[i], second = ticks[i + 1];
+			if (first < begin || first >= end) {
+				select(first);
+			}
+			if (second < begin || second >= end) {
+				out[i] = start + double(first - begin) * length;
+				select(second);
+				out[i + 1] = start + double(second - begin) * length;
+				continue;
+			}
+
+			__m128i offsets = _mm_sub_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ticks + i)), _mm_set1_epi64x(int64_t(begin)));
+			__m128d converted = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(offsets, exponent)), two_52);
+			_mm_storeu_pd(out + i, _mm_add_pd(_mm_set1_pd(start), _mm_mul_pd(converted, _mm_set1_pd(length))));
+		}
+#endif
+		for (; i != n; ++i) {
+			if (ticks[i] < begin || ticks[i] >= end) {
+				select(ticks[i]);
+			}
+			out[i] = start + double(ticks[i] - begin) * length;
+		}
+	}
+
+	Time TempoMap::time_at(double microseconds) const {
+		if (microseconds <= 0) {
+			return Time(0);
+		}
+		size_t s = std::upper_bound(m_microseconds.begin(), m_microseconds.end(), microseconds) - m_microseconds.begin() - 1;
+		return Time(m_ticks[s] + uint64_t((microseconds - m_microseconds[s]) / m_tick_length[s]));
+	}
+
+	std::vector<TEMPO_CHANGE> TempoMap::changes() const {
+		std::vector<TEMPO_CHANGE> result;
+		if (m_division & 0x8000) {
+			return result;
+		}
+		for (size_t s = 0; s != m_ticks.size(); ++s) {
+			// Tick lengths were computed as tempo / division, which multiplying back recovers
+			uint32_t tempo = uint32_t(std::llround(m_tick_length[s] * m_division));
+			if (s != 0 || tempo != DEFAULT_TEMPO) {
+				result.push_back(TEMPO_CHANGE{ Time(m_ticks[s]), tempo });
+			}
+		}
+		return result;
+	}
+
+	void TempoRecorder::meta(Duration dt, uint8_t type, io::ByteView data) {
+		time += value(dt);
+		// Set Tempo: microseconds per quarter note, 24 bits big-endian
+		if (type == 0x51 && data.size() == 3) {
+			changes.push_back(TEMPO_CHANGE{ Time(time), uint32_t(data[0] << 16 | data[1] << 8 | data[2]) });
+		}
+	}
+
+	TempoMap read_tempo_map(const io::Cursor& file) {
+		CHUNK_INDEX index = index_chunks(file);
+		std::vector<TEMPO_CHANGE> changes;
+		for (const CHUNK_INFO& track : index.tracks) {
+			TempoRecorder recorder(changes);
+			io::Cursor in = file.at(track.offset);
+			read_mtrk(in, recorder, ChunkMode::bounded);
+		}
+		return make_tempo_map(index.mthd, std::move(changes));
+	}
+
+	std::vector<NOTE> read_notes(io::Cursor& in, TempoMap& tempo_map, ChunkMode mode) {
+		std::vector<NOTE> notes;
+		read_notes_and_tempo(in, notes, tempo_map, mode);
+		return notes;
+	}
+
+	void read_notes(io::Cursor& in, NoteTable& notes, TempoMap& tempo_map, ChunkMode mode) {
+		read_notes_and_tempo(in, notes, tempo_map, mode);
+	}
+
+	void read_notes(io::Cursor& in, NoteTable& notes, TempoMap& tempo_map, ChunkMode mode, uint64_t& events) {
+		read_notes_and_tempo(in, notes, tempo_map, mode, &events);
+	}
+
+	void note_times(const TempoMap& tempo_map, const std::vector<NOTE>& notes, std::vector<double>& starts, std::vector<double>& durations) {
+		std::vector<uint64_t> start_ticks(notes.size());
+		std::vector<uint64_t> end_ticks(notes.size());
+		for (size_t i = 0; i != notes.size(); ++i) {
+			start_ticks[i] = value(notes[i].start);
+			end_ticks[i] = value(notes[i].start + notes[i].duration);
+		}
+
+		starts.resize(notes.size());
+		durations.resize(notes.size());
+		tempo_map.microseconds(start_ticks.data(), starts.data(), notes.size());
+		tempo_map.microseconds(end_ticks.data(), durations.data(), notes.size());
+		for (size_t i = 0; i != notes.size(); ++i) {
+			durations[i] -= starts[i];
+		}
+	}
+
+	void note_times(const TempoMap& tempo_map, const NoteTable& notes, std::vector<double>& starts, std::vector<double>& durations) {
+		// The start column converts as it is
+		std::vector<uint64_t> end_ticks(notes.size());
+		for (size_t i = 0; i != notes.size(); ++i) {
+			end_ticks[i] = notes.start[i] + notes.duration[i];
+		}
+
+		starts.resize(notes.size());
+		durations.resize(notes.size());
+		tempo_map.microseconds(notes.start.data(), starts.data(), notes.size());
+		tempo_map.microseconds(end_ticks.data(), durations.data(), notes.size());
+		for (size_t i = 0; i != notes.size(); ++i) {
+			durations[i] -= starts[i];
+		}
+	}
+}
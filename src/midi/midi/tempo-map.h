@@ -0,0 +1,126 @@
+#ifndef TEMPO_MAP_H
+#define TEMPO_MAP_H
+
+#include <cstdint>
+#include <vector>
+#include "midi/midi.h"
+#include "midi/note-table.h"
+#include "midi/primitives.h"
+#include "midi/status-table.h"
+#include "io/byte-view.h"
+#include "io/cursor.h"
+
+namespace midi {
+	/// <summary>
+	/// A Set Tempo meta event (type 0x51), at an absolute time in ticks.
+	/// </summary>
+	struct TEMPO_CHANGE {
+		Time time;
+		uint32_t microseconds_per_quarter;
+	};
+
+	/// <summary>
+	/// Converts ticks to microseconds. The tempo changes split the ticks into segments,
+	/// each with the real time at which it starts and a constant duration per tick.
+	/// With a metrical division the tempo is 120 BPM until the first change;
+	/// with an SMPTE division ticks have a fixed duration and tempo changes do not apply.
+	/// </summary>
+	class TempoMap {
+	public:
+		/// <summary>
+		/// <paramref name="division" /> is MTHD::division. Changes may come in any order,
+		/// later ones win at equal times. Throws std::invalid_argument for a division of zero ticks.
+		/// </summary>
+		explicit TempoMap(uint16_t division = 96, std::vector<TEMPO_CHANGE> changes = std::vector<TEMPO_CHANGE>());
+
+		/// <summary>
+		/// Number of segments, at least one.
+		/// </summary>
+		size_t size() const { return m_ticks.size(); }
+
+		/// <summary>
+		/// Real time at which <paramref name="time" /> ticks have passed. O(log n) in the number of segments.
+		/// </summary>
+		double microseconds(Time time) const;
+
+		/// <summary>
+		/// Converts <paramref name="n" /> tick counts at once. Fastest on sorted input, where
+		/// neighbouring ticks fall in the same segment; pairs are converted with SSE2 where available.
+		/// Ticks must be below 2^52.
+		/// </summary>
+		void microseconds(const uint64_t* ticks, double* out, size_t n) const;
+
+		/// <summary>
+		/// The last tick at or before <paramref name="microseconds" />.
+		/// </summary>
+		Time time_at(double microseconds) const;
+
+		uint16_t division() const { return m_division; }
+
+		/// <summary>
+		/// The tempo changes in effect, in order of time: one per segment after the first, and one
+		/// at time zero if the initial tempo is not the default. Constructing a TempoMap from
+		/// division() and changes() gives the same map. Empty for an SMPTE division.
+		/// </summary>
+		std::vector<TEMPO_CHANGE> changes() const;
+
+	private:
+		size_t segment(uint64_t tick) const;
+
+		uint16_t m_division;
+		// Per segment: its first tick, the real time of that tick, and the length of a tick
+		std::vector<uint64_t> m_ticks;
+		std::vector<double> m_microseconds;
+		std::vector<double> m_tick_length;
+	};
+
+	/// <summary>
+	/// Receiver recording the Set Tempo events of a track. Combine it with other receivers
+	/// to build a tempo map in the same pass; alone it only asks for meta events.
+	/// </summary>
+	struct TempoRecorder {
+		std::vector<TEMPO_CHANGE>& changes;
+		uint64_t time = 0;
+
+		explicit TempoRecorder(std::vector<TEMPO_CHANGE>& changes) : changes(changes) { }
+
+		void note_on(Duration dt, Channel, NoteNumber, uint8_t) { time += value(dt); }
+		void note_off(Duration dt, Channel, NoteNumber, uint8_t) { time += value(dt); }
+		void polyphonic_key_pressure(Duration dt, Channel, NoteNumber, uint8_t) { time += value(dt); }
+		void control_change(Duration dt, Channel, uint8_t, uint8_t) { time += value(dt); }
+		void program_change(Duration dt, Channel, Instrument) { time += value(dt); }
+		void channel_pressure(Duration dt, Channel, uint8_t) { time += value(dt); }
+		void pitch_wheel_change(Duration dt, Channel, uint16_t) { time += value(dt); }
+		void sysex(Duration dt, io::ByteView) { time += value(dt); }
+		void meta(Duration dt, uint8_t type, io::ByteView data);
+
+		EventMask interests() const { return event_mask(EventKind::meta); }
+	};
+
+	/// <summary>
+	/// Reads only the tempo changes of a file, skipping all other events.
+	/// </summary>
+	TempoMap read_tempo_map(const io::Cursor& file);
+
+	/// <summary>
+	/// read_notes that builds the tempo map of the file in the same pass.
+	/// </summary>
+	std::vector<NOTE> read_notes(io::Cursor& in, TempoMap& tempo_map, ChunkMode mode = ChunkMode::lenient);
+
+	/// <summary>
+	/// Same, appending the notes to <paramref name="notes" />.
+	/// </summary>
+	void read_notes(io::Cursor& in, NoteTable& notes, TempoMap& tempo_map, ChunkMode mode = ChunkMode::lenient);
+
+	/// <summary>
+	/// Same, also adding the number of events read to <paramref name="events" />.
+	/// </summary>
+	void read_notes(io::Cursor& in, NoteTable& notes, TempoMap& tempo_map, ChunkMode mode, uint64_t& events);
+
+	/// <summary>
+	/// Start times and durations of <paramref name="notes" /> in microseconds, in the same order.
+	/// </summary>
+	void note_times(const TempoMap& tempo_map, const std::vector<NOTE>& notes, std::vector<double>& starts, std::vector<double>& durations);
+	void note_times(const TempoMap& tempo_map, const NoteTable& notes, std::vector<double>& starts, std::vector<double>& durations);
+}
+#endif
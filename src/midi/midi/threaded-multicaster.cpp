@@ -0,0 +1,183 @@
+#include "midi/threaded-multicaster.h"
+#include <cstring>
+
+namespace midi {
+	ThreadedMulticaster::ThreadedMulticaster(std::vector<std::shared_ptr<EventReceiver>> receivers, size_t queue_capacity) :
+		m_encoder{ { this } }, m_time(0), m_finished(false) {
+		for (const std::shared_ptr<EventReceiver>& receiver : receivers) {
+			m_workers.push_back(std::make_unique<WORKER>(receiver, queue_capacity));
+		}
+		try {
+			for (std::unique_ptr<WORKER>& worker : m_workers) {
+				WORKER* w = worker.get();
+				worker->thread = std::thread([w]() { work(*w); });
+			}
+		}
+		catch (...) {
+			// Threads left joinable would terminate the program on destruction
+			finish();
+			throw;
+		}
+	}
+
+	ThreadedMulticaster::~ThreadedMulticaster() {
+		try {
+			finish();
+		}
+		catch (...) {
+			// Receiver errors are only reported by an explicit finish()
+		}
+	}
+
+	void ThreadedMulticaster::finish() {
+		if (m_finished) {
+			return;
+		}
+		m_finished = true;
+
+		// EventKind::invalid never reaches the queues otherwise; it tells the worker to stop
+		QUEUED_EVENT stop{};
+		stop.event.kind = EventKind::invalid;
+		for (std::unique_ptr<WORKER>& worker : m_workers) {
+			// Not joinable if the constructor failed to start it
+			if (worker->thread.joinable()) {
+				worker->queue.push(stop);
+			}
+		}
+		for (std::unique_ptr<WORKER>& worker : m_workers) {
+			if (worker->thread.joinable()) {
+				worker->thread.join();
+			}
+		}
+		for (std::unique_ptr<WORKER>& worker : m_workers) {
+			if (worker->error) {
+				std::rethrow_exception(worker->error);
+			}
+		}
+	}
+
+	void ThreadedMulticaster::work(WORKER& worker) {
+		for (;;) {
+			QUEUED_EVENT queued = worker.queue.pop();
+			if (queued.event.kind == EventKind::invalid) {
+				return;
+			}
+
+			// After a failure the queue is still drained, so the reader does not block
+			if (!worker.error) {
+				try {
+					dispatch(queued.event, *worker.receiver);
+				}
+				catch (...) {
+					worker.error = std::current_exception();
+				}
+			}
+		}
+	}
+
+	void ThreadedMulticaster::post(Duration dt, EventKind kind, uint8_t channel, uint8_t data1, uint8_t data2) {
+		m_time += dt;
+
+		QUEUED_EVENT queued;
+		queued.event = TRACK_EVENT{ dt, m_time, kind, channel, data1, data2, io::ByteView() };
+		for (std::unique_ptr<WORKER>& worker : m_workers) {
+			worker->queue.push(queued);
+		}
+	}
+
+	void ThreadedMulticaster::post(Duration dt, EventKind kind, uint8_t data1, std::shared_ptr<const uint8_t[]> payload, uint64_t size) {
+		m_time += dt;
+
+		QUEUED_EVENT queued;
+		queued.event = TRACK_EVENT{ dt, m_time, kind, 0, data1, 0, io::ByteView(payload.get(), size_t(size)) };
+		queued.payload = std::move(payload);
+		for (std::unique_ptr<WORKER>& worker : m_workers) {
+			worker->queue.push(queued);
+		}
+	}
+
+	namespace {
+		// Copies a payload that is only valid during the callback, for the workers to share
+		std::shared_ptr<const uint8_t[]> share(io::ByteView data) {
+			std::shared_ptr<uint8_t[]> copy(new uint8_t[data.size()]);
+			if (!data.empty()) {
+				std::memcpy(copy.get(), data.data(), data.size());
+			}
+			return copy;
+		}
+	}
+
+	void ThreadedMulticaster::Poster::add(Duration dt, EventKind kind, uint8_t channel, uint8_t data1, uint8_t data2)
+	{
+		multicaster->post(dt, kind, channel, data1, data2);
+	}
+
+	void ThreadedMulticaster::Poster::add_payload(Duration dt, EventKind kind, uint8_t data1, io::ByteView data)
+	{
+		multicaster->post(dt, kind, data1, share(data), data.size());
+	}
+
+	void ThreadedMulticaster::note_on(Duration dt, Channel channel, NoteNumber note, uint8_t velocity)
+	{
+		m_encoder.note_on(dt, channel, note, velocity);
+	}
+
+	void ThreadedMulticaster::note_off(Duration dt, Channel channel, NoteNumber note, uint8_t velocity)
+	{
+		m_encoder.note_off(dt, channel, note, velocity);
+	}
+
+	void ThreadedMulticaster::polyphonic_key_pressure(Duration dt, Channel channel, NoteNumber note, uint8_t pressure)
+	{
+		m_encoder.polyphonic_key_pressure(dt, channel, note, pressure);
+	}
+
+	void ThreadedMulticaster::control_change(Duration dt, Channel channel, uint8_t controller, uint8_t amount)
+	{
+		m_encoder.control_change(dt, channel, controller, amount);
+	}
+
+	void ThreadedMulticaster::program_change(Duration dt, Channel channel, Instrument program)
+	{
+		m_encoder.program_change(dt, channel, program);
+	}
+
+	void ThreadedMulticaster::channel_pressure(Duration dt, Channel channel, uint8_t pressure)
+	{
+		m_encoder.channel_pressure(dt, channel, pressure);
+	}
+
+	void ThreadedMulticaster::pitch_wheel_change(Duration dt, Channel channel, uint16_t wheel)
+	{
+		m_encoder.pitch_wheel_change(dt, channel, wheel);
+	}
+
+	void ThreadedMulticaster::meta(Duration dt, uint8_t type, std::unique_ptr<uint8_t[]> data, uint64_t data_size)
+	{
+		post(dt, EventKind::meta, type, std::shared_ptr<const uint8_t[]>(std::move(data)), data_size);
+	}
+
+	void ThreadedMulticaster::sysex(Duration dt, std::unique_ptr<uint8_t[]> data, uint64_t data_size)
+	{
+		post(dt, EventKind::sysex, 0, std::shared_ptr<const uint8_t[]>(std::move(data)), data_size);
+	}
+
+	void ThreadedMulticaster::meta(Duration dt, uint8_t type, io::ByteView data)
+	{
+		m_encoder.meta(dt, type, data);
+	}
+
+	void ThreadedMulticaster::sysex(Duration dt, io::ByteView data)
+	{
+		m_encoder.sysex(dt, data);
+	}
+
+	EventMask ThreadedMulticaster::interests() const
+	{
+		EventMask mask = 0;
+		for (const std::unique_ptr<WORKER>& worker : m_workers) {
+			mask |= worker->receiver->interests();
+		}
+		return mask;
+	}
+}
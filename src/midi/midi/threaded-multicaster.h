@@ -0,0 +1,90 @@
+#ifndef THREADED_MULTICASTER_H
+#define THREADED_MULTICASTER_H
+
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "midi/midi.h"
+#include "midi/event-reader.h"
+#include "util/spsc-queue.h"
+
+namespace midi {
+	/// <summary>
+	/// An event on its way to a ThreadedMulticaster worker. The payload of a meta or
+	/// sysex event is stored once and shared by the workers, event.payload views it.
+	/// </summary>
+	struct QUEUED_EVENT {
+		TRACK_EVENT event;
+		std::shared_ptr<const uint8_t[]> payload;
+	};
+
+	/// <summary>
+	/// Passes every event to a number of receivers, like EventMulticaster, but calls each
+	/// receiver on a thread of its own. The reading thread only queues events, so a slow
+	/// receiver holds up neither the reader nor the other receivers, until it falls
+	/// <c>queue_capacity</c> events behind.
+	/// Queueing costs more than calling a cheap receiver, such as a note collector, so this only
+	/// pays off for receivers that spend long on an event, e.g. on I/O; use EventMulticaster otherwise.
+	/// Receivers must not share unsynchronized state. Call finish() before using their results.
+	/// </summary>
+	class ThreadedMulticaster : public EventReceiver {
+	public:
+		ThreadedMulticaster(std::vector<std::shared_ptr<EventReceiver>> receivers, size_t queue_capacity = 4096);
+		~ThreadedMulticaster();
+
+		ThreadedMulticaster(const ThreadedMulticaster&) = delete;
+		ThreadedMulticaster& operator =(const ThreadedMulticaster&) = delete;
+
+		/// <summary>
+		/// Waits until the receivers have handled every event and stops the workers.
+		/// Rethrows the first exception a receiver threw. No events may follow.
+		/// </summary>
+		void finish();
+
+		// Inherited via EventReceiver
+		virtual void note_on(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) override;
+		virtual void note_off(Duration dt, Channel channel, NoteNumber note, uint8_t velocity) override;
+		virtual void polyphonic_key_pressure(Duration dt, Channel channel, NoteNumber note, uint8_t pressure) override;
+		virtual void control_change(Duration dt, Channel channel, uint8_t controller, uint8_t value) override;
+		virtual void program_change(Duration dt, Channel channel, Instrument program) override;
+		virtual void channel_pressure(Duration dt, Channel channel, uint8_t pressure) override;
+		virtual void pitch_wheel_change(Duration dt, Channel channel, uint16_t value) override;
+		virtual void meta(Duration dt, uint8_t type, std::unique_ptr<uint8_t[]> data, uint64_t data_size) override;
+		virtual void sysex(Duration dt, std::unique_ptr<uint8_t[]> data, uint64_t data_size) override;
+		virtual void meta(Duration dt, uint8_t type, io::ByteView data) override;
+		virtual void sysex(Duration dt, io::ByteView data) override;
+		virtual EventMask interests() const override;
+
+	private:
+		// Queues the events EventEncoder passes on
+		struct Poster {
+			ThreadedMulticaster* multicaster;
+
+			void add(Duration dt, EventKind kind, uint8_t channel, uint8_t data1, uint8_t data2);
+			void add_payload(Duration dt, EventKind kind, uint8_t data1, io::ByteView data);
+		};
+
+		struct WORKER {
+			std::shared_ptr<EventReceiver> receiver;
+			SpscQueue<QUEUED_EVENT> queue;
+			std::thread thread;
+			std::exception_ptr error;
+
+			WORKER(std::shared_ptr<EventReceiver> receiver, size_t queue_capacity) :
+				receiver(receiver), queue(queue_capacity) { }
+		};
+
+		static void work(WORKER& worker);
+
+		void post(Duration dt, EventKind kind, uint8_t channel, uint8_t data1, uint8_t data2);
+		void post(Duration dt, EventKind kind, uint8_t data1, std::shared_ptr<const uint8_t[]> payload, uint64_t size);
+
+		std::vector<std::unique_ptr<WORKER>> m_workers;
+		EventEncoder<Poster> m_encoder;
+		Time m_time;
+		bool m_finished;
+	};
+}
+#endif
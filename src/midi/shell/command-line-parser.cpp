@@ -1,6 +1,6 @@
 #include "command-line-parser.h"
-#include "logging.h"
 #include <assert.h>
+#include <climits>
 
 
 using namespace shell;
@@ -17,8 +17,11 @@ void CommandLineParser::add_argument(const std::string& prefix, std::function<vo
 void CommandLineParser::add_argument(const std::string& prefix, std::function<void(const std::string&)> processor)
 {
     std::function<void(std::list<std::string>&)> wrapper = [prefix, processor](std::list<std::string>& arguments) -> void {
-        CHECK(!arguments.empty())<< "Command line argument " << prefix << " expects an argument";
-        
+        if (arguments.empty())
+        {
+            throw CommandLineError("Command line argument " + prefix + " expects an argument");
+        }
+
         auto head = arguments.front();
         arguments.pop_front();
 
@@ -44,14 +47,31 @@ void CommandLineParser::add_argument(const std::string& prefix, std::string* tar
 
 void CommandLineParser::add_argument(const std::string& prefix, unsigned* target)
 {
-    add_argument(prefix, [target](const std::string& argument) {
-        *target = std::stoi(argument);
+    add_argument(prefix, [prefix, target](const std::string& argument) {
+        size_t end = 0;
+        unsigned long value = 0;
+        try
+        {
+            value = std::stoul(argument, &end);
+        }
+        catch (const std::logic_error&)
+        {
+        }
+
+        if (end == 0 || end != argument.size() || argument[0] == '-' || value > UINT_MAX)
+        {
+            throw CommandLineError("Command line argument " + prefix + " expects a number, got " + argument);
+        }
+        *target = unsigned(value);
     });
 }
 
 void CommandLineParser::add_argument(const std::string& prefix, std::function<void(std::list<std::string>&)> processor)
 {
-    CHECK(!is_prefix_in_use(prefix)) << "Clashing prefixes";
+    if (is_prefix_in_use(prefix))
+    {
+        throw std::logic_error("Clashing prefixes " + prefix);
+    }
 
     m_map[prefix] = processor;
 }
@@ -73,7 +93,10 @@ void CommandLineParser::process(std::list<std::string>& arguments)
         {
             auto it = m_map.find(head);
 
-            CHECK(it != m_map.end()) << "Unknown command " << head;
+            if (it == m_map.end())
+            {
+                throw CommandLineError("Unknown command " + head);
+            }
 
             auto processor = *it;
             processor.second(arguments);
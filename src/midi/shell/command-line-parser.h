@@ -5,9 +5,17 @@
 #include <vector>
 #include <list>
 #include <map>
+#include <stdexcept>
 
 namespace shell
 {
+    // Raised by process for arguments that do not match the registered ones
+    class CommandLineError : public std::runtime_error
+    {
+    public:
+        explicit CommandLineError(const std::string& message) : std::runtime_error(message) { }
+    };
+
     class CommandLineParser
     {
     public:
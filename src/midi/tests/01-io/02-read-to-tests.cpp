@@ -3,6 +3,7 @@
 #define TEST_CASE CATCH_TEST_CASE
 
 #include "io/read.h"
+#include "io/parse-error.h"
 #include "Catch.h"
 #include <sstream>
 
@@ -86,4 +87,22 @@ TEST_CASE("read_to<uint_16> from { 0x11, 0x22, 0x33, 0x44 } with n == 2")
     CATCH_CHECK(result[1] == 0x4433);
 }
 
+TEST_CASE("read_to past the end of the stream")
+{
+    uint32_t result[2];
+    char buffer[] = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 };
+    std::string data(buffer, sizeof(buffer));
+    std::stringstream ss(data);
+
+    try
+    {
+        io::read_to(ss, result, 2);
+        CATCH_FAIL("no ParseError");
+    }
+    catch (const io::ParseError& e)
+    {
+        CATCH_CHECK(e.offset() == 6);
+    }
+}
+
 #endif
@@ -7,12 +7,34 @@
 #include <sstream>
 
 
+// Every test below doubles as conformance test for the buffer-based decoders:
+// they must agree with the stream decoder on both value and length
+void check_buffer_decoders(const char* buffer, size_t size, uint64_t expected, std::streamoff expected_length)
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(buffer);
+
+    {
+        io::Cursor cursor(bytes, size);
+        CATCH_CHECK(io::read_variable_length_integer(cursor) == expected);
+        CATCH_CHECK(cursor.offset() == size_t(expected_length));
+    }
+
+    {
+        io::Cursor cursor(bytes, size);
+        uint64_t actual;
+        CATCH_REQUIRE(io::read_variable_length_integers(cursor, &actual, 1) == 1);
+        CATCH_CHECK(actual == expected);
+        CATCH_CHECK(cursor.offset() == size_t(expected_length));
+    }
+}
+
 TEST_CASE("Reading variable sized integer from { 0x00 }")
 {
     char buffer[] = { 0x00 };
     std::string data(buffer, sizeof(buffer));
     std::stringstream ss(data);
     auto actual = io::read_variable_length_integer(ss);
+    check_buffer_decoders(buffer, sizeof(buffer), actual, ss.tellg());
 
     CATCH_CHECK(actual == 0);
 }
@@ -23,6 +45,7 @@ TEST_CASE("Reading variable sized integer from { 0x01 }")
     std::string data(buffer, sizeof(buffer));
     std::stringstream ss(data);
     auto actual = io::read_variable_length_integer(ss);
+    check_buffer_decoders(buffer, sizeof(buffer), actual, ss.tellg());
 
     CATCH_CHECK(actual == 1);
 }
@@ -33,6 +56,7 @@ TEST_CASE("Reading variable sized integer from { 0x7F }")
     std::string data(buffer, sizeof(buffer));
     std::stringstream ss(data);
     auto actual = io::read_variable_length_integer(ss);
+    check_buffer_decoders(buffer, sizeof(buffer), actual, ss.tellg());
 
     CATCH_CHECK(actual == 0x7F);
 }
@@ -43,6 +67,7 @@ TEST_CASE("Reading variable sized integer from { 0x81, 0x00 }")
     std::string data(buffer, sizeof(buffer));
     std::stringstream ss(data);
     auto actual = io::read_variable_length_integer(ss);
+    check_buffer_decoders(buffer, sizeof(buffer), actual, ss.tellg());
 
     CATCH_CHECK(actual == (1 << 7));
 }
@@ -53,6 +78,7 @@ TEST_CASE("Reading variable sized integer from { 0x81, 0x80, 0x00 }")
     std::string data(buffer, sizeof(buffer));
     std::stringstream ss(data);
     auto actual = io::read_variable_length_integer(ss);
+    check_buffer_decoders(buffer, sizeof(buffer), actual, ss.tellg());
 
     CATCH_CHECK(actual == (1 << 14));
 }
@@ -63,6 +89,7 @@ TEST_CASE("Reading variable sized integer from { 0x81, 0x80, 0x80, 0x00 }")
     std::string data(buffer, sizeof(buffer));
     std::stringstream ss(data);
     auto actual = io::read_variable_length_integer(ss);
+    check_buffer_decoders(buffer, sizeof(buffer), actual, ss.tellg());
 
     CATCH_CHECK(actual == (1 << 21));
 }
@@ -73,6 +100,7 @@ TEST_CASE("Reading variable sized integer from { 0b10000001, 0b10000001, 0b10000
     std::string data(buffer, sizeof(buffer));
     std::stringstream ss(data);
     auto actual = io::read_variable_length_integer(ss);
+    check_buffer_decoders(buffer, sizeof(buffer), actual, ss.tellg());
 
     CATCH_CHECK(actual == 0b1000000100000010000001);
 }
@@ -83,6 +111,7 @@ TEST_CASE("Reading variable sized integer from { 0b10000111, 0b10010001, 0b11010
     std::string data(buffer, sizeof(buffer));
     std::stringstream ss(data);
     auto actual = io::read_variable_length_integer(ss);
+    check_buffer_decoders(buffer, sizeof(buffer), actual, ss.tellg());
 
     CATCH_CHECK(actual == 0b0000111001000110101010000000);
 }
@@ -93,6 +122,7 @@ TEST_CASE("Reading variable sized integer from { 0b10000111, 0b10010001, 0b11010
     std::string data(buffer, sizeof(buffer));
     std::stringstream ss(data);
     auto actual = io::read_variable_length_integer(ss);
+    check_buffer_decoders(buffer, sizeof(buffer), actual, ss.tellg());
 
     CATCH_CHECK(actual == 0b0000111001000110101010000000);
 }
@@ -103,6 +133,7 @@ TEST_CASE("Reading variable sized integer from { 0b00000111, 0b10010001, 0b11010
     std::string data(buffer, sizeof(buffer));
     std::stringstream ss(data);
     auto actual = io::read_variable_length_integer(ss);
+    check_buffer_decoders(buffer, sizeof(buffer), actual, ss.tellg());
 
     CATCH_CHECK(actual == 0b0000111);
 }
@@ -113,6 +144,7 @@ TEST_CASE("Reading variable sized integer from { 0b10000111, 0b10010001, 0b11010
     std::string data(buffer, sizeof(buffer));
     std::stringstream ss(data);
     auto actual = io::read_variable_length_integer(ss);
+    check_buffer_decoders(buffer, sizeof(buffer), actual, ss.tellg());
 
     CATCH_CHECK(actual == 0b0000111'0010001'1010101'1111111);
 }
@@ -123,6 +155,7 @@ TEST_CASE("Reading variable sized integer from { 0b11111111, 0b10000000, 0b10000
     std::string data(buffer, sizeof(buffer));
     std::stringstream ss(data);
     auto actual = io::read_variable_length_integer(ss);
+    check_buffer_decoders(buffer, sizeof(buffer), actual, ss.tellg());
 
     CATCH_CHECK(actual == 0b1111111'0000000'0000000'0001100'0000010);
 }
@@ -0,0 +1,110 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "io/cursor.h"
+#include "io/mapped-file.h"
+#include "Catch.h"
+#include <cstdio>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+
+#define TEST(type, expected, ...)                                      \
+        TEST_CASE("read<" #type "> from cursor over { " #__VA_ARGS__ " }") \
+        {                                                              \
+            uint8_t buffer[] = { __VA_ARGS__ };                        \
+            io::Cursor cursor(buffer, sizeof(buffer));                 \
+                                                                       \
+            type result = io::read<type>(cursor);                      \
+            CATCH_CHECK(result == expected);                           \
+            CATCH_CHECK(cursor.at_end());                              \
+        }
+
+
+TEST(uint8_t, 0, 0)
+TEST(uint8_t, 77, 77)
+
+TEST(uint16_t, 1, 1, 0)
+TEST(uint16_t, 256, 0, 1)
+
+TEST(uint32_t, 0x01000000, 0, 0, 0, 1)
+TEST(uint32_t, 0x12345678, 0x78, 0x56, 0x34, 0x12)
+
+TEST_CASE("Cursor keeps track of offset and remaining bytes")
+{
+    uint8_t buffer[] = { 1, 2, 3, 4, 5 };
+    io::Cursor cursor(buffer, sizeof(buffer));
+
+    CATCH_CHECK(cursor.offset() == 0);
+    CATCH_CHECK(cursor.remaining() == 5);
+
+    io::read<uint16_t>(cursor);
+    CATCH_CHECK(cursor.offset() == 2);
+    CATCH_CHECK(cursor.remaining() == 3);
+
+    cursor.skip(3);
+    CATCH_CHECK(cursor.offset() == 5);
+    CATCH_CHECK(cursor.at_end());
+}
+
+TEST_CASE("read_array from cursor")
+{
+    uint8_t buffer[] = { 5, 4, 3, 2, 1 };
+    io::Cursor cursor(buffer, sizeof(buffer));
+
+    std::unique_ptr<uint8_t[]> result = io::read_array<uint8_t>(cursor, 4);
+
+    CATCH_CHECK(result[0] == 5);
+    CATCH_CHECK(result[1] == 4);
+    CATCH_CHECK(result[2] == 3);
+    CATCH_CHECK(result[3] == 2);
+    CATCH_CHECK(cursor.remaining() == 1);
+}
+
+TEST_CASE("MappedFile exposes file contents")
+{
+    const char* path = "mapped-file-test.tmp";
+    {
+        std::ofstream out(path, std::ofstream::binary);
+        out << "MThd";
+    }
+
+    {
+        io::MappedFile file(path);
+        io::Cursor cursor = file.cursor();
+
+        CATCH_REQUIRE(file.size() == 4);
+        CATCH_CHECK(io::read<uint8_t>(cursor) == 'M');
+        CATCH_CHECK(io::read<uint8_t>(cursor) == 'T');
+        CATCH_CHECK(io::read<uint8_t>(cursor) == 'h');
+        CATCH_CHECK(io::read<uint8_t>(cursor) == 'd');
+    }
+
+    std::remove(path);
+}
+
+TEST_CASE("MappedFile of empty file")
+{
+    const char* path = "mapped-file-empty-test.tmp";
+    {
+        std::ofstream out(path, std::ofstream::binary);
+    }
+
+    {
+        io::MappedFile file(path);
+
+        CATCH_CHECK(file.size() == 0);
+        CATCH_CHECK(file.cursor().at_end());
+    }
+
+    std::remove(path);
+}
+
+TEST_CASE("MappedFile of missing file")
+{
+    CATCH_CHECK_THROWS_AS(io::MappedFile("mapped-file-missing-test.tmp"), std::system_error);
+}
+
+#endif
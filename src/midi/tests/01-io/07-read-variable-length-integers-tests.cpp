@@ -0,0 +1,110 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "io/vli.h"
+#include "Catch.h"
+#include <vector>
+
+
+namespace
+{
+    void write_variable_length_integer(std::vector<uint8_t>& out, uint64_t value)
+    {
+        uint8_t bytes[10];
+        int n = 0;
+
+        do
+        {
+            bytes[n++] = value & 0x7F;
+            value >>= 7;
+        } while (value != 0);
+
+        while (n != 0)
+        {
+            --n;
+            out.push_back(uint8_t(bytes[n] | (n != 0 ? 0x80 : 0x00)));
+        }
+    }
+
+    void check_bulk(const std::vector<uint64_t>& values)
+    {
+        std::vector<uint8_t> buffer;
+        for (auto value : values)
+        {
+            write_variable_length_integer(buffer, value);
+        }
+
+        io::Cursor cursor(buffer);
+        std::vector<uint64_t> actual(values.size());
+        size_t n = io::read_variable_length_integers(cursor, actual.data(), actual.size());
+
+        CATCH_REQUIRE(n == values.size());
+        CATCH_CHECK(cursor.at_end());
+        for (size_t i = 0; i != values.size(); ++i)
+        {
+            CATCH_CHECK(actual[i] == values[i]);
+        }
+    }
+}
+
+
+TEST_CASE("Reading variable sized integers in bulk, empty buffer")
+{
+    io::Cursor cursor(nullptr, size_t(0));
+    uint64_t actual[4];
+
+    CATCH_CHECK(io::read_variable_length_integers(cursor, actual, 4) == 0);
+}
+
+TEST_CASE("Reading variable sized integers in bulk, stops at requested count")
+{
+    uint8_t buffer[] = { 1, 2, 3, 4 };
+    io::Cursor cursor(buffer, sizeof(buffer));
+    uint64_t actual[2];
+
+    CATCH_REQUIRE(io::read_variable_length_integers(cursor, actual, 2) == 2);
+    CATCH_CHECK(actual[0] == 1);
+    CATCH_CHECK(actual[1] == 2);
+    CATCH_CHECK(cursor.offset() == 2);
+}
+
+TEST_CASE("Reading variable sized integers in bulk, stops at end of buffer")
+{
+    uint8_t buffer[] = { 0x81, 0x00, 0x7F };
+    io::Cursor cursor(buffer, sizeof(buffer));
+    uint64_t actual[8];
+
+    CATCH_REQUIRE(io::read_variable_length_integers(cursor, actual, 8) == 2);
+    CATCH_CHECK(actual[0] == 0x80);
+    CATCH_CHECK(actual[1] == 0x7F);
+}
+
+TEST_CASE("Reading variable sized integers in bulk, only single bytes")
+{
+    std::vector<uint64_t> values;
+    for (uint64_t i = 0; i != 100; ++i)
+    {
+        values.push_back(i);
+    }
+
+    check_bulk(values);
+}
+
+TEST_CASE("Reading variable sized integers in bulk, mixed lengths")
+{
+    std::vector<uint64_t> values;
+    for (uint64_t i = 0; i != 500; ++i)
+    {
+        values.push_back((i * 7919) % (uint64_t(1) << (i % 29)));
+    }
+
+    check_bulk(values);
+}
+
+TEST_CASE("Reading variable sized integers in bulk, integers longer than a block")
+{
+    check_bulk({ 1, uint64_t(1) << 62, 2, 3, uint64_t(0xFFFFFFFFFFFFFFFF), 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17 });
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "io/endianness.h"
+#include "io/cursor.h"
+#include "midi/midi.h"
+#include "util/check-size.h"
+#include "Catch.h"
+#include <cstddef>
+#include <vector>
+
+
+namespace
+{
+    template<typename T>
+    void test_bulk_switch_endianness(size_t count)
+    {
+        std::vector<T> values(count);
+        std::vector<T> expected(count);
+        for (size_t i = 0; i != count; ++i)
+        {
+            values[i] = T(0x0123456789ABCDEFull * (i + 1));
+            expected[i] = values[i];
+            io::switch_endianness(&expected[i]);
+        }
+
+        io::switch_endianness(values.data(), count);
+
+        CATCH_CHECK(values == expected);
+    }
+}
+
+
+TEST_CASE("Checking that big endian integers have no padding or alignment")
+{
+    check_size<io::be_uint16, sizeof(uint16_t)>();
+    check_size<io::be_uint32, sizeof(uint32_t)>();
+    check_size<io::be_uint64, sizeof(uint64_t)>();
+    static_assert(alignof(io::be_uint16) == 1, "be_uint16 requires alignment");
+    static_assert(alignof(io::be_uint64) == 1, "be_uint64 requires alignment");
+}
+
+TEST_CASE("Checking that raw headers match the file layout")
+{
+    check_size<midi::RAW_CHUNK_HEADER, 8>();
+    check_size<midi::RAW_MTHD, 14>();
+    static_assert(offsetof(midi::RAW_MTHD, type) == 8, "RAW_MTHD's type field does not have the correct offset");
+    static_assert(offsetof(midi::RAW_MTHD, ntracks) == 10, "RAW_MTHD's ntracks field does not have the correct offset");
+    static_assert(offsetof(midi::RAW_MTHD, division) == 12, "RAW_MTHD's division field does not have the correct offset");
+}
+
+TEST_CASE("Byte swapping at compile time")
+{
+    static_assert(io::byteswap(uint16_t(0x1234)) == 0x3412, "16 bit");
+    static_assert(io::byteswap(uint32_t(0x12345678)) == 0x78563412, "32 bit");
+    static_assert(io::byteswap(uint64_t(0x0123456789ABCDEF)) == 0xEFCDAB8967452301, "64 bit");
+    static_assert(io::be_uint32(0x12345678).raw() == 0x78563412, "be_uint32 stores big endian");
+    static_assert(io::be_uint32(0x12345678).value() == 0x12345678, "be_uint32 round trip");
+}
+
+TEST_CASE("Overlaying big endian integers on a buffer")
+{
+    char buffer[] = { 0x12, 0x34, 0x56, 0x78, char(0x9A), char(0xBC) };
+    io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+
+    // Deliberately misaligned for the 32-bit value
+    const io::be_uint16* first = io::overlay<io::be_uint16>(cursor);
+    const io::be_uint32* second = io::overlay<io::be_uint32>(cursor);
+
+    CATCH_CHECK(*first == 0x1234);
+    CATCH_CHECK(*second == 0x56789ABC);
+    CATCH_CHECK(cursor.at_end());
+    CATCH_CHECK_THROWS_AS(io::overlay<io::be_uint16>(cursor), io::ParseError);
+}
+
+TEST_CASE("Overlaying MThd on a buffer")
+{
+    char buffer[] = {
+        'M', 'T', 'h', 'd',
+        0x00, 0x00, 0x00, 0x06,
+        0x00, 0x01,
+        0x00, 0x12,
+        0x01, char(0x80)
+    };
+    io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+
+    const midi::RAW_MTHD* mthd = io::overlay<midi::RAW_MTHD>(cursor);
+
+    CATCH_CHECK(mthd->header.size == 6);
+    CATCH_CHECK(mthd->type == 1);
+    CATCH_CHECK(mthd->ntracks == 0x12);
+    CATCH_CHECK(mthd->division == 0x180);
+}
+
+TEST_CASE("Switching endianness of 16 bit arrays")
+{
+    for (size_t count = 0; count != 40; ++count)
+    {
+        test_bulk_switch_endianness<uint16_t>(count);
+    }
+}
+
+TEST_CASE("Switching endianness of 32 bit arrays")
+{
+    for (size_t count = 0; count != 20; ++count)
+    {
+        test_bulk_switch_endianness<uint32_t>(count);
+    }
+}
+
+TEST_CASE("Switching endianness of 64 bit arrays")
+{
+    for (size_t count = 0; count != 10; ++count)
+    {
+        test_bulk_switch_endianness<uint64_t>(count);
+    }
+}
+
+#endif
@@ -0,0 +1,242 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "tests/tests-util.h"
+#include "io/parse-error.h"
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    io::Cursor cursor_over(const char* buffer, size_t size)
+    {
+        return io::Cursor(reinterpret_cast<const uint8_t*>(buffer), size);
+    }
+
+    // Receives events from tracks that are expected to be rejected
+    struct IgnoringEventReceiver : public midi::EventReceiver
+    {
+        unsigned count = 0;
+
+        void note_on(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t) override { ++count; }
+        void note_off(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t) override { ++count; }
+        void polyphonic_key_pressure(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t) override { ++count; }
+        void control_change(midi::Duration, midi::Channel, uint8_t, uint8_t) override { ++count; }
+        void program_change(midi::Duration, midi::Channel, midi::Instrument) override { ++count; }
+        void channel_pressure(midi::Duration, midi::Channel, uint8_t) override { ++count; }
+        void pitch_wheel_change(midi::Duration, midi::Channel, uint16_t) override { ++count; }
+        void meta(midi::Duration, uint8_t, std::unique_ptr<uint8_t[]>, uint64_t) override { ++count; }
+        void sysex(midi::Duration, std::unique_ptr<uint8_t[]>, uint64_t) override { ++count; }
+    };
+}
+
+
+TEST_CASE("Reading bounded MTrk with mixed events")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 30, // Length
+        0, NOTE_ON(1, 10, 55),
+        char(0x81), 0x00, NOTE_ON_RS(20, 66),
+        10, char(0xFF), 0x01, 0x02, 'a', 'b',
+        5, CONTROL_CHANGE(2, 7, 100),
+        20, char(0xF0), 0x01, 0x42,
+        0, PITCH_WHEEL_CHANGE(3, 300),
+        END_OF_TRACK
+    };
+    io::Cursor cursor = cursor_over(buffer, sizeof(buffer));
+
+    auto receiver = Builder()
+        .note_on(midi::Duration(0), midi::Channel(1), midi::NoteNumber(10), 55)
+        .note_on(midi::Duration(128), midi::Channel(1), midi::NoteNumber(20), 66)
+        .meta(midi::Duration(10), 0x01, "ab")
+        .control_change(midi::Duration(5), midi::Channel(2), 7, 100)
+        .sysex(midi::Duration(20), "\x42")
+        .pitch_wheel_change(midi::Duration(0), midi::Channel(3), 300)
+        .meta(midi::Duration(0), 0x2F, "")
+        .build();
+
+    midi::read_mtrk(cursor, *receiver, midi::ChunkMode::bounded);
+    receiver->check_finished();
+    CATCH_CHECK(cursor.at_end());
+}
+
+TEST_CASE("Reading bounded MTrk moves to the end of the chunk")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 6, // Length
+        END_OF_TRACK,
+        0x00, 0x00, // Padding inside chunk
+        0x12
+    };
+    io::Cursor cursor = cursor_over(buffer, sizeof(buffer));
+
+    auto receiver = Builder().meta(midi::Duration(0), 0x2F, "").build();
+    midi::read_mtrk(cursor, *receiver, midi::ChunkMode::bounded);
+    receiver->check_finished();
+
+    CATCH_CHECK(cursor.remaining() == 1);
+}
+
+TEST_CASE("Reading bounded MTrk whose chunk exceeds the buffer")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 12, // Length
+        END_OF_TRACK
+    };
+    io::Cursor cursor = cursor_over(buffer, sizeof(buffer));
+    IgnoringEventReceiver receiver;
+
+    CATCH_REQUIRE_THROWS_AS(midi::read_mtrk(cursor, receiver, midi::ChunkMode::bounded), io::ParseError);
+    CATCH_CHECK(receiver.count == 0);
+}
+
+TEST_CASE("Reading bounded MTrk without End-of-Track")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 7, // Length
+        0, NOTE_ON(0, 10, 55),
+        0, NOTE_ON_RS(10, 0)
+    };
+    io::Cursor cursor = cursor_over(buffer, sizeof(buffer));
+    IgnoringEventReceiver receiver;
+
+    try
+    {
+        midi::read_mtrk(cursor, receiver, midi::ChunkMode::bounded);
+        CATCH_FAIL("Expected io::ParseError");
+    }
+    catch (const io::ParseError& error)
+    {
+        CATCH_CHECK(error.offset() == sizeof(buffer));
+        CATCH_CHECK(error.reason() == "missing End-of-Track");
+    }
+
+    CATCH_CHECK(receiver.count == 2);
+}
+
+TEST_CASE("Reading bounded MTrk with truncated event")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 6, // Length
+        0, NOTE_ON(0, 10, 55),
+        0, char(0x90),
+        END_OF_TRACK
+    };
+    io::Cursor cursor = cursor_over(buffer, sizeof(buffer));
+    IgnoringEventReceiver receiver;
+
+    CATCH_REQUIRE_THROWS_AS(midi::read_mtrk(cursor, receiver, midi::ChunkMode::bounded), io::ParseError);
+    CATCH_CHECK(receiver.count == 1);
+}
+
+TEST_CASE("Reading bounded MTrk with meta event running past the chunk")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 16, // Length
+        0, char(0xFF), 0x01, 0x20, 'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h',
+        END_OF_TRACK
+    };
+    io::Cursor cursor = cursor_over(buffer, sizeof(buffer));
+    IgnoringEventReceiver receiver;
+
+    CATCH_REQUIRE_THROWS_AS(midi::read_mtrk(cursor, receiver, midi::ChunkMode::bounded), io::ParseError);
+    CATCH_CHECK(receiver.count == 0);
+}
+
+TEST_CASE("Reading bounded MTrk starting with running status")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 7, // Length
+        0, NOTE_ON_RS(10, 0),
+        END_OF_TRACK
+    };
+    io::Cursor cursor = cursor_over(buffer, sizeof(buffer));
+    IgnoringEventReceiver receiver;
+
+    try
+    {
+        midi::read_mtrk(cursor, receiver, midi::ChunkMode::bounded);
+        CATCH_FAIL("Expected io::ParseError");
+    }
+    catch (const io::ParseError& error)
+    {
+        CATCH_CHECK(error.offset() == 9);
+    }
+}
+
+TEST_CASE("Reading bounded MTrk with delta time longer than four bytes")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 13, // Length
+        char(0x81), char(0x80), char(0x80), char(0x80), 0x00, NOTE_ON(0, 10, 55),
+        END_OF_TRACK
+    };
+    io::Cursor cursor = cursor_over(buffer, sizeof(buffer));
+    IgnoringEventReceiver receiver;
+
+    CATCH_REQUIRE_THROWS_AS(midi::read_mtrk(cursor, receiver, midi::ChunkMode::bounded), io::ParseError);
+}
+
+TEST_CASE("Reading bounded MTrk with delta time longer than four bytes near the end of the chunk")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 12, // Length
+        0, NOTE_ON(0, 10, 55),
+        char(0x81), char(0x80), char(0x80), char(0x80), 0x00, char(0xFF), 0x2F, 0x00
+    };
+    io::Cursor cursor = cursor_over(buffer, sizeof(buffer));
+    IgnoringEventReceiver receiver;
+
+    try
+    {
+        midi::read_mtrk(cursor, receiver, midi::ChunkMode::bounded);
+        CATCH_FAIL("Expected io::ParseError");
+    }
+    catch (const io::ParseError& error)
+    {
+        CATCH_CHECK(error.offset() == 12);
+    }
+    CATCH_CHECK(receiver.count == 1);
+}
+
+TEST_CASE("read_notes in bounded mode, two tracks and extended header")
+{
+    char buffer[] = {
+        MTHD,
+        0x00, 0x00, 0x00, 0x08, // MThd size
+        0x00, 0x01, // Type
+        0x00, 0x02, // Number of tracks
+        0x01, 0x00, // Division
+        0x00, 0x00, // Header extension
+        MTRK,
+        0x00, 0x00, 0x00, 12, // MTrk size
+        0, NOTE_ON(0, 5, 127),
+        100, NOTE_OFF(0, 5, 0),
+        END_OF_TRACK,
+        MTRK,
+        0x00, 0x00, 0x00, 12, // MTrk size
+        50, NOTE_ON(1, 7, 64),
+        50, NOTE_ON(1, 7, 0),
+        END_OF_TRACK
+    };
+    io::Cursor cursor = cursor_over(buffer, sizeof(buffer));
+    std::vector<midi::NOTE> notes = midi::read_notes(cursor, midi::ChunkMode::bounded);
+
+    CATCH_REQUIRE(notes.size() == 2);
+    CATCH_CHECK(notes[0] == midi::NOTE(midi::NoteNumber(5), midi::Time(0), midi::Duration(100), 127, midi::Instrument(0)));
+    CATCH_CHECK(notes[1] == midi::NOTE(midi::NoteNumber(7), midi::Time(50), midi::Duration(50), 64, midi::Instrument(0)));
+}
+
+#endif
@@ -0,0 +1,122 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "tests/tests-util.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    // Only overrides the view overloads; the owning ones must never be called
+    struct PayloadRecorder : public midi::EventReceiver
+    {
+        std::vector<io::ByteView> views;
+        std::vector<std::string> payloads;
+
+        void note_on(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t) override { }
+        void note_off(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t) override { }
+        void polyphonic_key_pressure(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t) override { }
+        void control_change(midi::Duration, midi::Channel, uint8_t, uint8_t) override { }
+        void program_change(midi::Duration, midi::Channel, midi::Instrument) override { }
+        void channel_pressure(midi::Duration, midi::Channel, uint8_t) override { }
+        void pitch_wheel_change(midi::Duration, midi::Channel, uint16_t) override { }
+
+        void meta(midi::Duration, uint8_t, std::unique_ptr<uint8_t[]>, uint64_t) override
+        {
+            CATCH_FAIL("Owning meta overload called");
+        }
+
+        void sysex(midi::Duration, std::unique_ptr<uint8_t[]>, uint64_t) override
+        {
+            CATCH_FAIL("Owning sysex overload called");
+        }
+
+        void meta(midi::Duration, uint8_t, io::ByteView data) override
+        {
+            record(data);
+        }
+
+        void sysex(midi::Duration, io::ByteView data) override
+        {
+            record(data);
+        }
+
+        void record(io::ByteView data)
+        {
+            views.push_back(data);
+            payloads.push_back(std::string(data.begin(), data.end()));
+        }
+    };
+}
+
+
+TEST_CASE("Reading MTrk from a buffer, payloads point into the buffer")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 16, // Length
+        0, char(0xFF), 0x05, 0x03, 'l', 'a', 'a',
+        10, char(0xF0), 0x02, 0x12, 0x34,
+        END_OF_TRACK
+    };
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(buffer);
+
+    for (midi::ChunkMode mode : { midi::ChunkMode::lenient, midi::ChunkMode::bounded })
+    {
+        io::Cursor cursor(bytes, sizeof(buffer));
+        PayloadRecorder receiver;
+        midi::read_mtrk(cursor, receiver, mode);
+
+        CATCH_REQUIRE(receiver.views.size() == 3);
+        CATCH_CHECK(receiver.views[0].data() == bytes + 12);
+        CATCH_CHECK(receiver.views[0].size() == 3);
+        CATCH_CHECK(receiver.views[1].data() == bytes + 18);
+        CATCH_CHECK(receiver.views[1].size() == 2);
+        CATCH_CHECK(receiver.views[2].empty());
+    }
+}
+
+TEST_CASE("Reading MTrk from a stream, payloads are delivered as views")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 21, // Length
+        0, char(0xFF), 0x05, 0x03, 'l', 'a', 'a',
+        10, char(0xF0), 0x02, 0x12, 0x34,
+        0, char(0xFF), 0x06, 0x01, 'x',
+        END_OF_TRACK
+    };
+    std::string data(buffer, sizeof(buffer));
+    std::stringstream ss(data);
+
+    PayloadRecorder receiver;
+    midi::read_mtrk(ss, receiver);
+
+    CATCH_REQUIRE(receiver.payloads.size() == 4);
+    CATCH_CHECK(receiver.payloads[0] == "laa");
+    CATCH_CHECK(receiver.payloads[1] == "\x12\x34");
+    CATCH_CHECK(receiver.payloads[2] == "x");
+    CATCH_CHECK(receiver.payloads[3] == "");
+}
+
+TEST_CASE("Owning receivers get their own copy of view payloads")
+{
+    auto receiver = Builder()
+        .meta(midi::Duration(3), 0x01, "abc")
+        .sysex(midi::Duration(4), "de")
+        .build();
+    const uint8_t bytes[] = { 'a', 'b', 'c', 'd', 'e' };
+
+    midi::EventReceiver& base = *receiver;
+    base.meta(midi::Duration(3), 0x01, io::ByteView(bytes, 3));
+    base.sysex(midi::Duration(4), io::ByteView(bytes + 3, 2));
+
+    receiver->check_finished();
+}
+
+#endif
@@ -0,0 +1,138 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "tests/tests-util.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    // Not derived from EventReceiver; only usable through the read_mtrk templates
+    struct EventLog
+    {
+        std::vector<std::string> events;
+
+        void note_on(midi::Duration dt, midi::Channel channel, midi::NoteNumber note, uint8_t velocity)
+        {
+            log("note_on", dt, value(channel), value(note), velocity);
+        }
+
+        void note_off(midi::Duration dt, midi::Channel channel, midi::NoteNumber note, uint8_t velocity)
+        {
+            log("note_off", dt, value(channel), value(note), velocity);
+        }
+
+        void polyphonic_key_pressure(midi::Duration dt, midi::Channel channel, midi::NoteNumber note, uint8_t pressure)
+        {
+            log("polyphonic_key_pressure", dt, value(channel), value(note), pressure);
+        }
+
+        void control_change(midi::Duration dt, midi::Channel channel, uint8_t controller, uint8_t amount)
+        {
+            log("control_change", dt, value(channel), controller, amount);
+        }
+
+        void program_change(midi::Duration dt, midi::Channel channel, midi::Instrument program)
+        {
+            log("program_change", dt, value(channel), value(program), 0);
+        }
+
+        void channel_pressure(midi::Duration dt, midi::Channel channel, uint8_t pressure)
+        {
+            log("channel_pressure", dt, value(channel), pressure, 0);
+        }
+
+        void pitch_wheel_change(midi::Duration dt, midi::Channel channel, uint16_t wheel)
+        {
+            log("pitch_wheel_change", dt, value(channel), wheel, 0);
+        }
+
+        void meta(midi::Duration dt, uint8_t type, io::ByteView data)
+        {
+            log("meta", dt, type, unsigned(data.size()), 0);
+        }
+
+        void sysex(midi::Duration dt, io::ByteView data)
+        {
+            log("sysex", dt, unsigned(data.size()), 0, 0);
+        }
+
+        void log(const std::string& name, midi::Duration dt, unsigned a, unsigned b, unsigned c)
+        {
+            std::ostringstream ss;
+            ss << name << ' ' << value(dt) << ' ' << a << ' ' << b << ' ' << c;
+            events.push_back(ss.str());
+        }
+    };
+
+    struct NoteOnsOnly
+    {
+        void note_on(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t) { }
+    };
+
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 35, // Length
+        0, NOTE_ON(1, 10, 55),
+        char(0x81), 0x00, NOTE_OFF(1, 10, 0),
+        1, POLYPHONIC_KEY_PRESSURE(2, 3, 4),
+        2, CONTROL_CHANGE(3, 7, 100),
+        3, PROGRAM_CHANGE(4, 12),
+        4, CHANNEL_PRESSURE(5, 42),
+        5, PITCH_WHEEL_CHANGE(6, 300),
+        6, char(0xF0), 0x01, 0x42,
+        END_OF_TRACK
+    };
+
+    const std::vector<std::string> expected = {
+        "note_on 0 1 10 55",
+        "note_off 128 1 10 0",
+        "polyphonic_key_pressure 1 2 3 4",
+        "control_change 2 3 7 100",
+        "program_change 3 4 12 0",
+        "channel_pressure 4 5 42 0",
+        "pitch_wheel_change 5 6 300 0",
+        "sysex 6 1 0 0",
+        "meta 0 47 0 0"
+    };
+}
+
+
+TEST_CASE("Checking which types are event receivers")
+{
+    static_assert(midi::is_event_receiver<EventLog>::value, "EventLog has all callbacks");
+    static_assert(midi::is_event_receiver<midi::EventReceiver>::value, "EventReceiver has all callbacks");
+    static_assert(midi::is_event_receiver<midi::NoteCollector>::value, "NoteCollector has all callbacks");
+    static_assert(!midi::is_event_receiver<NoteOnsOnly>::value, "NoteOnsOnly lacks callbacks");
+    static_assert(!midi::is_event_receiver<int>::value, "int is no receiver");
+}
+
+TEST_CASE("Reading MTrk from a buffer into a statically dispatched receiver")
+{
+    for (midi::ChunkMode mode : { midi::ChunkMode::lenient, midi::ChunkMode::bounded })
+    {
+        io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+        EventLog log;
+        midi::read_mtrk(cursor, log, mode);
+
+        CATCH_CHECK(log.events == expected);
+        CATCH_CHECK(cursor.at_end());
+    }
+}
+
+TEST_CASE("Reading MTrk from a stream into a statically dispatched receiver")
+{
+    std::string data(buffer, sizeof(buffer));
+    std::stringstream ss(data);
+    EventLog log;
+    midi::read_mtrk(ss, log);
+
+    CATCH_CHECK(log.events == expected);
+}
+
+#endif
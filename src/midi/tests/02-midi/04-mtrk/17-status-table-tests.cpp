@@ -0,0 +1,52 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "midi/midi.h"
+#include "midi/status-table.h"
+#include "Catch.h"
+
+
+static_assert(midi::status_table[0x00].kind == midi::EventKind::running_status, "0x00 is a data byte");
+static_assert(midi::status_table[0x93].kind == midi::EventKind::note_on, "0x93 is note on");
+static_assert(midi::status_table[0x93].channel == 3, "0x93 is on channel 3");
+static_assert(midi::status_table[0xC5].data_bytes == 1, "program change has one data byte");
+static_assert(midi::status_table[0xFF].kind == midi::EventKind::meta, "0xFF is meta");
+static_assert(midi::status_table[0xF8].kind == midi::EventKind::invalid, "0xF8 does not occur in files");
+
+
+TEST_CASE("Status table agrees with the classification functions")
+{
+    for (unsigned status = 0; status != 256; ++status)
+    {
+        CATCH_INFO("Status byte " << status);
+
+        uint8_t byte = uint8_t(status);
+        midi::STATUS_INFO info = midi::status_table[byte];
+        uint8_t type = midi::extract_midi_event_type(byte);
+
+        CATCH_CHECK((info.kind == midi::EventKind::running_status) == midi::is_running_status(byte));
+        CATCH_CHECK((info.kind == midi::EventKind::meta) == midi::is_meta_event(byte));
+        CATCH_CHECK((info.kind == midi::EventKind::sysex) == midi::is_sysex_event(byte));
+        CATCH_CHECK((info.data_bytes != 0) == midi::is_midi_event(byte));
+
+        if (midi::is_midi_event(byte))
+        {
+            CATCH_CHECK(midi::Channel(info.channel) == midi::extract_midi_event_channel(byte));
+            CATCH_CHECK((info.kind == midi::EventKind::note_off) == midi::is_note_off(type));
+            CATCH_CHECK((info.kind == midi::EventKind::note_on) == midi::is_note_on(type));
+            CATCH_CHECK((info.kind == midi::EventKind::polyphonic_key_pressure) == midi::is_polyphonic_key_pressure(type));
+            CATCH_CHECK((info.kind == midi::EventKind::control_change) == midi::is_control_change(type));
+            CATCH_CHECK((info.kind == midi::EventKind::program_change) == midi::is_program_change(type));
+            CATCH_CHECK((info.kind == midi::EventKind::channel_pressure) == midi::is_channel_pressure(type));
+            CATCH_CHECK((info.kind == midi::EventKind::pitch_wheel_change) == midi::is_pitch_wheel_change(type));
+            CATCH_CHECK(info.data_bytes == (midi::is_program_change(type) || midi::is_channel_pressure(type) ? 1 : 2));
+        }
+        else
+        {
+            CATCH_CHECK(info.data_bytes == 0);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,135 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "tests/tests-util.h"
+#include "midi/event-batch.h"
+#include "io/parse-error.h"
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 33, // Length
+        0, NOTE_ON(1, 10, 55),
+        char(0x81), 0x00, NOTE_ON_RS(10, 0),
+        1, POLYPHONIC_KEY_PRESSURE(2, 3, 4),
+        2, CONTROL_CHANGE(3, 7, 100),
+        3, PROGRAM_CHANGE(4, 12),
+        4, PITCH_WHEEL_CHANGE(6, 300),
+        10, char(0xFF), 0x01, 0x02, 'a', 'b',
+        END_OF_TRACK
+    };
+
+    io::Cursor cursor_over_buffer()
+    {
+        return io::Cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+    }
+
+    void check_batch(const midi::EventBatch& batch)
+    {
+        using midi::EventKind;
+
+        CATCH_REQUIRE(batch.size() == 8);
+        CATCH_CHECK(batch.dt == std::vector<uint64_t>({ 0, 128, 1, 2, 3, 4, 10, 0 }));
+        CATCH_CHECK(batch.kind == std::vector<EventKind>({
+            EventKind::note_on, EventKind::note_on, EventKind::polyphonic_key_pressure, EventKind::control_change,
+            EventKind::program_change, EventKind::pitch_wheel_change, EventKind::meta, EventKind::meta }));
+        CATCH_CHECK(batch.channel == std::vector<uint8_t>({ 1, 1, 2, 3, 4, 6, 0, 0 }));
+        CATCH_CHECK(batch.data1 == std::vector<uint8_t>({ 10, 10, 3, 7, 12, 300 & 0x7F, 0x01, 0x2F }));
+        CATCH_CHECK(batch.data2 == std::vector<uint8_t>({ 55, 0, 4, 100, 0, 300 >> 7, 0, 0 }));
+        CATCH_CHECK(batch.payload_offset[6] == 35);
+        CATCH_CHECK(batch.payload_size == std::vector<uint32_t>({ 0, 0, 0, 0, 0, 0, 2, 0 }));
+    }
+}
+
+
+TEST_CASE("Reading a whole MTrk into an event batch")
+{
+    for (midi::ChunkMode mode : { midi::ChunkMode::lenient, midi::ChunkMode::bounded })
+    {
+        io::Cursor cursor = cursor_over_buffer();
+        midi::EventBatch batch = midi::read_mtrk_batch(cursor, mode);
+
+        check_batch(batch);
+        CATCH_CHECK(cursor.at_end());
+    }
+}
+
+TEST_CASE("Reading an MTrk into event batches, a few events at a time")
+{
+    for (size_t chunk = 1; chunk != 10; ++chunk)
+    {
+        for (midi::ChunkMode mode : { midi::ChunkMode::lenient, midi::ChunkMode::bounded })
+        {
+            io::Cursor cursor = cursor_over_buffer();
+            midi::TrackDecoder decoder(cursor, mode);
+            midi::EventBatch all;
+            midi::EventBatch part;
+            size_t calls = 0;
+
+            while (!decoder.finished())
+            {
+                part.clear();
+                size_t n = decoder.decode(part, chunk);
+                CATCH_CHECK(n == part.size());
+                CATCH_CHECK(n == std::min(chunk, 8 - all.size()));
+
+                all.dt.insert(all.dt.end(), part.dt.begin(), part.dt.end());
+                all.kind.insert(all.kind.end(), part.kind.begin(), part.kind.end());
+                all.channel.insert(all.channel.end(), part.channel.begin(), part.channel.end());
+                all.data1.insert(all.data1.end(), part.data1.begin(), part.data1.end());
+                all.data2.insert(all.data2.end(), part.data2.begin(), part.data2.end());
+                all.payload_offset.insert(all.payload_offset.end(), part.payload_offset.begin(), part.payload_offset.end());
+                all.payload_size.insert(all.payload_size.end(), part.payload_size.begin(), part.payload_size.end());
+                ++calls;
+            }
+
+            check_batch(all);
+            CATCH_CHECK(calls == (8 + chunk - 1) / chunk);
+            CATCH_CHECK(decoder.decode(part, chunk) == 0);
+        }
+    }
+}
+
+TEST_CASE("Reading a truncated MTrk into an event batch")
+{
+    io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer) - 4);
+
+    CATCH_CHECK_THROWS_AS(midi::read_mtrk_batch(cursor, midi::ChunkMode::lenient), io::ParseError);
+}
+
+TEST_CASE("A parse error leaves only the decoded events in the batch")
+{
+    io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer) - 4);
+    midi::TrackDecoder decoder(cursor, midi::ChunkMode::lenient);
+    midi::EventBatch batch;
+
+    CATCH_CHECK_THROWS_AS(decoder.decode(batch, 100), io::ParseError);
+    CATCH_CHECK(batch.size() == 7);
+    CATCH_CHECK(batch.payload_size.size() == 7);
+    CATCH_CHECK(batch.dt.back() == 10);
+}
+
+TEST_CASE("Copies of a bounded TrackDecoder decode independently")
+{
+    io::Cursor cursor = cursor_over_buffer();
+    midi::TrackDecoder original(cursor, midi::ChunkMode::bounded);
+    midi::EventBatch first;
+    original.decode(first, 3);
+
+    midi::TrackDecoder copy = original;
+    midi::EventBatch rest, copied;
+    original.decode(rest, 100);
+    copy.decode(copied, 100);
+
+    CATCH_CHECK(rest.size() == 5);
+    CATCH_CHECK(copied.dt == rest.dt);
+    CATCH_CHECK(copied.kind == rest.kind);
+}
+
+#endif
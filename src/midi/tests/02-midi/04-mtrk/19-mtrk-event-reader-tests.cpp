@@ -0,0 +1,159 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "tests/tests-util.h"
+#include "midi/event-reader.h"
+#include "io/parse-error.h"
+#include <string>
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 25, // Length
+        0, NOTE_ON(0, 60, 100),
+        10, NOTE_ON_RS(64, 100),
+        10, NOTE_OFF(0, 60, 0),
+        char(0x81), 0x00, NOTE_OFF_RS(64, 0),
+        5, char(0xFF), 0x01, 0x02, 'h', 'i',
+        END_OF_TRACK
+    };
+
+    io::Cursor cursor_over_buffer()
+    {
+        return io::Cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+    }
+}
+
+
+TEST_CASE("Pulling all events of an MTrk")
+{
+    for (midi::ChunkMode mode : { midi::ChunkMode::lenient, midi::ChunkMode::bounded })
+    {
+        io::Cursor cursor = cursor_over_buffer();
+        midi::EventReader reader(cursor, mode);
+        std::vector<uint64_t> times;
+        std::vector<midi::EventKind> kinds;
+
+        for (const midi::TRACK_EVENT& event : reader)
+        {
+            times.push_back(value(event.time));
+            kinds.push_back(event.kind);
+        }
+
+        CATCH_CHECK(times == std::vector<uint64_t>({ 0, 10, 20, 148, 153, 153 }));
+        CATCH_CHECK(kinds == std::vector<midi::EventKind>({
+            midi::EventKind::note_on, midi::EventKind::note_on, midi::EventKind::note_off,
+            midi::EventKind::note_off, midi::EventKind::meta, midi::EventKind::meta }));
+        CATCH_CHECK(reader.finished());
+        CATCH_CHECK(reader.count() == 6);
+        CATCH_CHECK(reader.time() == midi::Time(153));
+        CATCH_CHECK(cursor.at_end());
+    }
+}
+
+TEST_CASE("Pulling events of an MTrk one at a time")
+{
+    io::Cursor cursor = cursor_over_buffer();
+    midi::EventReader reader(cursor);
+    midi::TRACK_EVENT event;
+
+    CATCH_REQUIRE(reader.next(event));
+    CATCH_CHECK(event.dt == midi::Duration(0));
+    CATCH_CHECK(event.channel == 0);
+    CATCH_CHECK(event.data1 == 60);
+    CATCH_CHECK(event.data2 == 100);
+
+    CATCH_REQUIRE(reader.next(event));
+    CATCH_CHECK(event.dt == midi::Duration(10));
+    CATCH_CHECK(event.data1 == 64);
+
+    // Only what has been asked for is decoded
+    CATCH_CHECK(cursor.offset() == 8 + 4 + 3);
+    CATCH_CHECK(!reader.finished());
+
+    CATCH_REQUIRE(reader.next(event));
+    CATCH_REQUIRE(reader.next(event));
+    CATCH_CHECK(event.dt == midi::Duration(128));
+    CATCH_REQUIRE(reader.next(event));
+    CATCH_CHECK(event.data1 == 0x01);
+    CATCH_CHECK(std::string(event.payload.begin(), event.payload.end()) == "hi");
+    CATCH_REQUIRE(reader.next(event));
+    CATCH_CHECK(event.data1 == 0x2F);
+    CATCH_CHECK(!reader.next(event));
+    CATCH_CHECK(!reader.next(event));
+}
+
+TEST_CASE("Copies of a bounded EventReader read independently")
+{
+    io::Cursor cursor = cursor_over_buffer();
+    midi::EventReader original(cursor, midi::ChunkMode::bounded);
+    midi::TRACK_EVENT event;
+    original.next(event);
+    original.next(event);
+
+    midi::EventReader copy = original;
+    std::vector<uint64_t> original_times, copied_times;
+    while (original.next(event))
+    {
+        original_times.push_back(value(event.time));
+    }
+    while (copy.next(event))
+    {
+        copied_times.push_back(value(event.time));
+    }
+
+    CATCH_CHECK(original_times == std::vector<uint64_t>({ 20, 148, 153, 153 }));
+    CATCH_CHECK(copied_times == original_times);
+}
+
+TEST_CASE("Reading an MTrk up to a time")
+{
+    io::Cursor cursor = cursor_over_buffer();
+
+    auto receiver = Builder()
+        .note_on(midi::Duration(0), midi::Channel(0), midi::NoteNumber(60), 100)
+        .note_on(midi::Duration(10), midi::Channel(0), midi::NoteNumber(64), 100)
+        .note_off(midi::Duration(10), midi::Channel(0), midi::NoteNumber(60), 0)
+        .build();
+
+    CATCH_CHECK(midi::read_mtrk_until<midi::EventReceiver>(cursor, *receiver, midi::Time(147)) == 3);
+    receiver->check_finished();
+    CATCH_CHECK(!cursor.at_end());
+}
+
+TEST_CASE("Reading an MTrk up to a number of events")
+{
+    for (midi::ChunkMode mode : { midi::ChunkMode::lenient, midi::ChunkMode::bounded })
+    {
+        io::Cursor cursor = cursor_over_buffer();
+
+        auto receiver = Builder()
+            .note_on(midi::Duration(0), midi::Channel(0), midi::NoteNumber(60), 100)
+            .note_on(midi::Duration(10), midi::Channel(0), midi::NoteNumber(64), 100)
+            .build();
+
+        CATCH_CHECK(midi::read_mtrk_until<midi::EventReceiver>(cursor, *receiver, midi::Time(1000), 2, mode) == 2);
+        receiver->check_finished();
+    }
+}
+
+TEST_CASE("Pulling events of a truncated MTrk")
+{
+    io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer) - 4);
+    midi::EventReader reader(cursor);
+    midi::TRACK_EVENT event;
+
+    for (int i = 0; i != 5; ++i)
+    {
+        CATCH_REQUIRE(reader.next(event));
+    }
+    CATCH_CHECK_THROWS_AS(reader.next(event), io::ParseError);
+}
+
+#endif
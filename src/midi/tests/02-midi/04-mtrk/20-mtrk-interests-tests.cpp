@@ -0,0 +1,139 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "tests/tests-util.h"
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 35, // Length
+        0, NOTE_ON(0, 60, 100),
+        10, CONTROL_CHANGE(0, 7, 100),
+        5, CONTROL_CHANGE_RS(10, 64),
+        7, char(0xFF), 0x01, 0x03, 'a', 'b', 'c',
+        3, NOTE_OFF(0, 60, 0),
+        0, char(0xF0), 0x02, 0x11, 0x22,
+        20, PITCH_WHEEL_CHANGE(0, 500),
+        END_OF_TRACK
+    };
+
+    // Forwards to a test receiver, declaring interest in some events only
+    struct Interested : midi::EventReceiver
+    {
+        midi::EventReceiver& target;
+        midi::EventMask mask;
+
+        Interested(midi::EventReceiver& target, midi::EventMask mask) : target(target), mask(mask) { }
+
+        void note_on(midi::Duration dt, midi::Channel channel, midi::NoteNumber note, uint8_t velocity) override { target.note_on(dt, channel, note, velocity); }
+        void note_off(midi::Duration dt, midi::Channel channel, midi::NoteNumber note, uint8_t velocity) override { target.note_off(dt, channel, note, velocity); }
+        void polyphonic_key_pressure(midi::Duration dt, midi::Channel channel, midi::NoteNumber note, uint8_t pressure) override { target.polyphonic_key_pressure(dt, channel, note, pressure); }
+        void control_change(midi::Duration dt, midi::Channel channel, uint8_t controller, uint8_t amount) override { target.control_change(dt, channel, controller, amount); }
+        void program_change(midi::Duration dt, midi::Channel channel, midi::Instrument program) override { target.program_change(dt, channel, program); }
+        void channel_pressure(midi::Duration dt, midi::Channel channel, uint8_t pressure) override { target.channel_pressure(dt, channel, pressure); }
+        void pitch_wheel_change(midi::Duration dt, midi::Channel channel, uint16_t wheel) override { target.pitch_wheel_change(dt, channel, wheel); }
+        void meta(midi::Duration dt, uint8_t type, std::unique_ptr<uint8_t[]> data, uint64_t data_size) override { target.meta(dt, type, std::move(data), data_size); }
+        void sysex(midi::Duration dt, std::unique_ptr<uint8_t[]> data, uint64_t data_size) override { target.sysex(dt, std::move(data), data_size); }
+        midi::EventMask interests() const override { return mask; }
+    };
+
+    // Reads the track from a stream and from a buffer in both chunk modes
+    void check_reading(midi::EventMask mask, std::function<std::unique_ptr<TestEventReceiver>()> expected)
+    {
+        {
+            auto receiver = expected();
+            Interested interested(*receiver, mask);
+            std::stringstream ss(std::string(buffer, sizeof(buffer)));
+            midi::read_mtrk(ss, interested);
+            receiver->check_finished();
+        }
+
+        for (midi::ChunkMode mode : { midi::ChunkMode::lenient, midi::ChunkMode::bounded })
+        {
+            auto receiver = expected();
+            Interested interested(*receiver, mask);
+            io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+            midi::read_mtrk(cursor, interested, mode);
+            receiver->check_finished();
+            CATCH_CHECK(cursor.at_end());
+        }
+    }
+}
+
+
+TEST_CASE("Reading MTrk, interested in note events only")
+{
+    check_reading(midi::NOTE_EVENTS, []() {
+        return Builder()
+            .note_on(midi::Duration(0), midi::Channel(0), midi::NoteNumber(60), 100)
+            .note_off(midi::Duration(25), midi::Channel(0), midi::NoteNumber(60), 0)
+            .build();
+    });
+}
+
+TEST_CASE("Reading MTrk, interested in note and meta events")
+{
+    check_reading(midi::NOTE_EVENTS | midi::event_mask(midi::EventKind::meta), []() {
+        return Builder()
+            .note_on(midi::Duration(0), midi::Channel(0), midi::NoteNumber(60), 100)
+            .meta(midi::Duration(22), 0x01, "abc")
+            .note_off(midi::Duration(3), midi::Channel(0), midi::NoteNumber(60), 0)
+            .meta(midi::Duration(20), 0x2F, "")
+            .build();
+    });
+}
+
+TEST_CASE("Reading MTrk, interested in events under running status")
+{
+    check_reading(midi::event_mask(midi::EventKind::control_change) | midi::event_mask(midi::EventKind::sysex), []() {
+        return Builder()
+            .control_change(midi::Duration(10), midi::Channel(0), 7, 100)
+            .control_change(midi::Duration(5), midi::Channel(0), 10, 64)
+            .sysex(midi::Duration(10), "\x11\x22")
+            .build();
+    });
+}
+
+TEST_CASE("Reading MTrk, interested in nothing")
+{
+    check_reading(0, []() { return Builder().build(); });
+}
+
+TEST_CASE("Reading MTrk, skipped events keep their time for the note collector")
+{
+    std::vector<midi::NOTE> notes;
+    midi::NoteCollector collector([&notes](const midi::NOTE& note) { notes.push_back(note); });
+    io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+
+    CATCH_CHECK(collector.interests() == (midi::NOTE_EVENTS | midi::event_mask(midi::EventKind::program_change)));
+
+    midi::read_mtrk(cursor, collector);
+
+    CATCH_REQUIRE(notes.size() == 1);
+    CATCH_CHECK(notes[0].start == midi::Time(0));
+    CATCH_CHECK(notes[0].duration == midi::Duration(25));
+}
+
+TEST_CASE("Reading MTrk, skipping a truncated payload")
+{
+    char truncated[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 8, // Length
+        0, char(0xFF), 0x01, 0x10, 'a', 'b', 'c', 'd'
+    };
+    io::Cursor cursor(reinterpret_cast<const uint8_t*>(truncated), sizeof(truncated));
+    auto receiver = Builder().build();
+    Interested interested(*receiver, midi::NOTE_EVENTS);
+
+    CATCH_CHECK_THROWS_AS(midi::read_mtrk(cursor, interested, midi::ChunkMode::bounded), io::ParseError);
+}
+
+#endif
@@ -3,6 +3,7 @@
 #define TEST_CASE CATCH_TEST_CASE
 
 #include "tests/tests-util.h"
+#include "midi/combinators.h"
 #include <vector>
 #include <functional>
 
@@ -160,6 +161,24 @@ TEST_CASE("Multicaster test, one receiver, one event (meta)")
     }
 }
 
+TEST_CASE("Multicaster test, three receivers, one event (sysex)")
+{
+    std::string data = "pqrs";
+    auto create_receiver = [&data]() {
+        return std::shared_ptr<TestEventReceiver>(Builder().sysex(midi::Duration(7), data).build().release());
+    };
+
+    std::vector<std::shared_ptr<TestEventReceiver>> receivers{ create_receiver(), create_receiver(), create_receiver() };
+    midi::EventMulticaster multicaster(std::vector<std::shared_ptr<midi::EventReceiver>>(receivers.begin(), receivers.end()));
+
+    multicaster.sysex(midi::Duration(7), copy_string_to_char_array(data), data.size());
+
+    for (auto receiver : receivers)
+    {
+        receiver->check_finished();
+    }
+}
+
 TEST_CASE("Multicaster test, one receiver, two events")
 {
     auto create_receiver = []() {
@@ -217,4 +236,130 @@ TEST_CASE("Multicaster test, five receivers, one event")
     }
 }
 
+namespace
+{
+    char combinator_track[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 30, // Length
+        0, NOTE_ON(0, 60, 100),
+        10, NOTE_ON(1, 64, 90),
+        5, CONTROL_CHANGE(1, 7, 100),
+        3, char(0xFF), 0x01, 0x02, 'h', 'i',
+        2, NOTE_OFF(0, 60, 0),
+        20, NOTE_OFF(1, 64, 0),
+        END_OF_TRACK
+    };
+
+    io::Cursor cursor_over_combinator_track()
+    {
+        return io::Cursor(reinterpret_cast<const uint8_t*>(combinator_track), sizeof(combinator_track));
+    }
+}
+
+TEST_CASE("Combinator test, tee, two receivers, all events")
+{
+    auto create_receiver = []() {
+        return Builder()
+            .note_on(midi::Duration(0), midi::Channel(0), midi::NoteNumber(60), 100)
+            .note_on(midi::Duration(10), midi::Channel(1), midi::NoteNumber(64), 90)
+            .control_change(midi::Duration(5), midi::Channel(1), 7, 100)
+            .meta(midi::Duration(3), 0x01, "hi")
+            .note_off(midi::Duration(2), midi::Channel(0), midi::NoteNumber(60), 0)
+            .note_off(midi::Duration(20), midi::Channel(1), midi::NoteNumber(64), 0)
+            .meta(midi::Duration(0), 0x2F, "")
+            .build();
+    };
+
+    auto first = create_receiver();
+    auto second = create_receiver();
+    auto both = midi::tee(static_cast<midi::EventReceiver&>(*first), static_cast<midi::EventReceiver&>(*second));
+    io::Cursor cursor = cursor_over_combinator_track();
+
+    midi::read_mtrk(cursor, both);
+
+    first->check_finished();
+    second->check_finished();
+}
+
+TEST_CASE("Combinator test, filter_channel")
+{
+    auto receiver = Builder()
+        .note_on(midi::Duration(10), midi::Channel(1), midi::NoteNumber(64), 90)
+        .control_change(midi::Duration(5), midi::Channel(1), 7, 100)
+        .meta(midi::Duration(3), 0x01, "hi")
+        .note_off(midi::Duration(22), midi::Channel(1), midi::NoteNumber(64), 0)
+        .meta(midi::Duration(0), 0x2F, "")
+        .build();
+    auto filtered = midi::filter_channel(midi::Channel(1), static_cast<midi::EventReceiver&>(*receiver));
+    io::Cursor cursor = cursor_over_combinator_track();
+
+    midi::read_mtrk(cursor, filtered, midi::ChunkMode::bounded);
+
+    receiver->check_finished();
+}
+
+TEST_CASE("Combinator test, only_notes")
+{
+    auto receiver = Builder()
+        .note_on(midi::Duration(0), midi::Channel(0), midi::NoteNumber(60), 100)
+        .note_on(midi::Duration(10), midi::Channel(1), midi::NoteNumber(64), 90)
+        .note_off(midi::Duration(10), midi::Channel(0), midi::NoteNumber(60), 0)
+        .note_off(midi::Duration(20), midi::Channel(1), midi::NoteNumber(64), 0)
+        .build();
+    auto notes = midi::only_notes(static_cast<midi::EventReceiver&>(*receiver));
+    io::Cursor cursor = cursor_over_combinator_track();
+
+    CATCH_CHECK(notes.interests() == midi::NOTE_EVENTS);
+
+    midi::read_mtrk(cursor, notes);
+
+    receiver->check_finished();
+}
+
+TEST_CASE("Combinator test, map_time after filter_channel")
+{
+    auto receiver = Builder()
+        .note_on(midi::Duration(0), midi::Channel(0), midi::NoteNumber(60), 100)
+        .meta(midi::Duration(36), 0x01, "hi")
+        .note_off(midi::Duration(4), midi::Channel(0), midi::NoteNumber(60), 0)
+        .meta(midi::Duration(40), 0x2F, "")
+        .build();
+    auto doubled = midi::map_time(
+        [](midi::Duration dt) { return midi::Duration(2 * value(dt)); },
+        midi::filter_channel(midi::Channel(0), static_cast<midi::EventReceiver&>(*receiver)));
+    io::Cursor cursor = cursor_over_combinator_track();
+
+    midi::read_mtrk(cursor, doubled);
+
+    receiver->check_finished();
+}
+
+TEST_CASE("Combinator test, interests of a tee")
+{
+    auto receiver = Builder().build();
+    midi::EventReceiver& all = *receiver;
+
+    auto combined = midi::tee(midi::only_notes(all), midi::only_notes(all));
+    CATCH_CHECK(combined.interests() == midi::NOTE_EVENTS);
+
+    auto with_all = midi::tee(midi::only_notes(all), midi::filter_channel(midi::Channel(0), all));
+    CATCH_CHECK(with_all.interests() == midi::ALL_EVENTS);
+}
+
+TEST_CASE("Combinator test, collect_notes passes the same notes as NoteCollector")
+{
+    std::vector<midi::NOTE> expected, actual;
+    midi::NoteCollector collector([&expected](const midi::NOTE& note) { expected.push_back(note); });
+    auto combined = midi::collect_notes([&actual](const midi::NOTE& note) { actual.push_back(note); });
+
+    io::Cursor first = cursor_over_combinator_track();
+    midi::read_mtrk(first, collector);
+    io::Cursor second = cursor_over_combinator_track();
+    midi::read_mtrk(second, combined);
+
+    CATCH_CHECK(expected.size() == 2);
+    CATCH_CHECK(actual == expected);
+    CATCH_CHECK(combined.interests() == collector.interests());
+}
+
 #endif
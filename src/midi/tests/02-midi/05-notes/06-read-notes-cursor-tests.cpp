@@ -0,0 +1,64 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "midi/midi.h"
+#include "tests/tests-util.h"
+#include "Catch.h"
+#include <vector>
+
+using namespace testutils;
+
+
+TEST_CASE("read_mtrk from cursor stops right after End-of-Track")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 8, // Length
+        0, NOTE_ON(0, 5, 127),
+        END_OF_TRACK,
+        0x12
+    };
+    io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+
+    auto receiver = Builder()
+        .note_on(midi::Duration(0), midi::Channel(0), midi::NoteNumber(5), 127)
+        .meta(midi::Duration(0), 0x2F, "")
+        .build();
+
+    midi::read_mtrk(cursor, *receiver);
+    receiver->check_finished();
+
+    CATCH_CHECK(cursor.remaining() == 1);
+}
+
+TEST_CASE("read_notes from cursor, two tracks")
+{
+    char buffer[] = {
+        MTHD,
+        0x00, 0x00, 0x00, 0x06, // MThd size
+        0x00, 0x01, // Type
+        0x00, 0x02, // Number of tracks
+        0x01, 0x00, // Division
+        MTRK,
+        0x00, 0x00, 0x00, 15, // MTrk size
+        0, PROGRAM_CHANGE(0, 3),
+        0, NOTE_ON(0, 5, 127),
+        100, NOTE_OFF(0, 5, 0),
+        END_OF_TRACK,
+        MTRK,
+        0x00, 0x00, 0x00, 12, // MTrk size
+        50, NOTE_ON(1, 7, 64),
+        50, NOTE_ON(1, 7, 0),
+        END_OF_TRACK
+    };
+    io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+    std::vector<midi::NOTE> notes = midi::read_notes(cursor);
+
+    CATCH_REQUIRE(notes.size() == 2);
+    CATCH_CHECK(notes[0] == midi::NOTE(midi::NoteNumber(5), midi::Time(0), midi::Duration(100), 127, midi::Instrument(3)));
+    CATCH_CHECK(notes[1] == midi::NOTE(midi::NoteNumber(7), midi::Time(50), midi::Duration(50), 64, midi::Instrument(0)));
+    CATCH_CHECK(cursor.at_end());
+}
+
+#endif
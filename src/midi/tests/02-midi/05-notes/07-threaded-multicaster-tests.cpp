@@ -0,0 +1,206 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "tests/tests-util.h"
+#include "midi/threaded-multicaster.h"
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    // Describes the events it receives. Catch assertions are not thread safe,
+    // so the descriptions are checked after the workers have finished.
+    struct Recorder : midi::EventReceiver
+    {
+        std::vector<std::string> events;
+        // Can be watched while the worker is running, unlike events
+        std::atomic<size_t> handled{ 0 };
+
+        void record(const std::string& name, midi::Duration dt, int a, int b = 0)
+        {
+            std::ostringstream out;
+            out << name << " " << value(dt) << " " << a << " " << b;
+            events.push_back(out.str());
+            ++handled;
+        }
+
+        void note_on(midi::Duration dt, midi::Channel channel, midi::NoteNumber note, uint8_t velocity) override { record("note_on", dt, value(channel), value(note) * 1000 + velocity); }
+        void note_off(midi::Duration dt, midi::Channel channel, midi::NoteNumber note, uint8_t velocity) override { record("note_off", dt, value(channel), value(note) * 1000 + velocity); }
+        void polyphonic_key_pressure(midi::Duration dt, midi::Channel channel, midi::NoteNumber note, uint8_t pressure) override { record("polyphonic_key_pressure", dt, value(channel), value(note) * 1000 + pressure); }
+        void control_change(midi::Duration dt, midi::Channel channel, uint8_t controller, uint8_t amount) override { record("control_change", dt, value(channel), controller * 1000 + amount); }
+        void program_change(midi::Duration dt, midi::Channel channel, midi::Instrument program) override { record("program_change", dt, value(channel), value(program)); }
+        void channel_pressure(midi::Duration dt, midi::Channel channel, uint8_t pressure) override { record("channel_pressure", dt, value(channel), pressure); }
+        void pitch_wheel_change(midi::Duration dt, midi::Channel channel, uint16_t wheel) override { record("pitch_wheel_change", dt, value(channel), wheel); }
+        void meta(midi::Duration dt, uint8_t type, std::unique_ptr<uint8_t[]> data, uint64_t data_size) override { record("meta " + std::string(data.get(), data.get() + data_size), dt, type); }
+        void sysex(midi::Duration dt, std::unique_ptr<uint8_t[]> data, uint64_t data_size) override { record("sysex " + std::string(data.get(), data.get() + data_size), dt, 0); }
+    };
+
+    // Blocks on its first event until released
+    struct Blocker : Recorder
+    {
+        std::atomic<bool> released{ false };
+
+        void note_on(midi::Duration dt, midi::Channel channel, midi::NoteNumber note, uint8_t velocity) override
+        {
+            while (!released)
+            {
+                std::this_thread::yield();
+            }
+            Recorder::note_on(dt, channel, note, velocity);
+        }
+    };
+
+    struct Thrower : Recorder
+    {
+        void note_off(midi::Duration, midi::Channel, midi::NoteNumber, uint8_t) override
+        {
+            throw std::runtime_error("receiver failed");
+        }
+    };
+
+    std::unique_ptr<uint8_t[]> to_array(const std::string& string)
+    {
+        auto result = std::make_unique<uint8_t[]>(string.size());
+        std::copy(string.begin(), string.end(), result.get());
+        return result;
+    }
+
+    std::vector<std::string> send_all_kinds(midi::EventReceiver& receiver)
+    {
+        std::string text = "text";
+        receiver.note_on(midi::Duration(1), midi::Channel(2), midi::NoteNumber(3), 4);
+        receiver.note_off(midi::Duration(5), midi::Channel(6), midi::NoteNumber(7), 8);
+        receiver.polyphonic_key_pressure(midi::Duration(9), midi::Channel(10), midi::NoteNumber(11), 12);
+        receiver.control_change(midi::Duration(13), midi::Channel(14), 15, 16);
+        receiver.program_change(midi::Duration(17), midi::Channel(1), midi::Instrument(18));
+        receiver.channel_pressure(midi::Duration(19), midi::Channel(2), 20);
+        receiver.pitch_wheel_change(midi::Duration(21), midi::Channel(3), 1000);
+        receiver.meta(midi::Duration(22), 0x01, io::ByteView(reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+        receiver.meta(midi::Duration(23), 0x02, to_array("owned"), 5);
+        receiver.sysex(midi::Duration(24), io::ByteView(reinterpret_cast<const uint8_t*>(text.data()), text.size()));
+        receiver.sysex(midi::Duration(25), to_array("xy"), 2);
+
+        return {
+            "note_on 1 2 3004",
+            "note_off 5 6 7008",
+            "polyphonic_key_pressure 9 10 11012",
+            "control_change 13 14 15016",
+            "program_change 17 1 18",
+            "channel_pressure 19 2 20",
+            "pitch_wheel_change 21 3 1000",
+            "meta text 22 1 0",
+            "meta owned 23 2 0",
+            "sysex text 24 0 0",
+            "sysex xy 25 0 0",
+        };
+    }
+}
+
+
+TEST_CASE("Threaded multicaster, three receivers, all kinds of events")
+{
+    std::vector<std::shared_ptr<Recorder>> recorders{ std::make_shared<Recorder>(), std::make_shared<Recorder>(), std::make_shared<Recorder>() };
+    midi::ThreadedMulticaster multicaster(std::vector<std::shared_ptr<midi::EventReceiver>>(recorders.begin(), recorders.end()));
+
+    std::vector<std::string> expected = send_all_kinds(multicaster);
+    multicaster.finish();
+
+    for (auto recorder : recorders)
+    {
+        CATCH_CHECK(recorder->events == expected);
+    }
+}
+
+TEST_CASE("Threaded multicaster, more events than fit in the queues")
+{
+    auto recorder = std::make_shared<Recorder>();
+    midi::ThreadedMulticaster multicaster({ recorder }, 4);
+
+    for (int i = 0; i != 1000; ++i)
+    {
+        multicaster.program_change(midi::Duration(i), midi::Channel(0), midi::Instrument(uint8_t(i % 128)));
+    }
+    multicaster.finish();
+
+    CATCH_REQUIRE(recorder->events.size() == 1000);
+    CATCH_CHECK(recorder->events[999] == "program_change 999 0 103");
+}
+
+TEST_CASE("Threaded multicaster, a blocked receiver does not hold up the others")
+{
+    auto blocker = std::make_shared<Blocker>();
+    auto recorder = std::make_shared<Recorder>();
+    midi::ThreadedMulticaster multicaster({ blocker, recorder }, 64);
+
+    for (int i = 0; i != 50; ++i)
+    {
+        multicaster.note_on(midi::Duration(1), midi::Channel(0), midi::NoteNumber(60), 100);
+    }
+
+    // The recorder works through its queue while the blocker has not handled a single event
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (recorder->handled != 50 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CATCH_CHECK(recorder->handled == 50);
+    CATCH_CHECK(blocker->handled == 0);
+
+    blocker->released = true;
+    multicaster.finish();
+    CATCH_CHECK(blocker->events.size() == 50);
+}
+
+TEST_CASE("Threaded multicaster, receiver exceptions are rethrown by finish")
+{
+    auto thrower = std::make_shared<Thrower>();
+    auto recorder = std::make_shared<Recorder>();
+    midi::ThreadedMulticaster multicaster({ thrower, recorder });
+
+    send_all_kinds(multicaster);
+
+    CATCH_CHECK_THROWS_AS(multicaster.finish(), std::runtime_error);
+    CATCH_CHECK(thrower->events.size() == 1);
+    CATCH_CHECK(recorder->events.size() == 11);
+}
+
+TEST_CASE("Threaded multicaster, collecting notes while reading an MTrk")
+{
+    char buffer[] = {
+        MTRK,
+        0x00, 0x00, 0x00, 27, // Length
+        0, NOTE_ON(0, 60, 100),
+        10, NOTE_ON(1, 64, 90),
+        5, char(0xFF), 0x01, 0x02, 'h', 'i',
+        3, NOTE_OFF(0, 60, 0),
+        char(0x81), 0x00, NOTE_ON(1, 64, 0),
+        END_OF_TRACK
+    };
+
+    std::vector<midi::NOTE> first, second;
+    auto first_collector = std::make_shared<midi::NoteCollector>([&first](const midi::NOTE& note) { first.push_back(note); });
+    auto second_collector = std::make_shared<midi::NoteCollector>([&second](const midi::NOTE& note) { second.push_back(note); });
+    midi::ThreadedMulticaster multicaster({ first_collector, second_collector });
+
+    io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+    midi::read_mtrk(cursor, multicaster, midi::ChunkMode::bounded);
+    multicaster.finish();
+
+    std::vector<midi::NOTE> expected{
+        midi::NOTE(midi::NoteNumber(60), midi::Time(0), midi::Duration(18), 100, midi::Instrument(0)),
+        midi::NOTE(midi::NoteNumber(64), midi::Time(10), midi::Duration(136), 90, midi::Instrument(0)),
+    };
+    CATCH_CHECK(first == expected);
+    CATCH_CHECK(second == expected);
+}
+
+#endif
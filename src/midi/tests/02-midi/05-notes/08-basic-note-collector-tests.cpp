@@ -0,0 +1,104 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "midi/midi.h"
+#include "midi/note-collector.h"
+#include "Catch.h"
+#include <vector>
+
+
+namespace
+{
+    struct Appender
+    {
+        std::vector<midi::NOTE>* notes;
+
+        void operator ()(const midi::NOTE& note) const { notes->push_back(note); }
+    };
+}
+
+
+TEST_CASE("BasicNoteCollector with single note (channel 2, number 5, from 0, duration 100)")
+{
+    std::vector<midi::NOTE> notes;
+    midi::BasicNoteCollector<Appender> collector(Appender{ &notes });
+
+    collector.note_on(midi::Duration(0), midi::Channel(2), midi::NoteNumber(5), 32);
+    collector.note_off(midi::Duration(100), midi::Channel(2), midi::NoteNumber(5), 0);
+
+    CATCH_REQUIRE(notes.size() == 1);
+    CATCH_CHECK(notes[0] == midi::NOTE(midi::NoteNumber(5), midi::Time(0), midi::Duration(100), 32, midi::Instrument(0)));
+}
+
+TEST_CASE("BasicNoteCollector keeps the same note apart on different channels")
+{
+    std::vector<midi::NOTE> notes;
+    midi::BasicNoteCollector<Appender> collector(Appender{ &notes });
+
+    collector.program_change(midi::Duration(0), midi::Channel(1), midi::Instrument(40));
+    collector.note_on(midi::Duration(10), midi::Channel(0), midi::NoteNumber(60), 100);
+    collector.note_on(midi::Duration(10), midi::Channel(1), midi::NoteNumber(60), 90);
+    collector.note_off(midi::Duration(10), midi::Channel(0), midi::NoteNumber(60), 0);
+    collector.control_change(midi::Duration(5), midi::Channel(3), 7, 100);
+    collector.note_on(midi::Duration(5), midi::Channel(1), midi::NoteNumber(60), 0);
+
+    CATCH_REQUIRE(notes.size() == 2);
+    CATCH_CHECK(notes[0] == midi::NOTE(midi::NoteNumber(60), midi::Time(10), midi::Duration(20), 100, midi::Instrument(0)));
+    CATCH_CHECK(notes[1] == midi::NOTE(midi::NoteNumber(60), midi::Time(20), midi::Duration(20), 90, midi::Instrument(40)));
+}
+
+TEST_CASE("BasicNoteCollector ends a note that is struck again")
+{
+    std::vector<midi::NOTE> notes;
+    midi::BasicNoteCollector<Appender> collector(Appender{ &notes });
+
+    collector.note_on(midi::Duration(0), midi::Channel(0), midi::NoteNumber(5), 10);
+    collector.note_on(midi::Duration(50), midi::Channel(0), midi::NoteNumber(5), 20);
+    collector.note_off(midi::Duration(50), midi::Channel(0), midi::NoteNumber(5), 0);
+
+    CATCH_REQUIRE(notes.size() == 2);
+    CATCH_CHECK(notes[0] == midi::NOTE(midi::NoteNumber(5), midi::Time(0), midi::Duration(50), 10, midi::Instrument(0)));
+    CATCH_CHECK(notes[1] == midi::NOTE(midi::NoteNumber(5), midi::Time(50), midi::Duration(50), 20, midi::Instrument(0)));
+}
+
+TEST_CASE("BasicNoteCollector passes the same notes as NoteCollector")
+{
+    std::vector<midi::NOTE> expected, actual;
+    midi::NoteCollector reference([&expected](const midi::NOTE& note) { expected.push_back(note); });
+    midi::BasicNoteCollector<Appender> collector(Appender{ &actual });
+
+    // Few channels and notes, so that notes overlap, are struck again and end without having started
+    uint32_t state = 12345;
+    auto next = [&state](uint32_t n) { state = state * 1103515245 + 12345; return (state >> 16) % n; };
+    for (int i = 0; i != 10000; ++i)
+    {
+        midi::Duration dt(next(20));
+        midi::Channel channel(uint8_t(next(3)));
+        midi::NoteNumber note(uint8_t(60 + next(4)));
+        uint8_t velocity = uint8_t(next(4) == 0 ? 0 : next(128));
+
+        switch (next(4))
+        {
+        case 0:
+        case 1:
+            reference.note_on(dt, channel, note, velocity);
+            collector.note_on(dt, channel, note, velocity);
+            break;
+        case 2:
+            reference.note_off(dt, channel, note, velocity);
+            collector.note_off(dt, channel, note, velocity);
+            break;
+        default:
+            reference.program_change(dt, channel, midi::Instrument(velocity));
+            collector.program_change(dt, channel, midi::Instrument(velocity));
+            break;
+        }
+    }
+
+    CATCH_CHECK(expected.size() > 1000);
+    CATCH_CHECK(actual == expected);
+    CATCH_CHECK(collector.interests() == reference.interests());
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "midi/midi.h"
+#include "tests/tests-util.h"
+#include "Catch.h"
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    char two_tracks[] = {
+        MTHD,
+        0x00, 0x00, 0x00, 0x06, // MThd size
+        0x00, 0x01, // Type
+        0x00, 0x02, // Number of tracks
+        0x01, 0x00, // Division
+        MTRK,
+        0x00, 0x00, 0x00, 15, // MTrk size
+        0, PROGRAM_CHANGE(0, 3),
+        0, NOTE_ON(0, 5, 127),
+        100, NOTE_OFF(0, 5, 0),
+        END_OF_TRACK,
+        MTRK,
+        0x00, 0x00, 0x00, 12, // MTrk size
+        50, NOTE_ON(1, 7, 64),
+        50, NOTE_ON(1, 7, 0),
+        END_OF_TRACK
+    };
+
+    io::Cursor cursor_over(const char* buffer, size_t size)
+    {
+        return io::Cursor(reinterpret_cast<const uint8_t*>(buffer), size);
+    }
+}
+
+
+TEST_CASE("read_notes appends to the given notes, with room reserved")
+{
+    std::vector<midi::NOTE> notes;
+    notes.push_back(midi::NOTE(midi::NoteNumber(1), midi::Time(0), midi::Duration(1), 1, midi::Instrument(0)));
+
+    for (midi::ChunkMode mode : { midi::ChunkMode::lenient, midi::ChunkMode::bounded })
+    {
+        notes.resize(1, notes[0]);
+        io::Cursor cursor = cursor_over(two_tracks, sizeof(two_tracks));
+        midi::read_notes(cursor, notes, mode);
+
+        CATCH_CHECK(cursor.at_end());
+        CATCH_REQUIRE(notes.size() == 3);
+        CATCH_CHECK(notes[1] == midi::NOTE(midi::NoteNumber(5), midi::Time(0), midi::Duration(100), 127, midi::Instrument(3)));
+        CATCH_CHECK(notes[2] == midi::NOTE(midi::NoteNumber(7), midi::Time(50), midi::Duration(50), 64, midi::Instrument(0)));
+        CATCH_CHECK(notes.capacity() >= 1 + midi::estimate_note_count(27));
+    }
+}
+
+TEST_CASE("estimate_note_count is capped")
+{
+    CATCH_CHECK(midi::estimate_note_count(27) == 4);
+    CATCH_CHECK(midi::estimate_note_count(6 * midi::MAX_RESERVED_NOTES) == midi::MAX_RESERVED_NOTES);
+    CATCH_CHECK(midi::estimate_note_count(uint64_t(1) << 40) == midi::MAX_RESERVED_NOTES);
+}
+
+#endif
@@ -0,0 +1,123 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "midi/midi.h"
+#include "midi/combinators.h"
+#include "midi/note-table.h"
+#include "midi/tempo-map.h"
+#include "tests/tests-util.h"
+#include "Catch.h"
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    midi::NOTE make_note(int number, uint64_t start, uint64_t duration)
+    {
+        return midi::NOTE(midi::NoteNumber(number), midi::Time(start), midi::Duration(duration), 100, midi::Instrument(0));
+    }
+
+    midi::NoteTable make_table(const std::vector<midi::NOTE>& notes)
+    {
+        midi::NoteTable table;
+        for (size_t i = 0; i != notes.size(); ++i)
+        {
+            table.push_back(notes[i], midi::Channel(uint8_t(i)));
+        }
+        return table;
+    }
+}
+
+
+TEST_CASE("NoteTable filled by the note collector")
+{
+    midi::NoteTable table;
+    auto collector = midi::collect_notes(table.appender());
+
+    collector.program_change(midi::Duration(0), midi::Channel(3), midi::Instrument(12));
+    collector.note_on(midi::Duration(10), midi::Channel(3), midi::NoteNumber(60), 90);
+    collector.note_on(midi::Duration(5), midi::Channel(0), midi::NoteNumber(40), 80);
+    collector.note_off(midi::Duration(5), midi::Channel(3), midi::NoteNumber(60), 0);
+    collector.note_off(midi::Duration(5), midi::Channel(0), midi::NoteNumber(40), 0);
+
+    CATCH_REQUIRE(table.size() == 2);
+    CATCH_CHECK(table.note(0) == midi::NOTE(midi::NoteNumber(60), midi::Time(10), midi::Duration(10), 90, midi::Instrument(12)));
+    CATCH_CHECK(table.channel[0] == 3);
+    CATCH_CHECK(table.note(1) == midi::NOTE(midi::NoteNumber(40), midi::Time(15), midi::Duration(10), 80, midi::Instrument(0)));
+    CATCH_CHECK(table.channel[1] == 0);
+}
+
+TEST_CASE("NoteTable sorted by start keeps simultaneous notes in order")
+{
+    midi::NoteTable table = make_table({ make_note(5, 30, 1), make_note(6, 10, 1), make_note(7, 30, 1), make_note(8, 0, 1) });
+    table.sort_by_start();
+
+    CATCH_CHECK(table.start == std::vector<uint64_t>({ 0, 10, 30, 30 }));
+    CATCH_CHECK(table.note_number == std::vector<uint8_t>({ 8, 6, 5, 7 }));
+    CATCH_CHECK(table.channel == std::vector<uint8_t>({ 3, 1, 0, 2 }));
+}
+
+TEST_CASE("NoteTable sorted by pitch, then start")
+{
+    midi::NoteTable table = make_table({ make_note(7, 30, 1), make_note(5, 20, 2), make_note(7, 10, 3), make_note(5, 0, 4) });
+    table.sort_by_pitch();
+
+    CATCH_CHECK(table.note_number == std::vector<uint8_t>({ 5, 5, 7, 7 }));
+    CATCH_CHECK(table.start == std::vector<uint64_t>({ 0, 20, 10, 30 }));
+    CATCH_CHECK(table.duration == std::vector<uint64_t>({ 4, 2, 3, 1 }));
+}
+
+TEST_CASE("NoteTable column scans")
+{
+    midi::NoteTable table = make_table({ make_note(70, 0, 50), make_note(20, 30, 10), make_note(90, 10, 20) });
+
+    CATCH_CHECK(midi::end_time(table) == 50);
+    CATCH_CHECK(midi::lowest_note(table) == 20);
+    CATCH_CHECK(midi::highest_note(table) == 90);
+
+    midi::NoteTable empty;
+    CATCH_CHECK(midi::end_time(empty) == 0);
+    CATCH_CHECK(midi::lowest_note(empty) == 128);
+    CATCH_CHECK(midi::highest_note(empty) == 0);
+}
+
+TEST_CASE("read_notes into a NoteTable, with the tempo map")
+{
+    char buffer[] = {
+        MTHD,
+        0x00, 0x00, 0x00, 0x06, // MThd size
+        0x00, 0x01, // Type
+        0x00, 0x01, // Number of tracks
+        0x00, 0x60, // Division
+        MTRK,
+        0x00, 0x00, 0x00, 19, // MTrk size
+        0, char(0xFF), 0x51, 0x03, 0x0F, 0x42, 0x40, // Set Tempo 1000000
+        0, NOTE_ON(4, 60, 100),
+        96, NOTE_OFF(4, 60, 0),
+        END_OF_TRACK
+    };
+
+    for (midi::ChunkMode mode : { midi::ChunkMode::lenient, midi::ChunkMode::bounded })
+    {
+        io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+        midi::NoteTable table;
+        midi::TempoMap tempo_map;
+        midi::read_notes(cursor, table, tempo_map, mode);
+
+        CATCH_CHECK(cursor.at_end());
+        CATCH_REQUIRE(table.size() == 1);
+        CATCH_CHECK(table.note(0) == midi::NOTE(midi::NoteNumber(60), midi::Time(0), midi::Duration(96), 100, midi::Instrument(0)));
+        CATCH_CHECK(table.channel[0] == 4);
+
+        std::vector<double> starts, durations;
+        midi::note_times(tempo_map, table, starts, durations);
+        CATCH_REQUIRE(durations.size() == 1);
+        CATCH_CHECK(starts[0] == 0);
+        CATCH_CHECK(durations[0] == 1000000);
+    }
+}
+
+#endif
@@ -0,0 +1,98 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "midi/midi.h"
+#include "midi/note-index.h"
+#include "midi/note-table.h"
+#include "Catch.h"
+#include <algorithm>
+#include <vector>
+
+
+namespace
+{
+    midi::NOTE make_note(uint64_t start, uint64_t duration)
+    {
+        return midi::NOTE(midi::NoteNumber(60), midi::Time(start), midi::Duration(duration), 100, midi::Instrument(0));
+    }
+
+    std::vector<size_t> query(const midi::NoteIndex& index, uint64_t from, uint64_t to)
+    {
+        std::vector<size_t> rows;
+        index.overlapping(midi::Time(from), midi::Time(to), rows);
+        return rows;
+    }
+}
+
+
+TEST_CASE("NoteIndex over no notes")
+{
+    midi::NoteIndex index((std::vector<midi::NOTE>()));
+
+    CATCH_CHECK(index.size() == 0);
+    CATCH_CHECK(query(index, 0, 100).empty());
+}
+
+TEST_CASE("NoteIndex window and point queries")
+{
+    std::vector<midi::NOTE> notes = {
+        make_note(50, 10), // 0: [50, 60)
+        make_note(0, 100), // 1: [0, 100)
+        make_note(20, 5),  // 2: [20, 25)
+        make_note(60, 0),  // 3: empty
+        make_note(25, 30), // 4: [25, 55)
+    };
+    midi::NoteIndex index(notes);
+
+    CATCH_CHECK(index.size() == 5);
+    CATCH_CHECK(query(index, 0, 10) == std::vector<size_t>({ 1 }));
+    CATCH_CHECK(query(index, 24, 26) == std::vector<size_t>({ 1, 2, 4 }));
+    CATCH_CHECK(query(index, 55, 200) == std::vector<size_t>({ 1, 0, 3 }));
+    CATCH_CHECK(query(index, 61, 200) == std::vector<size_t>({ 1 }));
+    CATCH_CHECK(query(index, 100, 200).empty());
+
+    std::vector<size_t> rows;
+    index.at(midi::Time(25), rows);
+    CATCH_CHECK(rows == std::vector<size_t>({ 1, 4 }));
+}
+
+TEST_CASE("NoteIndex agrees with a linear scan")
+{
+    uint32_t state = 42;
+    auto next = [&state](uint32_t n) { state = state * 1103515245 + 12345; return (state >> 8) % n; };
+
+    for (size_t count : { 1, 2, 3, 7, 8, 9, 16, 17, 100, 1000, 1025 })
+    {
+        midi::NoteTable table;
+        for (size_t i = 0; i != count; ++i)
+        {
+            uint64_t duration = next(10) == 0 ? next(5000) : next(50);
+            table.push_back(make_note(next(10000), duration), midi::Channel(0));
+        }
+        midi::NoteIndex index(table);
+
+        for (int q = 0; q != 200; ++q)
+        {
+            uint64_t from = next(11000);
+            uint64_t to = from + next(q % 2 == 0 ? 20 : 2000);
+
+            std::vector<size_t> expected;
+            for (size_t i = 0; i != count; ++i)
+            {
+                if (table.start[i] < to && table.start[i] + table.duration[i] > from)
+                {
+                    expected.push_back(i);
+                }
+            }
+            std::vector<size_t> actual = query(index, from, to);
+
+            // Rows come in order of start
+            CATCH_CHECK(std::is_sorted(actual.begin(), actual.end(), [&table](size_t a, size_t b) { return table.start[a] < table.start[b]; }));
+            std::sort(actual.begin(), actual.end());
+            CATCH_CHECK(actual == expected);
+        }
+    }
+}
+
+#endif
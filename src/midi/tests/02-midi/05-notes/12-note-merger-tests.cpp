@@ -0,0 +1,241 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "midi/note-merger.h"
+#include "tests/tests-util.h"
+#include "io/parse-error.h"
+#include <algorithm>
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    // Random notes on random channels, with program changes, retriggered notes and note offs as note ons of velocity 0.
+    // With a non-null stale_offs, also note offs on keys that are not sounding, which are counted.
+    std::vector<uint8_t> create_track(uint32_t& state, size_t nevents, size_t* stale_offs = nullptr)
+    {
+        auto next = [&state](uint32_t n) { state = state * 1103515245 + 12345; return (state >> 8) % n; };
+
+        std::vector<uint8_t> events;
+        std::vector<std::pair<uint8_t, uint8_t>> sounding;
+        for (size_t i = 0; i != nevents; ++i)
+        {
+            append_vli(events, next(4) == 0 ? 0 : next(next(8) == 0 ? 2000 : 40));
+            uint32_t choice = next(10);
+            if (choice == 0)
+            {
+                events.insert(events.end(), { uint8_t(0xC0 | next(16)), uint8_t(next(128)) });
+            }
+            else if (choice < 5 && !sounding.empty())
+            {
+                size_t k = next(uint32_t(sounding.size()));
+                uint8_t status = next(2) == 0 ? 0x80 : 0x90;
+                events.insert(events.end(), { uint8_t(status | sounding[k].first), sounding[k].second, 0 });
+                sounding.erase(sounding.begin() + k);
+            }
+            else if (choice == 5 && stale_offs != nullptr)
+            {
+                uint8_t channel = uint8_t(next(3)), note = uint8_t(60 + next(6));
+                if (std::find(sounding.begin(), sounding.end(), std::make_pair(channel, note)) == sounding.end())
+                {
+                    events.insert(events.end(), { uint8_t(0x80 | channel), note, 0 });
+                    ++*stale_offs;
+                }
+                else
+                {
+                    events.insert(events.end(), { uint8_t(0xB0 | channel), 7, 100 });
+                }
+            }
+            else
+            {
+                uint8_t channel = uint8_t(next(3)), note = uint8_t(60 + next(6));
+                events.insert(events.end(), { uint8_t(0x90 | channel), note, uint8_t(1 + next(127)) });
+                if (std::find(sounding.begin(), sounding.end(), std::make_pair(channel, note)) == sounding.end())
+                {
+                    sounding.push_back(std::make_pair(channel, note));
+                }
+            }
+        }
+        return events;
+    }
+
+    std::vector<midi::NOTE> read_sorted(const std::vector<uint8_t>& file)
+    {
+        io::Cursor cursor(file);
+        std::vector<midi::NOTE> notes = midi::read_notes(cursor, midi::ChunkMode::bounded);
+        std::stable_sort(notes.begin(), notes.end(), [](const midi::NOTE& a, const midi::NOTE& b) { return a.start < b.start; });
+        return notes;
+    }
+
+    std::vector<midi::NOTE> merge(const std::vector<uint8_t>& file)
+    {
+        std::vector<midi::NOTE> notes;
+        midi::merge_notes(io::Cursor(file), [&notes](const midi::NOTE& note) { notes.push_back(note); });
+        return notes;
+    }
+}
+
+
+TEST_CASE("TrackNoteCursor yields a track's notes in order of start")
+{
+    // 0: long note 60, 10-20: note 61, 30-40: note 62, 100: note 60 ends
+    std::vector<uint8_t> file = create_file({ {
+        0, uint8_t(0x90), 60, 100,
+        10, uint8_t(0x90), 61, 101,
+        10, uint8_t(0x80), 61, 0,
+        10, uint8_t(0x90), 62, 102,
+        10, uint8_t(0x80), 62, 0,
+        60, uint8_t(0x80), 60, 0,
+    } });
+    io::Cursor cursor(file);
+    midi::TrackNoteCursor track(cursor.at(14));
+
+    // Nothing is released before the long note ends
+    CATCH_REQUIRE(!track.at_end());
+    CATCH_CHECK(track.buffered() == 3);
+    CATCH_CHECK(track.note() == midi::NOTE(midi::NoteNumber(60), midi::Time(0), midi::Duration(100), 100, midi::Instrument(0)));
+    track.advance();
+    CATCH_REQUIRE(!track.at_end());
+    CATCH_CHECK(track.note() == midi::NOTE(midi::NoteNumber(61), midi::Time(10), midi::Duration(10), 101, midi::Instrument(0)));
+    track.advance();
+    CATCH_REQUIRE(!track.at_end());
+    CATCH_CHECK(track.note() == midi::NOTE(midi::NoteNumber(62), midi::Time(30), midi::Duration(10), 102, midi::Instrument(0)));
+    track.advance();
+    CATCH_CHECK(track.at_end());
+}
+
+TEST_CASE("TrackNoteCursor holds back only what it must")
+{
+    // Consecutive notes: each can be released as soon as it ends
+    std::vector<uint8_t> events;
+    for (int i = 0; i != 1000; ++i)
+    {
+        events.insert(events.end(), { 0, uint8_t(0x91), 60, 64, 10, uint8_t(0x81), 60, 0 });
+    }
+    std::vector<uint8_t> file = create_file({ events });
+    io::Cursor cursor(file);
+    midi::TrackNoteCursor track(cursor.at(14));
+
+    size_t count = 0, most = 0;
+    for (; !track.at_end(); track.advance())
+    {
+        most = std::max(most, track.buffered());
+        CATCH_CHECK(track.note().start == midi::Time(10 * count));
+        CATCH_CHECK(track.channel() == midi::Channel(1));
+        ++count;
+    }
+    CATCH_CHECK(count == 1000);
+    CATCH_CHECK(most == 1);
+}
+
+TEST_CASE("NoteMerger breaks ties in start by track")
+{
+    std::vector<uint8_t> file = create_file({
+        { 0, uint8_t(0x90), 60, 1, 20, uint8_t(0x80), 60, 0 },
+        { 0, uint8_t(0x91), 61, 2, 10, uint8_t(0x81), 61, 0, 0, uint8_t(0x91), 62, 3, 10, uint8_t(0x81), 62, 0 },
+        { },
+        { 10, uint8_t(0x92), 63, 4, 1, uint8_t(0x82), 63, 0 },
+    });
+    midi::NoteMerger merger((io::Cursor(file)));
+
+    std::vector<size_t> tracks;
+    std::vector<uint8_t> note_numbers, channels;
+    for (; !merger.at_end(); merger.advance())
+    {
+        tracks.push_back(merger.track());
+        note_numbers.push_back(value(merger.note().note_number));
+        channels.push_back(value(merger.channel()));
+    }
+    CATCH_CHECK(tracks == std::vector<size_t>({ 0, 1, 1, 3 }));
+    CATCH_CHECK(note_numbers == std::vector<uint8_t>({ 60, 61, 62, 63 }));
+    CATCH_CHECK(channels == std::vector<uint8_t>({ 0, 1, 1, 2 }));
+}
+
+TEST_CASE("NoteMerger yields the notes of read_notes stably sorted by start")
+{
+    uint32_t state = 7;
+    for (size_t ntracks : { 1, 2, 5, 16 })
+    {
+        std::vector<std::vector<uint8_t>> tracks;
+        for (size_t i = 0; i != ntracks; ++i)
+        {
+            tracks.push_back(create_track(state, 50 + 100 * i));
+        }
+        std::vector<uint8_t> file = create_file(tracks);
+
+        std::vector<midi::NOTE> expected = read_sorted(file);
+        CATCH_REQUIRE(!expected.empty());
+        CATCH_CHECK(merge(file) == expected);
+    }
+}
+
+TEST_CASE("NoteMerger drops note offs on keys that are not sounding")
+{
+    // 0-10: note 60, 20-30: note 62, 40: note 60 released again, 50: note 61 never played
+    std::vector<uint8_t> file = create_file({ {
+        0, uint8_t(0x90), 60, 100,
+        10, uint8_t(0x80), 60, 0,
+        10, uint8_t(0x90), 62, 101,
+        10, uint8_t(0x80), 62, 0,
+        10, uint8_t(0x80), 60, 0,
+        10, uint8_t(0x90), 61, 0,
+    } });
+
+    std::vector<midi::NOTE> notes = merge(file);
+    CATCH_REQUIRE(notes.size() == 2);
+    CATCH_CHECK(notes[0] == midi::NOTE(midi::NoteNumber(60), midi::Time(0), midi::Duration(10), 100, midi::Instrument(0)));
+    CATCH_CHECK(notes[1] == midi::NOTE(midi::NoteNumber(62), midi::Time(20), midi::Duration(10), 101, midi::Instrument(0)));
+}
+
+TEST_CASE("NoteMerger yields notes in order of start despite note offs on keys that are not sounding")
+{
+    uint32_t state = 11;
+    for (size_t ntracks : { 1, 3, 8 })
+    {
+        std::vector<std::vector<uint8_t>> tracks;
+        size_t stale_offs = 0;
+        for (size_t i = 0; i != ntracks; ++i)
+        {
+            tracks.push_back(create_track(state, 200 + 100 * i, &stale_offs));
+        }
+        std::vector<uint8_t> file = create_file(tracks);
+        CATCH_REQUIRE(stale_offs != 0);
+
+        std::vector<midi::NOTE> notes = merge(file);
+        CATCH_CHECK(notes.size() + stale_offs == read_sorted(file).size());
+        CATCH_CHECK(std::is_sorted(notes.begin(), notes.end(), [](const midi::NOTE& a, const midi::NOTE& b) { return a.start < b.start; }));
+    }
+}
+
+TEST_CASE("NoteMerger passes channels on to sinks that take them")
+{
+    std::vector<uint8_t> file = create_file({
+        { 5, uint8_t(0x99), 40, 90, 5, uint8_t(0x89), 40, 0 },
+        { 0, uint8_t(0x93), 50, 80, 20, uint8_t(0x83), 50, 0 },
+    });
+
+    std::vector<midi::Channel> channels;
+    midi::merge_notes(io::Cursor(file), [&channels](const midi::NOTE&, midi::Channel channel) { channels.push_back(channel); });
+
+    CATCH_CHECK(channels == std::vector<midi::Channel>({ midi::Channel(3), midi::Channel(9) }));
+}
+
+TEST_CASE("NoteMerger without notes")
+{
+    CATCH_CHECK(merge(create_file({})).empty());
+    CATCH_CHECK(merge(create_file({ {}, { 0, uint8_t(0xB0), 7, 100 } })).empty());
+}
+
+TEST_CASE("NoteMerger reports parse errors")
+{
+    std::vector<uint8_t> file = create_file({ { 0, uint8_t(0x90), 60, 1, 10, uint8_t(0x80), 60, 0 } });
+    // Running status at the start of the track
+    file[23] = 0x3C;
+
+    CATCH_CHECK_THROWS_AS(merge(file), io::ParseError);
+}
+
+#endif
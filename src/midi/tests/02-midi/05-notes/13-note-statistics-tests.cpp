@@ -0,0 +1,139 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "midi/midi.h"
+#include "midi/note-statistics.h"
+#include "midi/note-table.h"
+#include "Catch.h"
+#include <algorithm>
+#include <vector>
+
+
+namespace
+{
+    midi::NOTE make_note(uint8_t number, uint64_t start, uint64_t duration, uint8_t velocity = 100, uint8_t instrument = 0)
+    {
+        return midi::NOTE(midi::NoteNumber(number), midi::Time(start), midi::Duration(duration), velocity, midi::Instrument(instrument));
+    }
+
+    // Most notes sounding at any tick, by counting at every tick
+    uint64_t count_polyphony(const midi::NoteTable& table)
+    {
+        uint64_t most = 0;
+        for (uint64_t tick = 0; tick <= midi::end_time(table); ++tick)
+        {
+            uint64_t sounding = 0;
+            for (size_t i = 0; i != table.size(); ++i)
+            {
+                sounding += table.start[i] <= tick && tick < table.start[i] + table.duration[i];
+            }
+            most = std::max(most, sounding);
+        }
+        return most;
+    }
+}
+
+
+TEST_CASE("note_statistics without notes")
+{
+    midi::NOTE_STATISTICS statistics = midi::note_statistics(midi::NoteTable());
+
+    CATCH_CHECK(statistics.notes == 0);
+    CATCH_CHECK(statistics.lowest_note == 128);
+    CATCH_CHECK(statistics.highest_note == 0);
+    CATCH_CHECK(statistics.end_time == 0);
+    CATCH_CHECK(statistics.max_polyphony == 0);
+    CATCH_CHECK(statistics.pitches == std::array<uint64_t, 128>());
+}
+
+TEST_CASE("note_statistics of a few notes")
+{
+    midi::NoteTable table;
+    table.push_back(make_note(60, 0, 10, 100, 1), midi::Channel(0));
+    table.push_back(make_note(64, 10, 30, 80, 1), midi::Channel(0));
+    table.push_back(make_note(60, 20, 5, 100, 40), midi::Channel(9));
+    table.push_back(make_note(72, 25, 0, 50, 40), midi::Channel(9));
+    table.push_back(make_note(48, 15, 20, 100, 1), midi::Channel(1));
+    midi::NOTE_STATISTICS statistics = midi::note_statistics(table);
+
+    CATCH_CHECK(statistics.notes == 5);
+    CATCH_CHECK(statistics.pitches[60] == 2);
+    CATCH_CHECK(statistics.pitches[64] == 1);
+    CATCH_CHECK(statistics.pitches[61] == 0);
+    CATCH_CHECK(statistics.velocities[100] == 3);
+    CATCH_CHECK(statistics.velocities[80] == 1);
+    CATCH_CHECK(statistics.instruments[1] == 3);
+    CATCH_CHECK(statistics.instruments[40] == 2);
+    CATCH_CHECK(statistics.channels[0] == 2);
+    CATCH_CHECK(statistics.channels[1] == 1);
+    CATCH_CHECK(statistics.channels[9] == 2);
+    CATCH_CHECK(statistics.lowest_note == 48);
+    CATCH_CHECK(statistics.highest_note == 72);
+    CATCH_CHECK(statistics.end_time == 40);
+    CATCH_CHECK(statistics.shortest == 0);
+    CATCH_CHECK(statistics.longest == 30);
+    CATCH_CHECK(statistics.mean_duration == 13.0);
+    // Durations sorted: 0 5 10 20 30
+    CATCH_CHECK(statistics.duration_percentiles == std::array<uint64_t, 6>({ 0, 5, 10, 20, 30, 30 }));
+    // [10, 40), [15, 35) and [20, 25) overlap at 20
+    CATCH_CHECK(statistics.max_polyphony == 3);
+    CATCH_CHECK(statistics.max_polyphony_time == 20);
+}
+
+TEST_CASE("note_statistics polyphony of notes back to back")
+{
+    midi::NOTE_STATISTICS statistics = midi::note_statistics(std::vector<midi::NOTE>({
+        make_note(60, 0, 10), make_note(61, 10, 10), make_note(62, 20, 10), make_note(63, 20, 0),
+    }));
+
+    CATCH_CHECK(statistics.max_polyphony == 1);
+    CATCH_CHECK(statistics.max_polyphony_time == 0);
+    CATCH_CHECK(statistics.channels[0] == 4);
+}
+
+TEST_CASE("note_statistics agrees with separate passes")
+{
+    uint32_t state = 3;
+    auto next = [&state](uint32_t n) { state = state * 1103515245 + 12345; return (state >> 8) % n; };
+
+    for (size_t count : { 1, 2, 3, 4, 5, 7, 100, 333 })
+    {
+        midi::NoteTable table;
+        for (size_t i = 0; i != count; ++i)
+        {
+            midi::NOTE note = make_note(uint8_t(next(128)), next(500), next(4) == 0 ? 0 : next(60), uint8_t(1 + next(127)), uint8_t(next(128)));
+            table.push_back(note, midi::Channel(next(16)));
+        }
+        midi::NOTE_STATISTICS statistics = midi::note_statistics(table);
+
+        CATCH_CHECK(statistics.notes == count);
+        CATCH_CHECK(statistics.lowest_note == midi::lowest_note(table));
+        CATCH_CHECK(statistics.highest_note == midi::highest_note(table));
+        CATCH_CHECK(statistics.end_time == midi::end_time(table));
+        for (unsigned i = 0; i != 128; ++i)
+        {
+            CATCH_CHECK(statistics.pitches[i] == uint64_t(std::count(table.note_number.begin(), table.note_number.end(), i)));
+            CATCH_CHECK(statistics.velocities[i] == uint64_t(std::count(table.velocity.begin(), table.velocity.end(), i)));
+            CATCH_CHECK(statistics.instruments[i] == uint64_t(std::count(table.instrument.begin(), table.instrument.end(), i)));
+        }
+        for (unsigned i = 0; i != 16; ++i)
+        {
+            CATCH_CHECK(statistics.channels[i] == uint64_t(std::count(table.channel.begin(), table.channel.end(), i)));
+        }
+
+        std::vector<uint64_t> durations = table.duration;
+        std::sort(durations.begin(), durations.end());
+        CATCH_CHECK(statistics.shortest == durations.front());
+        CATCH_CHECK(statistics.longest == durations.back());
+        for (size_t i = 0; i != std::size(midi::DURATION_PERCENTILES); ++i)
+        {
+            size_t rank = std::max<size_t>(1, (midi::DURATION_PERCENTILES[i] * count + 99) / 100);
+            CATCH_CHECK(statistics.duration_percentiles[i] == durations[rank - 1]);
+        }
+
+        CATCH_CHECK(statistics.max_polyphony == count_polyphony(table));
+    }
+}
+
+#endif
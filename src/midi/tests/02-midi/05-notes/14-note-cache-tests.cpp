@@ -0,0 +1,287 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+// Before tests-util.h, whose MTHD macro would clash with the type
+#include "midi/note-cache.h"
+#include "midi/note-table.h"
+#include "midi/tempo-map.h"
+#include "tests/tests-util.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+
+namespace
+{
+    // Two tracks: a tempo change to 1000000 at 192, and notes on channels 0 and 9
+    std::vector<uint8_t> create_file(uint8_t note_number)
+    {
+        const char buffer[] = {
+            MTHD,
+            0x00, 0x00, 0x00, 0x06,
+            0x00, 0x01,
+            0x00, 0x02,
+            0x00, 0x60,
+            MTRK,
+            0x00, 0x00, 0x00, 12,
+            char(0x81), 0x40, char(0xFF), 0x51, 0x03, 0x0F, 0x42, 0x40,
+            END_OF_TRACK,
+            MTRK,
+            0x00, 0x00, 0x00, 24,
+            0, PROGRAM_CHANGE(0, 5),
+            0, NOTE_ON(0, char(note_number), 100),
+            char(0x82), 0x20, NOTE_OFF(0, char(note_number), 0),
+            0, NOTE_ON(9, 36, 90),
+            10, NOTE_OFF(9, 36, 0),
+            END_OF_TRACK
+        };
+        return std::vector<uint8_t>(buffer, buffer + sizeof(buffer));
+    }
+
+    // Empty directory of its own per test case
+    struct TemporaryDirectory
+    {
+        fs::path path;
+
+        explicit TemporaryDirectory(const std::string& name)
+            : path(fs::temp_directory_path() / ("note-cache-tests-" + name))
+        {
+            fs::remove_all(path);
+        }
+
+        ~TemporaryDirectory()
+        {
+            std::error_code error;
+            fs::remove_all(path, error);
+        }
+    };
+
+    fs::path entry_of(const midi::NoteCache& cache, const std::vector<uint8_t>& file)
+    {
+        return cache.entry(midi::content_hash(file.data(), file.size()));
+    }
+}
+
+
+TEST_CASE("content_hash depends on every byte")
+{
+    std::vector<uint8_t> data(100, 7);
+    uint64_t hash = midi::content_hash(data.data(), data.size());
+
+    CATCH_CHECK(midi::content_hash(data.data(), data.size()) == hash);
+    for (size_t i = 0; i != data.size(); ++i)
+    {
+        data[i] ^= 1;
+        CATCH_CHECK(midi::content_hash(data.data(), data.size()) != hash);
+        data[i] ^= 1;
+    }
+    CATCH_CHECK(midi::content_hash(data.data(), 99) != hash);
+    CATCH_CHECK(midi::content_hash(nullptr, 0) != midi::content_hash(data.data(), 1));
+}
+
+TEST_CASE("NoteCache returns what it stored")
+{
+    TemporaryDirectory directory("store");
+    midi::NoteCache cache(directory.path.string());
+    std::vector<uint8_t> file = create_file(60);
+    io::Cursor cursor(file);
+
+    midi::NoteTable notes;
+    midi::TempoMap tempo_map;
+    CATCH_CHECK(!cache.load(cursor, notes, tempo_map));
+
+    io::Cursor in = cursor;
+    midi::read_notes(in, notes, tempo_map);
+    CATCH_REQUIRE(notes.size() == 2);
+    CATCH_CHECK(cache.store(cursor, notes, tempo_map));
+    CATCH_CHECK(fs::exists(entry_of(cache, file)));
+    CATCH_CHECK(cache.size() == fs::file_size(entry_of(cache, file)));
+
+    midi::NoteTable cached;
+    midi::TempoMap cached_tempo_map;
+    CATCH_REQUIRE(cache.load(cursor, cached, cached_tempo_map));
+    CATCH_CHECK(cached.start == notes.start);
+    CATCH_CHECK(cached.duration == notes.duration);
+    CATCH_CHECK(cached.note_number == notes.note_number);
+    CATCH_CHECK(cached.velocity == notes.velocity);
+    CATCH_CHECK(cached.instrument == notes.instrument);
+    CATCH_CHECK(cached.channel == notes.channel);
+    CATCH_CHECK(cached_tempo_map.division() == 96);
+    CATCH_CHECK(cached_tempo_map.size() == 2);
+    CATCH_CHECK(cached_tempo_map.microseconds(midi::Time(288)) == tempo_map.microseconds(midi::Time(288)));
+}
+
+TEST_CASE("NoteCache read_notes parses on a miss only")
+{
+    TemporaryDirectory directory("read");
+    midi::NoteCache cache(directory.path.string());
+    std::vector<uint8_t> file = create_file(60);
+
+    midi::NoteTable expected;
+    midi::TempoMap expected_tempo_map;
+    io::Cursor in(file);
+    midi::read_notes(in, expected, expected_tempo_map);
+
+    for (bool hit : { false, true, true })
+    {
+        midi::NoteTable notes;
+        notes.push_back(midi::NOTE(midi::NoteNumber(1), midi::Time(2), midi::Duration(3), 4, midi::Instrument(5)), midi::Channel(6));
+        midi::TempoMap tempo_map;
+        CATCH_CHECK(cache.read_notes(io::Cursor(file), notes, tempo_map) == hit);
+        CATCH_CHECK(notes.start == expected.start);
+        CATCH_CHECK(notes.note_number == expected.note_number);
+        CATCH_CHECK(notes.channel == expected.channel);
+        CATCH_CHECK(tempo_map.microseconds(midi::Time(1000)) == expected_tempo_map.microseconds(midi::Time(1000)));
+    }
+
+    // A changed file is a different entry
+    std::vector<uint8_t> changed = create_file(61);
+    midi::NoteTable notes;
+    midi::TempoMap tempo_map;
+    CATCH_CHECK(!cache.read_notes(io::Cursor(changed), notes, tempo_map));
+    CATCH_CHECK(notes.note_number[0] == 61);
+}
+
+TEST_CASE("NoteCache keeps the entries of each ChunkMode apart")
+{
+    TemporaryDirectory directory("modes");
+    midi::NoteCache cache(directory.path.string());
+    std::vector<uint8_t> file = create_file(60);
+    midi::NoteTable notes;
+    midi::TempoMap tempo_map;
+
+    CATCH_CHECK(!cache.read_notes(io::Cursor(file), notes, tempo_map, midi::ChunkMode::lenient));
+    CATCH_CHECK(!cache.load(io::Cursor(file), notes, tempo_map, midi::ChunkMode::bounded));
+    CATCH_CHECK(!cache.read_notes(io::Cursor(file), notes, tempo_map, midi::ChunkMode::bounded));
+    CATCH_CHECK(cache.entry(0, midi::ChunkMode::lenient) != cache.entry(0, midi::ChunkMode::bounded));
+
+    CATCH_CHECK(cache.load(io::Cursor(file), notes, tempo_map, midi::ChunkMode::lenient));
+    CATCH_CHECK(cache.load(io::Cursor(file), notes, tempo_map, midi::ChunkMode::bounded));
+    CATCH_CHECK(notes.size() == 2);
+
+    // An entry renamed to the other mode does not pass for it
+    fs::path bounded = cache.entry(midi::content_hash(file.data(), file.size()), midi::ChunkMode::bounded);
+    fs::remove(bounded);
+    fs::copy_file(entry_of(cache, file), bounded);
+    CATCH_CHECK(!cache.load(io::Cursor(file), notes, tempo_map, midi::ChunkMode::bounded));
+}
+
+TEST_CASE("NoteCache keeps the number of events with the notes")
+{
+    TemporaryDirectory directory("events");
+    midi::NoteCache cache(directory.path.string());
+    std::vector<uint8_t> file = create_file(60);
+    midi::NoteTable notes;
+    midi::TempoMap tempo_map;
+
+    // Set Tempo and two End-of-Track events, a program change and four note events
+    for (bool hit : { false, true })
+    {
+        uint64_t events = 0;
+        CATCH_CHECK(cache.read_notes(io::Cursor(file), notes, tempo_map, midi::ChunkMode::lenient, &events) == hit);
+        CATCH_CHECK(events == 8);
+    }
+
+    uint64_t hash = midi::content_hash(file.data(), file.size());
+    CATCH_CHECK(cache.store(hash, io::Cursor(file), notes, tempo_map, midi::ChunkMode::bounded, 1234));
+    uint64_t events = 0;
+    CATCH_CHECK(cache.load(hash, io::Cursor(file), notes, tempo_map, midi::ChunkMode::bounded, &events));
+    CATCH_CHECK(events == 1234);
+}
+
+TEST_CASE("NoteCache removes damaged entries")
+{
+    TemporaryDirectory directory("damaged");
+    midi::NoteCache cache(directory.path.string());
+    std::vector<uint8_t> file = create_file(60);
+    midi::NoteTable notes;
+    midi::TempoMap tempo_map;
+    cache.read_notes(io::Cursor(file), notes, tempo_map);
+    fs::path entry = entry_of(cache, file);
+
+    fs::resize_file(entry, fs::file_size(entry) - 1);
+    CATCH_CHECK(!cache.load(io::Cursor(file), notes, tempo_map));
+    CATCH_CHECK(notes.empty());
+    CATCH_CHECK(!fs::exists(entry));
+
+    // An entry belonging to other contents
+    cache.read_notes(io::Cursor(file), notes, tempo_map);
+    std::vector<uint8_t> other = create_file(70);
+    fs::copy_file(entry, entry_of(cache, other));
+    CATCH_CHECK(!cache.load(io::Cursor(other), notes, tempo_map));
+    CATCH_CHECK(!fs::exists(entry_of(cache, other)));
+    CATCH_CHECK(cache.load(io::Cursor(file), notes, tempo_map));
+
+    {
+        std::ofstream garbage(entry, std::ofstream::binary | std::ofstream::trunc);
+        garbage << "not a cache entry";
+    }
+    CATCH_CHECK(!cache.load(io::Cursor(file), notes, tempo_map));
+}
+
+TEST_CASE("NoteCache evicts the least recently used entries")
+{
+    TemporaryDirectory directory("evict");
+    std::vector<uint8_t> first = create_file(60), second = create_file(61), third = create_file(62);
+    midi::NoteTable notes;
+    midi::TempoMap tempo_map;
+    uint64_t entry_size;
+    {
+        midi::NoteCache unlimited(directory.path.string());
+        unlimited.read_notes(io::Cursor(first), notes, tempo_map);
+        entry_size = unlimited.size();
+    }
+
+    midi::NoteCache cache(directory.path.string(), 2 * entry_size);
+    cache.read_notes(io::Cursor(second), notes, tempo_map);
+    auto now = fs::file_time_type::clock::now();
+    fs::last_write_time(entry_of(cache, first), now - std::chrono::hours(2));
+    fs::last_write_time(entry_of(cache, second), now - std::chrono::hours(1));
+
+    // Using the first makes the second the least recently used
+    CATCH_CHECK(cache.load(io::Cursor(first), notes, tempo_map));
+    cache.read_notes(io::Cursor(third), notes, tempo_map);
+
+    CATCH_CHECK(fs::exists(entry_of(cache, first)));
+    CATCH_CHECK(!fs::exists(entry_of(cache, second)));
+    CATCH_CHECK(fs::exists(entry_of(cache, third)));
+    CATCH_CHECK(cache.size() == 2 * entry_size);
+
+    // Entries over the limit are not stored at all
+    midi::NoteCache tiny(directory.path.string(), entry_size - 1);
+    CATCH_CHECK(!tiny.store(io::Cursor(second), notes, tempo_map));
+    CATCH_CHECK(fs::exists(entry_of(cache, first)));
+}
+
+TEST_CASE("NoteCache counts the entries already in its directory towards the limit")
+{
+    TemporaryDirectory directory("existing");
+    std::vector<uint8_t> first = create_file(60), second = create_file(61), third = create_file(62);
+    midi::NoteTable notes;
+    midi::TempoMap tempo_map;
+    uint64_t entry_size;
+    {
+        midi::NoteCache unlimited(directory.path.string());
+        unlimited.read_notes(io::Cursor(first), notes, tempo_map);
+        entry_size = unlimited.size();
+        unlimited.read_notes(io::Cursor(second), notes, tempo_map);
+    }
+
+    midi::NoteCache cache(directory.path.string(), 2 * entry_size);
+    uint64_t hash = midi::content_hash(third.data(), third.size());
+    CATCH_CHECK(!cache.load(hash, io::Cursor(third), notes, tempo_map));
+    io::Cursor in(third);
+    notes.clear();
+    midi::read_notes(in, notes, tempo_map);
+    CATCH_CHECK(cache.store(hash, io::Cursor(third), notes, tempo_map));
+
+    CATCH_CHECK(cache.load(io::Cursor(third), notes, tempo_map));
+    CATCH_CHECK(cache.size() == 2 * entry_size);
+}
+
+#endif
@@ -0,0 +1,137 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "tests/tests-util.h"
+#include "io/parse-error.h"
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    // MThd announcing three tracks, an unknown chunk between the first two tracks
+    char buffer[] = {
+        MTHD,
+        0x00, 0x00, 0x00, 0x06, // MThd size
+        0x00, 0x01, // Type
+        0x00, 0x03, // Number of tracks
+        0x00, 0x60, // Division
+        MTRK,
+        0x00, 0x00, 0x00, 12, // MTrk size
+        0, NOTE_ON(0, 5, 127),
+        100, NOTE_OFF(0, 5, 0),
+        END_OF_TRACK,
+        'X', 'Y', 'Z', 'W',
+        0x00, 0x00, 0x00, 0x03, // Unknown chunk size
+        0x01, 0x02, 0x03,
+        MTRK,
+        0x00, 0x00, 0x00, 12, // MTrk size
+        50, NOTE_ON(1, 7, 64),
+        50, NOTE_ON(1, 7, 0),
+        END_OF_TRACK,
+        MTRK,
+        0x00, 0x00, 0x00, 4, // MTrk size
+        END_OF_TRACK,
+        0x00, 0x00 // Padding
+    };
+
+    io::Cursor cursor_over(const char* data, size_t size)
+    {
+        return io::Cursor(reinterpret_cast<const uint8_t*>(data), size);
+    }
+}
+
+
+TEST_CASE("Indexing chunks")
+{
+    io::Cursor file = cursor_over(buffer, sizeof(buffer));
+    midi::CHUNK_INDEX index = midi::index_chunks(file);
+
+    CATCH_CHECK(index.mthd.ntracks == 3);
+    CATCH_CHECK(index.mthd.division == 0x60);
+
+    CATCH_REQUIRE(index.chunks.size() == 4);
+    CATCH_CHECK(index.chunks[0].offset == 14);
+    CATCH_CHECK(index.chunks[0].header.size == 12);
+    CATCH_CHECK(midi::header_id(index.chunks[1].header) == "XYZW");
+    CATCH_CHECK(index.chunks[1].offset == 34);
+    CATCH_CHECK(index.chunks[1].header.size == 3);
+    CATCH_CHECK(index.chunks[2].offset == 45);
+    CATCH_CHECK(index.chunks[3].offset == 65);
+
+    CATCH_REQUIRE(index.tracks.size() == 3);
+    CATCH_CHECK(index.tracks[0].offset == 14);
+    CATCH_CHECK(index.tracks[1].offset == 45);
+    CATCH_CHECK(index.tracks[2].offset == 65);
+    CATCH_CHECK(index.end == sizeof(buffer) - 2);
+
+    // Indexing does not move the cursor
+    CATCH_CHECK(file.offset() == 0);
+}
+
+TEST_CASE("Reading a single track by number")
+{
+    io::Cursor file = cursor_over(buffer, sizeof(buffer));
+    midi::CHUNK_INDEX index = midi::index_chunks(file);
+
+    auto receiver = Builder()
+        .note_on(midi::Duration(50), midi::Channel(1), midi::NoteNumber(7), 64)
+        .note_on(midi::Duration(50), midi::Channel(1), midi::NoteNumber(7), 0)
+        .meta(midi::Duration(0), 0x2F, "")
+        .build();
+    midi::read_track(file, index, 1, *receiver);
+    receiver->check_finished();
+
+    std::vector<midi::NOTE> notes = midi::read_track_notes(file, index, 0);
+    CATCH_REQUIRE(notes.size() == 1);
+    CATCH_CHECK(notes[0] == midi::NOTE(midi::NoteNumber(5), midi::Time(0), midi::Duration(100), 127, midi::Instrument(0)));
+
+    CATCH_CHECK(midi::read_track_notes(file, index, 2).empty());
+}
+
+TEST_CASE("read_notes in bounded mode skips unknown chunks")
+{
+    io::Cursor file = cursor_over(buffer, sizeof(buffer));
+    std::vector<midi::NOTE> notes = midi::read_notes(file, midi::ChunkMode::bounded);
+
+    CATCH_REQUIRE(notes.size() == 2);
+    CATCH_CHECK(notes[0] == midi::NOTE(midi::NoteNumber(5), midi::Time(0), midi::Duration(100), 127, midi::Instrument(0)));
+    CATCH_CHECK(notes[1] == midi::NOTE(midi::NoteNumber(7), midi::Time(50), midi::Duration(50), 64, midi::Instrument(0)));
+    CATCH_CHECK(file.offset() == sizeof(buffer) - 2);
+}
+
+TEST_CASE("Indexing chunks that run past the end of the buffer")
+{
+    io::Cursor file = cursor_over(buffer, 43);
+
+    try
+    {
+        midi::index_chunks(file);
+        CATCH_FAIL("Expected io::ParseError");
+    }
+    catch (const io::ParseError& error)
+    {
+        CATCH_CHECK(error.offset() == 34);
+    }
+}
+
+TEST_CASE("Indexing chunks up to one that runs past the end of the buffer")
+{
+    // Cuts the second track short
+    io::Cursor file = cursor_over(buffer, 60);
+    midi::CHUNK_INDEX index = midi::index_chunks(file, true);
+
+    CATCH_CHECK(index.chunks.size() == 2);
+    CATCH_REQUIRE(index.tracks.size() == 1);
+    CATCH_CHECK(index.tracks[0].offset == 14);
+    CATCH_REQUIRE(index.truncated);
+    CATCH_CHECK(index.truncated->offset == 45);
+    CATCH_CHECK(index.truncated->header.size == 12);
+    CATCH_CHECK(index.end == 45);
+
+    CATCH_CHECK(!midi::index_chunks(cursor_over(buffer, sizeof(buffer)), true).truncated);
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "tests/tests-util.h"
+#include "io/parse-error.h"
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    // Tracks of different lengths, each playing its own note on its own channel
+    std::vector<std::vector<uint8_t>> create_tracks(unsigned ntracks)
+    {
+        std::vector<std::vector<uint8_t>> tracks(ntracks);
+        for (unsigned track = 0; track != ntracks; ++track)
+        {
+            for (unsigned i = 0; i != track + 1; ++i)
+            {
+                uint8_t channel = uint8_t(track % 16);
+                tracks[track].insert(tracks[track].end(), { uint8_t(i), uint8_t(0x90 | channel), uint8_t(track), uint8_t(1 + i) });
+                tracks[track].insert(tracks[track].end(), { uint8_t(track + 1), uint8_t(0x80 | channel), uint8_t(track), 0 });
+            }
+        }
+        return tracks;
+    }
+}
+
+
+TEST_CASE("read_notes_parallel yields the same notes in the same order as read_notes")
+{
+    std::vector<uint8_t> file = create_file(create_tracks(37));
+
+    io::Cursor serial_cursor(file);
+    std::vector<midi::NOTE> expected = midi::read_notes(serial_cursor, midi::ChunkMode::bounded);
+    CATCH_REQUIRE(expected.size() == 37 * 38 / 2);
+
+    for (unsigned nthreads : { 0u, 1u, 2u, 3u, 8u, 64u })
+    {
+        io::Cursor cursor(file);
+        std::vector<midi::NOTE> actual = midi::read_notes_parallel(cursor, nthreads);
+
+        CATCH_CHECK(actual == expected);
+        CATCH_CHECK(cursor.at_end());
+    }
+}
+
+TEST_CASE("read_notes_parallel without tracks")
+{
+    std::vector<uint8_t> file = create_file(create_tracks(0));
+    io::Cursor cursor(file);
+
+    CATCH_CHECK(midi::read_notes_parallel(cursor, 4).empty());
+}
+
+TEST_CASE("read_notes_parallel reports errors in any track")
+{
+    std::vector<uint8_t> file = create_file(create_tracks(12));
+    // Replace End-of-Track of the last track by a text event running past the chunk
+    file[file.size() - 2] = 0x01;
+    file[file.size() - 1] = 0x05;
+
+    io::Cursor cursor(file);
+    CATCH_CHECK_THROWS_AS(midi::read_notes_parallel(cursor, 4), io::ParseError);
+}
+
+#endif
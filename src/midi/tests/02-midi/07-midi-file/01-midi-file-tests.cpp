@@ -0,0 +1,168 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+// Before tests-util.h, whose MTHD macro would clash with the type
+#include "midi/midi-file.h"
+#include "tests/tests-util.h"
+#include "io/parse-error.h"
+#include <sstream>
+#include <string>
+
+using namespace testutils;
+
+
+namespace
+{
+    char buffer[] = {
+        MTHD,
+        0x00, 0x00, 0x00, 0x06, // MThd size
+        0x00, 0x01, // Type
+        0x00, 0x02, // Number of tracks
+        0x00, 0x60, // Division
+        MTRK,
+        0x00, 0x00, 0x00, 22, // MTrk size
+        0, NOTE_ON(0, 60, 100),
+        96, CONTROL_CHANGE(0, 7, 100),
+        char(0x81), 0x00, NOTE_OFF(0, 60, 0),
+        0, char(0xF0), 0x02, 'a', 'b', // Sysex
+        END_OF_TRACK,
+        MTRK,
+        0x00, 0x00, 0x00, 14, // MTrk size
+        10, char(0xFF), 0x03, 0x02, 'h', 'i', // Track name
+        20, PITCH_WHEEL_CHANGE(2, 1000),
+        END_OF_TRACK
+    };
+
+    io::Cursor cursor_over_buffer()
+    {
+        return io::Cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+    }
+
+    std::string to_string(io::ByteView view)
+    {
+        return std::string(view.begin(), view.end());
+    }
+}
+
+
+TEST_CASE("Reading a MidiFile")
+{
+    for (midi::ChunkMode mode : { midi::ChunkMode::lenient, midi::ChunkMode::bounded })
+    {
+        io::Cursor cursor = cursor_over_buffer();
+        midi::MidiFile file = midi::read_midi_file(cursor, mode);
+
+        CATCH_CHECK(cursor.at_end());
+        CATCH_CHECK(file.mthd().ntracks == 2);
+        CATCH_CHECK(file.mthd().division == 0x60);
+        CATCH_REQUIRE(file.track_count() == 2);
+        CATCH_CHECK(file.event_count() == 8);
+
+        midi::TrackView first = file.track(0);
+        CATCH_REQUIRE(first.size() == 5);
+        CATCH_CHECK(first[0].time == 0);
+        CATCH_CHECK(first[0].kind == midi::EventKind::note_on);
+        CATCH_CHECK(first[0].data1 == 60);
+        CATCH_CHECK(first[0].data2 == 100);
+        CATCH_CHECK(first[1].time == 96);
+        CATCH_CHECK(first[1].kind == midi::EventKind::control_change);
+        CATCH_CHECK(first[2].time == 224);
+        CATCH_CHECK(first[2].kind == midi::EventKind::note_off);
+        CATCH_CHECK(first[3].kind == midi::EventKind::sysex);
+        CATCH_CHECK(to_string(file.payload(first[3])) == "ab");
+        CATCH_CHECK(first[4].kind == midi::EventKind::meta);
+        CATCH_CHECK(first[4].data1 == 0x2F);
+        CATCH_CHECK(file.payload(first[4]).empty());
+
+        midi::TrackView second = file.track(1);
+        CATCH_REQUIRE(second.size() == 3);
+        CATCH_CHECK(second[0].time == 10);
+        CATCH_CHECK(second[0].data1 == 0x03);
+        CATCH_CHECK(to_string(file.payload(second[0])) == "hi");
+        CATCH_CHECK(second[1].time == 30);
+        CATCH_CHECK(second[1].channel == 2);
+        CATCH_CHECK((second[1].data1 | (second[1].data2 << 7)) == 1000);
+    }
+}
+
+TEST_CASE("Reading a MidiFile from a stream")
+{
+    std::stringstream ss(std::string(buffer, sizeof(buffer)));
+    midi::MidiFile file = midi::read_midi_file(ss);
+
+    CATCH_CHECK(file.track_count() == 2);
+    CATCH_CHECK(file.event_count() == 8);
+}
+
+TEST_CASE("Iterating over the events of a MidiFile track")
+{
+    io::Cursor cursor = cursor_over_buffer();
+    midi::MidiFile file = midi::read_midi_file(cursor);
+
+    std::vector<uint64_t> times;
+    for (const midi::EVENT_RECORD& event : file.track(0))
+    {
+        times.push_back(event.time);
+    }
+
+    CATCH_CHECK(times == std::vector<uint64_t>({ 0, 96, 224, 224, 224 }));
+}
+
+TEST_CASE("Looking up events of a MidiFile track by time")
+{
+    io::Cursor cursor = cursor_over_buffer();
+    midi::MidiFile file = midi::read_midi_file(cursor);
+    midi::TrackView track = file.track(0);
+
+    CATCH_CHECK(track.find(midi::Time(0)) == 0);
+    CATCH_CHECK(track.find(midi::Time(1)) == 1);
+    CATCH_CHECK(track.find(midi::Time(96)) == 1);
+    CATCH_CHECK(track.find(midi::Time(97)) == 2);
+    CATCH_CHECK(track.find(midi::Time(224)) == 2);
+    CATCH_CHECK(track.find(midi::Time(225)) == 5);
+    CATCH_CHECK(track.duration() == midi::Time(224));
+    CATCH_CHECK(file.track(1).duration() == midi::Time(30));
+}
+
+TEST_CASE("Replaying a MidiFile track")
+{
+    io::Cursor cursor = cursor_over_buffer();
+    midi::MidiFile file = midi::read_midi_file(cursor);
+
+    auto first = Builder()
+        .note_on(midi::Duration(0), midi::Channel(0), midi::NoteNumber(60), 100)
+        .control_change(midi::Duration(96), midi::Channel(0), 7, 100)
+        .note_off(midi::Duration(128), midi::Channel(0), midi::NoteNumber(60), 0)
+        .sysex(midi::Duration(0), "ab")
+        .meta(midi::Duration(0), 0x2F, "")
+        .build();
+    file.replay(0, *first);
+    first->check_finished();
+
+    auto second = Builder()
+        .meta(midi::Duration(10), 0x03, "hi")
+        .pitch_wheel_change(midi::Duration(20), midi::Channel(2), 1000)
+        .meta(midi::Duration(0), 0x2F, "")
+        .build();
+    file.replay(1, *second);
+    second->check_finished();
+}
+
+TEST_CASE("MidiFile memory usage")
+{
+    io::Cursor cursor = cursor_over_buffer();
+    midi::MidiFile file = midi::read_midi_file(cursor);
+
+    // Records, track starts, and four payloads with their size prefixes
+    CATCH_CHECK(file.memory_usage() == 8 * sizeof(midi::EVENT_RECORD) + 3 * sizeof(size_t) + 4 * sizeof(uint32_t) + 4);
+}
+
+TEST_CASE("Reading a MidiFile with a truncated track")
+{
+    io::Cursor cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer) - 2);
+
+    CATCH_CHECK_THROWS_AS(midi::read_midi_file(cursor), io::ParseError);
+}
+
+#endif
@@ -0,0 +1,189 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+// Before tests-util.h, whose MTHD macro would clash with the type
+#include "midi/tempo-map.h"
+#include "tests/tests-util.h"
+#include "io/parse-error.h"
+#include <vector>
+
+using namespace testutils;
+
+
+namespace
+{
+    char buffer[] = {
+        MTHD,
+        0x00, 0x00, 0x00, 0x06, // MThd size
+        0x00, 0x01, // Type
+        0x00, 0x02, // Number of tracks
+        0x00, 0x60, // Division
+        MTRK,
+        0x00, 0x00, 0x00, 19, // MTrk size
+        0, char(0xFF), 0x51, 0x03, 0x07, char(0xA1), 0x20, // Set Tempo 500000
+        char(0x81), 0x40, char(0xFF), 0x51, 0x03, 0x0F, 0x42, 0x40, // Set Tempo 1000000 at 192
+        END_OF_TRACK,
+        MTRK,
+        0x00, 0x00, 0x00, 13, // MTrk size
+        0, NOTE_ON(0, 60, 100),
+        char(0x82), 0x20, NOTE_OFF(0, 60, 0),
+        END_OF_TRACK
+    };
+
+    io::Cursor cursor_over_buffer()
+    {
+        return io::Cursor(reinterpret_cast<const uint8_t*>(buffer), sizeof(buffer));
+    }
+}
+
+
+TEST_CASE("TempoMap defaults to 120 BPM")
+{
+    midi::TempoMap tempo_map(96);
+
+    CATCH_CHECK(tempo_map.size() == 1);
+    CATCH_CHECK(tempo_map.microseconds(midi::Time(0)) == 0);
+    CATCH_CHECK(tempo_map.microseconds(midi::Time(96)) == 500000);
+    CATCH_CHECK(tempo_map.microseconds(midi::Time(960)) == 5000000);
+}
+
+TEST_CASE("TempoMap rejects a division of zero ticks")
+{
+    CATCH_CHECK_THROWS_AS(midi::TempoMap(0), std::invalid_argument);
+}
+
+TEST_CASE("TempoMap applies tempo changes from their tick onwards")
+{
+    midi::TempoMap tempo_map(100, { { midi::Time(200), 1000000 }, { midi::Time(100), 250000 } });
+
+    CATCH_CHECK(tempo_map.size() == 3);
+    CATCH_CHECK(tempo_map.microseconds(midi::Time(50)) == 250000);
+    CATCH_CHECK(tempo_map.microseconds(midi::Time(100)) == 500000);
+    CATCH_CHECK(tempo_map.microseconds(midi::Time(150)) == 625000);
+    CATCH_CHECK(tempo_map.microseconds(midi::Time(200)) == 750000);
+    CATCH_CHECK(tempo_map.microseconds(midi::Time(300)) == 1750000);
+}
+
+TEST_CASE("TempoMap keeps the last of simultaneous tempo changes")
+{
+    midi::TempoMap tempo_map(100, { { midi::Time(0), 1000000 }, { midi::Time(0), 2000000 } });
+
+    CATCH_CHECK(tempo_map.size() == 1);
+    CATCH_CHECK(tempo_map.microseconds(midi::Time(100)) == 2000000);
+}
+
+TEST_CASE("TempoMap with SMPTE division")
+{
+    // 25 frames per second, 40 ticks per frame: a millisecond per tick
+    midi::TempoMap tempo_map(uint16_t(0xE728), { { midi::Time(10), 1000000 } });
+
+    CATCH_CHECK(tempo_map.size() == 1);
+    CATCH_CHECK(tempo_map.microseconds(midi::Time(1000)) == 1000000);
+}
+
+TEST_CASE("TempoMap rebuilt from its division and changes")
+{
+    midi::TempoMap tempo_map(480, { { midi::Time(0), 600000 }, { midi::Time(960), 500000 }, { midi::Time(960), 450000 }, { midi::Time(1920), 0 }, { midi::Time(4000), 1234567 } });
+    std::vector<midi::TEMPO_CHANGE> changes = tempo_map.changes();
+
+    CATCH_REQUIRE(changes.size() == 3);
+    CATCH_CHECK(changes[0].time == midi::Time(0));
+    CATCH_CHECK(changes[0].microseconds_per_quarter == 600000);
+    CATCH_CHECK(changes[1].time == midi::Time(960));
+    CATCH_CHECK(changes[1].microseconds_per_quarter == 450000);
+    CATCH_CHECK(changes[2].microseconds_per_quarter == 1234567);
+
+    midi::TempoMap rebuilt(tempo_map.division(), changes);
+    CATCH_CHECK(rebuilt.size() == tempo_map.size());
+    for (uint64_t tick : { 0, 1, 959, 960, 3999, 4000, 100000 })
+    {
+        CATCH_CHECK(rebuilt.microseconds(midi::Time(tick)) == tempo_map.microseconds(midi::Time(tick)));
+    }
+
+    CATCH_CHECK(midi::TempoMap(96).changes().empty());
+    CATCH_CHECK(midi::TempoMap(0xE728, { { midi::Time(10), 100 } }).changes().empty());
+}
+
+TEST_CASE("TempoMap bulk conversion agrees with point lookups")
+{
+    midi::TempoMap tempo_map(96, { { midi::Time(100), 400000 }, { midi::Time(101), 600000 }, { midi::Time(500), 300000 } });
+
+    std::vector<uint64_t> sorted, unsorted;
+    for (uint64_t tick = 0; tick != 1001; ++tick)
+    {
+        sorted.push_back(tick);
+        unsorted.push_back((tick * 379) % 1001);
+    }
+
+    for (const std::vector<uint64_t>& ticks : { sorted, unsorted })
+    {
+        std::vector<double> out(ticks.size());
+        tempo_map.microseconds(ticks.data(), out.data(), ticks.size());
+
+        for (size_t i = 0; i != ticks.size(); ++i)
+        {
+            CATCH_CHECK(out[i] == tempo_map.microseconds(midi::Time(ticks[i])));
+        }
+    }
+}
+
+TEST_CASE("TempoMap converts real time back to ticks")
+{
+    midi::TempoMap tempo_map(100, { { midi::Time(100), 250000 } });
+
+    CATCH_CHECK(tempo_map.time_at(-1) == midi::Time(0));
+    CATCH_CHECK(tempo_map.time_at(0) == midi::Time(0));
+    CATCH_CHECK(tempo_map.time_at(250000) == midi::Time(50));
+    CATCH_CHECK(tempo_map.time_at(500000) == midi::Time(100));
+    CATCH_CHECK(tempo_map.time_at(510000) == midi::Time(104));
+}
+
+TEST_CASE("Reading the tempo map of a file")
+{
+    midi::TempoMap tempo_map = midi::read_tempo_map(cursor_over_buffer());
+
+    CATCH_CHECK(tempo_map.size() == 2);
+    CATCH_CHECK(tempo_map.microseconds(midi::Time(192)) == 1000000);
+    CATCH_CHECK(tempo_map.microseconds(midi::Time(288)) == 2000000);
+}
+
+TEST_CASE("Reading notes with the tempo map")
+{
+    for (midi::ChunkMode mode : { midi::ChunkMode::lenient, midi::ChunkMode::bounded })
+    {
+        io::Cursor cursor = cursor_over_buffer();
+        midi::TempoMap tempo_map;
+        std::vector<midi::NOTE> notes = midi::read_notes(cursor, tempo_map, mode);
+
+        CATCH_CHECK(cursor.at_end());
+        CATCH_REQUIRE(notes.size() == 1);
+        CATCH_CHECK(notes[0].duration == midi::Duration(288));
+
+        std::vector<double> starts, durations;
+        midi::note_times(tempo_map, notes, starts, durations);
+        CATCH_REQUIRE(starts.size() == 1);
+        CATCH_CHECK(starts[0] == 0);
+        CATCH_CHECK(durations[0] == 2000000);
+    }
+}
+
+TEST_CASE("Reading notes with the tempo map rejects a zero division")
+{
+    char data[] = {
+        MTHD,
+        0x00, 0x00, 0x00, 0x06, // MThd size
+        0x00, 0x00, // Type
+        0x00, 0x01, // Number of tracks
+        0x00, 0x00, // Division
+        MTRK,
+        0x00, 0x00, 0x00, 4, // MTrk size
+        END_OF_TRACK
+    };
+    io::Cursor cursor(reinterpret_cast<const uint8_t*>(data), sizeof(data));
+    midi::TempoMap tempo_map;
+
+    CATCH_CHECK_THROWS_AS(midi::read_notes(cursor, tempo_map), io::ParseError);
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifdef TEST_BUILD
+#define CATCH_CONFIG_PREFIX_ALL
+#define TEST_CASE CATCH_TEST_CASE
+
+#include "util/work-stealing-pool.h"
+#include "util/parallel.h"
+#include "Catch.h"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+
+TEST_CASE("Work stealing pool runs every task once")
+{
+    for (unsigned nthreads : { 1u, 2u, 5u })
+    {
+        std::vector<std::atomic<int>> counts(1000);
+        WorkStealingPool pool(nthreads);
+
+        for (size_t i = 0; i != counts.size(); ++i)
+        {
+            pool.submit([&counts, i]() { ++counts[i]; });
+        }
+        pool.wait();
+
+        for (auto& count : counts)
+        {
+            CATCH_CHECK(count == 1);
+        }
+    }
+}
+
+TEST_CASE("Work stealing pool runs tasks submitted by tasks")
+{
+    std::atomic<int> leaves(0);
+    WorkStealingPool pool(3);
+
+    for (int i = 0; i != 10; ++i)
+    {
+        pool.submit([&pool, &leaves]() {
+            for (int j = 0; j != 10; ++j)
+            {
+                pool.submit([&leaves]() { ++leaves; });
+            }
+        });
+    }
+    pool.wait();
+
+    CATCH_CHECK(leaves == 100);
+}
+
+TEST_CASE("Work stealing pool rethrows task exceptions on wait")
+{
+    std::atomic<int> done(0);
+    WorkStealingPool pool(2);
+
+    pool.submit([]() { throw std::runtime_error("failed"); });
+    for (int i = 0; i != 10; ++i)
+    {
+        pool.submit([&done]() { ++done; });
+    }
+
+    CATCH_CHECK_THROWS_AS(pool.wait(), std::runtime_error);
+    CATCH_CHECK(done == 10);
+
+    // The pool stays usable
+    pool.submit([&done]() { ++done; });
+    CATCH_CHECK_NOTHROW(pool.wait());
+    CATCH_CHECK(done == 11);
+}
+
+TEST_CASE("parallel_for visits every index once")
+{
+    for (unsigned nthreads : { 0u, 1u, 4u })
+    {
+        std::vector<std::atomic<int>> counts(97);
+        parallel_for(counts.size(), nthreads, [&counts](size_t i) { ++counts[i]; });
+
+        for (auto& count : counts)
+        {
+            CATCH_CHECK(count == 1);
+        }
+    }
+}
+
+#endif
@@ -37,6 +37,42 @@
 
 namespace testutils
 {
+    inline void append_big_endian(std::vector<uint8_t>& buffer, uint32_t value, int nbytes)
+    {
+        for (int i = nbytes - 1; i >= 0; --i)
+        {
+            buffer.push_back(uint8_t(value >> (8 * i)));
+        }
+    }
+
+    inline void append_vli(std::vector<uint8_t>& buffer, uint32_t value)
+    {
+        std::vector<uint8_t> bytes = { uint8_t(value & 0x7F) };
+        while (value >>= 7)
+        {
+            bytes.push_back(uint8_t(0x80 | (value & 0x7F)));
+        }
+        buffer.insert(buffer.end(), bytes.rbegin(), bytes.rend());
+    }
+
+    // Format 1 file at 96 ticks per quarter note with one MTrk per element of tracks, End-of-Track is appended to each
+    inline std::vector<uint8_t> create_file(const std::vector<std::vector<uint8_t>>& tracks)
+    {
+        std::vector<uint8_t> file = { MTHD, 0, 0, 0, 6, 0, 1 };
+        append_big_endian(file, uint32_t(tracks.size()), 2);
+        append_big_endian(file, 96, 2);
+
+        for (const std::vector<uint8_t>& events : tracks)
+        {
+            file.insert(file.end(), { MTRK });
+            append_big_endian(file, uint32_t(events.size() + 4), 4);
+            file.insert(file.end(), events.begin(), events.end());
+            file.insert(file.end(), { 0x00, 0xFF, 0x2F, 0x00 });
+        }
+
+        return file;
+    }
+
     struct Event
     {
         midi::Duration dt;
@@ -0,0 +1,88 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+inline unsigned default_thread_count()
+{
+    unsigned n = std::thread::hardware_concurrency();
+
+    return n == 0 ? 1 : n;
+}
+
+// Calls body(i) for every i in [0, n) on up to nthreads threads (the calling thread included).
+// Indices are handed out one at a time, so uneven work items balance out.
+// The first exception thrown by body, or by starting a thread, is rethrown once all threads have finished.
+template<typename BODY>
+void parallel_for(size_t n, unsigned nthreads, BODY body)
+{
+    size_t nworkers = std::min<size_t>(std::max(nthreads, 1u), n);
+
+    if (nworkers <= 1)
+    {
+        for (size_t i = 0; i != n; ++i)
+        {
+            body(i);
+        }
+
+        return;
+    }
+
+    std::atomic<size_t> next(0);
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto work = [&]()
+    {
+        size_t i;
+
+        while ((i = next++) < n)
+        {
+            try
+            {
+                body(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+
+                if (!error) error = std::current_exception();
+                next = n;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    try
+    {
+        for (size_t t = 1; t != nworkers; ++t)
+        {
+            threads.emplace_back(work);
+        }
+    }
+    catch (...)
+    {
+        // Recorded like a failing body, so the threads already started are still joined
+        std::lock_guard<std::mutex> lock(error_mutex);
+
+        if (!error) error = std::current_exception();
+        next = n;
+    }
+    work();
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (error) std::rethrow_exception(error);
+}
+
+#endif
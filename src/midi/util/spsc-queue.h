@@ -0,0 +1,136 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+// Bounded lock-free ring buffer between exactly one producer thread
+// and exactly one consumer thread.
+// The capacity is rounded up to a power of two.
+// push and pop spin briefly while the queue is full or empty, then sleep
+// until the other side makes room or adds an item, so an idle side costs no CPU.
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity)
+        : m_head(0), m_tail(0), m_producer_waiting(false), m_consumer_waiting(false)
+    {
+        size_t size = 1;
+        while (size < capacity) size *= 2;
+
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator =(const SpscQueue&) = delete;
+
+    size_t capacity() const
+    {
+        return m_slots.size();
+    }
+
+    // Producer only. Fails if the queue is full, leaving item untouched.
+    bool try_push(T& item)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_slots.size()) return false;
+
+        m_slots[tail & m_mask] = std::move(item);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Fails if the queue is empty.
+    bool try_pop(T& item)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return false;
+
+        item = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer only. Waits while the queue is full.
+    void push(T item)
+    {
+        if (!spin([&]() { return try_push(item); }))
+        {
+            wait(m_producer_waiting, m_not_full, [&]() { return try_push(item); });
+        }
+        wake(m_consumer_waiting, m_not_empty);
+    }
+
+    // Consumer only. Waits while the queue is empty.
+    T pop()
+    {
+        T item;
+        if (!spin([&]() { return try_pop(item); }))
+        {
+            wait(m_consumer_waiting, m_not_empty, [&]() { return try_pop(item); });
+        }
+        wake(m_producer_waiting, m_not_full);
+        return item;
+    }
+
+private:
+    // Attempts before a waiting side goes to sleep
+    static constexpr int SPINS = 64;
+
+    template<typename ATTEMPT>
+    static bool spin(ATTEMPT attempt)
+    {
+        for (int i = 0; i != SPINS; ++i)
+        {
+            if (attempt()) return true;
+            std::this_thread::yield();
+        }
+        return false;
+    }
+
+    // The flag is raised under the mutex before the last attempt, and wake checks it
+    // after publishing its change, so either the attempt sees the change or wake sees the flag
+    template<typename ATTEMPT>
+    void wait(std::atomic<bool>& waiting, std::condition_variable& condition, ATTEMPT attempt)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        waiting.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        condition.wait(lock, attempt);
+        waiting.store(false, std::memory_order_relaxed);
+    }
+
+    void wake(std::atomic<bool>& waiting, std::condition_variable& condition)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            condition.notify_one();
+        }
+    }
+
+    std::vector<T> m_slots;
+    size_t m_mask;
+
+    // Producer and consumer positions on separate cache lines
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+
+    // Only used once a side has stopped spinning
+    alignas(64) std::mutex m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+    std::atomic<bool> m_producer_waiting;
+    std::atomic<bool> m_consumer_waiting;
+};
+
+#endif
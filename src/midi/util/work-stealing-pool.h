@@ -0,0 +1,213 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Fixed set of worker threads, each with its own task queue.
+// A worker takes its newest task first and, once its own queue is empty,
+// steals the oldest task of another worker, so uneven tasks balance out.
+// Tasks submitted from inside a task go to the submitting worker's queue.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(unsigned nthreads)
+        : m_queued(0), m_pending(0), m_next_queue(0), m_stop(false)
+    {
+        if (nthreads == 0) nthreads = 1;
+
+        for (unsigned i = 0; i != nthreads; ++i)
+        {
+            m_queues.push_back(std::make_unique<Queue>());
+        }
+
+        try
+        {
+            for (unsigned i = 0; i != nthreads; ++i)
+            {
+                m_threads.emplace_back([this, i]() { work(i); });
+            }
+        }
+        catch (...)
+        {
+            // The destructor does not run for a failed constructor, and joinable threads would terminate the program
+            stop();
+            throw;
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator =(const WorkStealingPool&) = delete;
+
+    ~WorkStealingPool()
+    {
+        stop();
+    }
+
+    unsigned size() const
+    {
+        return unsigned(m_threads.size());
+    }
+
+    void submit(std::function<void()> task)
+    {
+        size_t index = current_worker() == this ? current_index() : m_next_queue++ % m_queues.size();
+        Queue& queue = *m_queues[index];
+
+        ++m_pending;
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_queued;
+        }
+        m_work_available.notify_one();
+    }
+
+    // Blocks until every submitted task has finished.
+    // Rethrows the first exception a task threw since the previous wait.
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_all_done.wait(lock, [this]() { return m_pending == 0; });
+
+        if (m_error)
+        {
+            std::exception_ptr error = m_error;
+            m_error = nullptr;
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    static WorkStealingPool*& current_worker()
+    {
+        static thread_local WorkStealingPool* pool = nullptr;
+        return pool;
+    }
+
+    static size_t& current_index()
+    {
+        static thread_local size_t index = 0;
+        return index;
+    }
+
+    // Wakes the workers to finish and joins those that were started
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_work_available.notify_all();
+
+        for (std::thread& thread : m_threads)
+        {
+            thread.join();
+        }
+    }
+
+    bool pop_own(size_t index, std::function<void()>& task)
+    {
+        Queue& queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+
+        if (queue.tasks.empty()) return false;
+
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool steal(size_t thief, std::function<void()>& task)
+    {
+        for (size_t offset = 1; offset != m_queues.size(); ++offset)
+        {
+            Queue& queue = *m_queues[(thief + offset) % m_queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+
+            if (!queue.tasks.empty())
+            {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void work(size_t index)
+    {
+        current_worker() = this;
+        current_index() = index;
+
+        while (true)
+        {
+            std::function<void()> task;
+
+            if (pop_own(index, task) || steal(index, task))
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    --m_queued;
+                }
+
+                try
+                {
+                    task();
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    if (!m_error) m_error = std::current_exception();
+                }
+
+                if (--m_pending == 0)
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_all_done.notify_all();
+                }
+            }
+            else
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_work_available.wait(lock, [this]() { return m_stop || m_queued != 0; });
+
+                if (m_stop && m_queued == 0) return;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_work_available;
+    std::condition_variable m_all_done;
+    // Tasks waiting in a queue, guarded by m_mutex
+    size_t m_queued;
+    // Tasks submitted but not yet finished
+    std::atomic<size_t> m_pending;
+    std::atomic<size_t> m_next_queue;
+    bool m_stop;
+    std::exception_ptr m_error;
+};
+
+#endif